@@ -101,6 +101,13 @@ public:
     bool supportsPointerWarping() const {
         return m_pointerWarping;
     }
+    /**
+     * Whether the windowing system the backend runs on already sends repeated key presses.
+     * KWin only repeats keys on its own if it does not.
+     **/
+    bool hasHostKeyRepeat() const {
+        return m_hostKeyRepeat;
+    }
     bool areOutputsEnabled() const {
         return m_outputsEnabled;
     }
@@ -159,6 +166,9 @@ protected:
     void setSupportsPointerWarping(bool set) {
         m_pointerWarping = set;
     }
+    void setHostKeyRepeat(bool set) {
+        m_hostKeyRepeat = set;
+    }
 
 private:
     void triggerCursorRepaint();
@@ -175,6 +185,7 @@ private:
     QSize m_initialWindowSize;
     QByteArray m_deviceIdentifier;
     bool m_pointerWarping = false;
+    bool m_hostKeyRepeat = false;
     bool m_outputsEnabled = true;
     int m_initialOutputCount = 1;
 };
@@ -29,6 +29,8 @@ AbstractClient::AbstractClient(QObject *parent)
     , m_fullscreen(false)
     , m_hiddenInternal(false)
     , m_keepBelow(false)
+    , m_minimized(false)
+    , m_desktop(1)
     , m_geometry()
 {
 }
@@ -103,4 +105,63 @@ void AbstractClient::setKeepBelow(bool keepBelow)
     emit keepBelowChanged();
 }
 
+bool AbstractClient::wantsTabFocus() const
+{
+    return true;
+}
+
+bool AbstractClient::isShown(bool shaded_is_shown) const
+{
+    Q_UNUSED(shaded_is_shown)
+    return !m_minimized && !m_hiddenInternal;
+}
+
+bool AbstractClient::isMinimized() const
+{
+    return m_minimized;
+}
+
+void AbstractClient::setMinimized(bool set)
+{
+    m_minimized = set;
+}
+
+int AbstractClient::desktop() const
+{
+    return m_desktop;
+}
+
+void AbstractClient::setDesktop(int desktop)
+{
+    m_desktop = desktop;
+}
+
+bool AbstractClient::isOnAllDesktops() const
+{
+    // NET::OnAllDesktops
+    return m_desktop == -1;
+}
+
+bool AbstractClient::isOnDesktop(int d) const
+{
+    return m_desktop == d || isOnAllDesktops();
+}
+
+bool AbstractClient::isOnCurrentDesktop() const
+{
+    // TODO: mock the current desktop
+    return isOnDesktop(1);
+}
+
+bool AbstractClient::isOnCurrentActivity() const
+{
+    return true;
+}
+
+bool AbstractClient::belongToSameApplication(const AbstractClient *c1, const AbstractClient *c2, bool active_hack)
+{
+    Q_UNUSED(active_hack)
+    return c1 == c2;
+}
+
 }
@@ -40,6 +40,15 @@ public:
     bool isHiddenInternal() const;
     QRect geometry() const;
     bool keepBelow() const;
+    bool wantsTabFocus() const;
+    bool isShown(bool shaded_is_shown) const;
+    bool isMinimized() const;
+    int desktop() const;
+    bool isOnDesktop(int d) const;
+    bool isOnAllDesktops() const;
+    bool isOnCurrentDesktop() const;
+    bool isOnCurrentActivity() const;
+    static bool belongToSameApplication(const AbstractClient* c1, const AbstractClient* c2, bool active_hack = false);
 
     void setActive(bool active);
     void setScreen(int screen);
@@ -47,6 +56,8 @@ public:
     void setHiddenInternal(bool set);
     void setGeometry(const QRect &rect);
     void setKeepBelow(bool);
+    void setMinimized(bool set);
+    void setDesktop(int desktop);
 
 Q_SIGNALS:
     void geometryChanged();
@@ -58,6 +69,8 @@ private:
     bool m_fullscreen;
     bool m_hiddenInternal;
     bool m_keepBelow;
+    bool m_minimized;
+    int m_desktop;
     QRect m_geometry;
 };
 
@@ -0,0 +1,271 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "mock_abstract_client.h"
+#include "../focuschain.h"
+
+#include <QtTest/QtTest>
+
+using namespace KWin;
+
+class TestFocusChain : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+    void testMakeFirst();
+    void testMakeLast();
+    void testUpdateInsertsBehindActive();
+    void testMinimized();
+    void testDesktops();
+    void testResize();
+    void testMoveAfterClient();
+    void testStress_data();
+    void testStress();
+
+private:
+    QList<AbstractClient*> createClients(int count);
+    QList<AbstractClient*> mostRecentlyUsed() const;
+};
+
+void TestFocusChain::init()
+{
+    FocusChain::create(this);
+    FocusChain::self()->resize(0, 4);
+    FocusChain::self()->setCurrentDesktop(0, 1);
+}
+
+void TestFocusChain::cleanup()
+{
+    delete FocusChain::self();
+}
+
+QList<AbstractClient*> TestFocusChain::createClients(int count)
+{
+    QList<AbstractClient*> clients;
+    for (int i = 0; i < count; ++i) {
+        clients << new AbstractClient(FocusChain::self());
+    }
+    return clients;
+}
+
+QList<AbstractClient*> TestFocusChain::mostRecentlyUsed() const
+{
+    // walks the chain from the most recently used Client
+    QList<AbstractClient*> clients;
+    AbstractClient *first = FocusChain::self()->firstMostRecentlyUsed();
+    if (!first) {
+        return clients;
+    }
+    AbstractClient *c = FocusChain::self()->nextMostRecentlyUsed(first);
+    do {
+        clients << c;
+        c = FocusChain::self()->nextMostRecentlyUsed(c);
+    } while (c != FocusChain::self()->nextMostRecentlyUsed(first));
+    return clients;
+}
+
+void TestFocusChain::testMakeFirst()
+{
+    FocusChain *chain = FocusChain::self();
+    const auto clients = createClients(3);
+    for (AbstractClient *c : clients) {
+        chain->update(c, FocusChain::MakeFirst);
+    }
+    QCOMPARE(mostRecentlyUsed(), QList<AbstractClient*>() << clients[2] << clients[1] << clients[0]);
+    QCOMPARE(chain->firstMostRecentlyUsed(), clients[0]);
+    QCOMPARE(chain->getForActivation(1, 0), clients[2]);
+
+    chain->update(clients[0], FocusChain::MakeFirst);
+    QCOMPARE(mostRecentlyUsed(), QList<AbstractClient*>() << clients[0] << clients[2] << clients[1]);
+    QCOMPARE(chain->getForActivation(1, 0), clients[0]);
+    QCOMPARE(chain->nextForDesktop(clients[0], 1), clients[2]);
+
+    chain->remove(clients[2]);
+    QVERIFY(!chain->contains(clients[2]));
+    QVERIFY(!chain->contains(clients[2], 1));
+    QCOMPARE(mostRecentlyUsed(), QList<AbstractClient*>() << clients[0] << clients[1]);
+    // unknown Clients start at the first one
+    QCOMPARE(chain->nextMostRecentlyUsed(clients[2]), clients[1]);
+}
+
+void TestFocusChain::testMakeLast()
+{
+    FocusChain *chain = FocusChain::self();
+    const auto clients = createClients(3);
+    for (AbstractClient *c : clients) {
+        chain->update(c, FocusChain::MakeFirst);
+    }
+    chain->update(clients[2], FocusChain::MakeLast);
+    QCOMPARE(mostRecentlyUsed(), QList<AbstractClient*>() << clients[1] << clients[0] << clients[2]);
+    QCOMPARE(chain->firstMostRecentlyUsed(), clients[2]);
+    QCOMPARE(chain->getForActivation(1, 0), clients[1]);
+}
+
+void TestFocusChain::testUpdateInsertsBehindActive()
+{
+    FocusChain *chain = FocusChain::self();
+    const auto clients = createClients(3);
+    chain->update(clients[0], FocusChain::MakeFirst);
+    chain->update(clients[1], FocusChain::MakeFirst);
+    chain->setActiveClient(clients[1]);
+    // a new Client goes directly behind the active one
+    chain->update(clients[2], FocusChain::Update);
+    QCOMPARE(mostRecentlyUsed(), QList<AbstractClient*>() << clients[1] << clients[2] << clients[0]);
+    // updating again does not move it
+    chain->update(clients[2], FocusChain::Update);
+    QCOMPARE(mostRecentlyUsed(), QList<AbstractClient*>() << clients[1] << clients[2] << clients[0]);
+    chain->setActiveClient(nullptr);
+}
+
+void TestFocusChain::testMinimized()
+{
+    FocusChain *chain = FocusChain::self();
+    const auto clients = createClients(3);
+    for (AbstractClient *c : clients) {
+        chain->update(c, FocusChain::MakeFirst);
+    }
+    clients[0]->setMinimized(true);
+    chain->update(clients[0], FocusChain::MakeFirstMinimized);
+    // no other minimized Client, so it becomes the last
+    QCOMPARE(mostRecentlyUsed(), QList<AbstractClient*>() << clients[2] << clients[1] << clients[0]);
+    clients[1]->setMinimized(true);
+    chain->update(clients[1], FocusChain::MakeFirstMinimized);
+    // in front of the other minimized Client, but behind all others
+    QCOMPARE(mostRecentlyUsed(), QList<AbstractClient*>() << clients[2] << clients[1] << clients[0]);
+    QCOMPARE(chain->getForActivation(1, 0), clients[2]);
+    chain->remove(clients[2]);
+    QCOMPARE(chain->getForActivation(1, 0), static_cast<AbstractClient*>(nullptr));
+}
+
+void TestFocusChain::testDesktops()
+{
+    FocusChain *chain = FocusChain::self();
+    const auto clients = createClients(2);
+    clients[0]->setDesktop(2);
+    chain->update(clients[0], FocusChain::MakeFirst);
+    QVERIFY(chain->contains(clients[0]));
+    QVERIFY(!chain->contains(clients[0], 1));
+    QVERIFY(chain->contains(clients[0], 2));
+    QVERIFY(!chain->contains(clients[0], 3));
+    QCOMPARE(chain->getForActivation(2, 0), clients[0]);
+    QCOMPARE(chain->getForActivation(1, 0), static_cast<AbstractClient*>(nullptr));
+    QCOMPARE(chain->getForActivation(5, 0), static_cast<AbstractClient*>(nullptr));
+
+    // on all desktops
+    chain->setActiveClient(clients[0]);
+    clients[1]->setDesktop(-1);
+    chain->update(clients[1], FocusChain::MakeFirst);
+    for (uint i = 1; i <= 4; ++i) {
+        QVERIFY(chain->contains(clients[1], i));
+    }
+    // MakeFirst only affects the current desktop, on the others it goes behind the active Client
+    QCOMPARE(chain->getForActivation(1, 0), clients[1]);
+    QCOMPARE(chain->getForActivation(2, 0), clients[0]);
+    chain->setActiveClient(nullptr);
+
+    // move to another desktop
+    clients[0]->setDesktop(3);
+    chain->update(clients[0], FocusChain::Update);
+    QVERIFY(!chain->contains(clients[0], 2));
+    QVERIFY(chain->contains(clients[0], 3));
+
+    chain->remove(clients[1]);
+    for (uint i = 1; i <= 4; ++i) {
+        QVERIFY(!chain->contains(clients[1], i));
+    }
+}
+
+void TestFocusChain::testResize()
+{
+    FocusChain *chain = FocusChain::self();
+    const auto clients = createClients(1);
+    clients[0]->setDesktop(-1);
+    chain->update(clients[0], FocusChain::MakeFirst);
+    QVERIFY(chain->contains(clients[0], 4));
+    chain->resize(4, 2);
+    QVERIFY(chain->contains(clients[0], 2));
+    QVERIFY(!chain->contains(clients[0], 3));
+    QVERIFY(!chain->contains(clients[0], 4));
+    chain->resize(2, 3);
+    QVERIFY(!chain->contains(clients[0], 3));
+    chain->update(clients[0], FocusChain::Update);
+    QVERIFY(chain->contains(clients[0], 3));
+}
+
+void TestFocusChain::testMoveAfterClient()
+{
+    FocusChain *chain = FocusChain::self();
+    const auto clients = createClients(3);
+    for (AbstractClient *c : clients) {
+        chain->update(c, FocusChain::MakeFirst);
+    }
+    // the mock considers only the Client itself as the same application
+    chain->moveAfterClient(clients[2], clients[0]);
+    QCOMPARE(mostRecentlyUsed(), QList<AbstractClient*>() << clients[1] << clients[0] << clients[2]);
+    chain->moveAfterClient(clients[0], clients[0]);
+    QCOMPARE(mostRecentlyUsed(), QList<AbstractClient*>() << clients[1] << clients[0] << clients[2]);
+}
+
+void TestFocusChain::testStress_data()
+{
+    QTest::addColumn<int>("clientCount");
+    QTest::addColumn<int>("desktopCount");
+
+    QTest::newRow("50/4") << 50 << 4;
+    QTest::newRow("500/20") << 500 << 20;
+}
+
+void TestFocusChain::testStress()
+{
+    // activates, minimizes, moves and closes windows on many desktops
+    QFETCH(int, clientCount);
+    QFETCH(int, desktopCount);
+    FocusChain *chain = FocusChain::self();
+    chain->resize(4, desktopCount);
+    const auto clients = createClients(clientCount);
+    for (int i = 0; i < clients.count(); ++i) {
+        clients[i]->setDesktop(i % 10 == 0 ? -1 : i % desktopCount + 1);
+        chain->update(clients[i], FocusChain::Update);
+    }
+    QBENCHMARK {
+        for (int i = 0; i < clients.count(); ++i) {
+            AbstractClient *c = clients[(i * 7) % clients.count()];
+            chain->setActiveClient(c);
+            chain->update(c, FocusChain::MakeFirst);
+            chain->getForActivation(c->isOnAllDesktops() ? 1 : c->desktop(), 0);
+            if (i % 5 == 0) {
+                chain->update(c, FocusChain::MakeLast);
+            }
+            if (i % 11 == 0) {
+                chain->remove(c);
+                chain->update(c, FocusChain::Update);
+            }
+        }
+    }
+    QCOMPARE(mostRecentlyUsed().count(), clientCount);
+    for (AbstractClient *c : clients) {
+        QVERIFY(chain->contains(c, c->isOnAllDesktops() ? desktopCount : c->desktop()));
+    }
+    chain->setActiveClient(nullptr);
+}
+
+QTEST_GUILESS_MAIN(TestFocusChain)
+#include "test_focus_chain.moc"
@@ -0,0 +1,106 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../input_latency.h"
+
+#include <QtTest/QtTest>
+
+using namespace KWin;
+
+class TestInputLatency : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void testDisabled();
+    void testRecordEvent();
+    void testIncompleteEvent();
+    void testRingBuffer();
+};
+
+void TestInputLatency::init()
+{
+    InputLatencyTracer::self()->setEnabled(false);
+    InputLatencyTracer::self()->reset();
+}
+
+void TestInputLatency::testDisabled()
+{
+    auto tracer = InputLatencyTracer::self();
+    QVERIFY(!tracer->isEnabled());
+    const qint64 now = InputLatencyTracer::now();
+    tracer->beginEvent(InputLatencyTracer::KeyEvent, now / 1000, now);
+    tracer->mark(InputLatencyTracer::Filter);
+    tracer->mark(InputLatencyTracer::Deliver);
+    tracer->endEvent();
+    QVERIFY(tracer->information().contains(QStringLiteral("Recorded events: 0\n")));
+}
+
+void TestInputLatency::testRecordEvent()
+{
+    auto tracer = InputLatencyTracer::self();
+    tracer->setEnabled(true);
+    const qint64 now = InputLatencyTracer::now();
+    // kernel timestamp 5 ms before it got read
+    tracer->beginEvent(InputLatencyTracer::KeyEvent, now / 1000 - 5000, now);
+    tracer->mark(InputLatencyTracer::Filter);
+    tracer->mark(InputLatencyTracer::Deliver);
+    tracer->endEvent();
+
+    const QString information = tracer->information();
+    QVERIFY(information.contains(QStringLiteral("Enabled: yes\n")));
+    QVERIFY(information.contains(QStringLiteral("Recorded events: 1\n")));
+    QVERIFY(information.contains(QStringLiteral("Keyboard events\n")));
+    QVERIFY(!information.contains(QStringLiteral("Pointer events\n")));
+    QVERIFY(information.contains(QStringLiteral("libinput (kernel to read): 1 samples")));
+    QVERIFY(information.contains(QStringLiteral("total (kernel to seat): 1 samples")));
+    // 5000 us fall into the bucket below 8192 us
+    QVERIFY(information.contains(QStringLiteral("<     8192 us: 1\n")));
+}
+
+void TestInputLatency::testIncompleteEvent()
+{
+    // an event filtered out before reaching the seat is not part of the delivery statistics
+    auto tracer = InputLatencyTracer::self();
+    tracer->setEnabled(true);
+    const qint64 now = InputLatencyTracer::now();
+    tracer->beginEvent(InputLatencyTracer::PointerEvent, now / 1000, now);
+    tracer->mark(InputLatencyTracer::Filter);
+    tracer->endEvent();
+
+    const QString information = tracer->information();
+    QVERIFY(information.contains(QStringLiteral("Pointer events\n")));
+    QVERIFY(information.contains(QStringLiteral("processing (dispatch to done): 1 samples")));
+    QVERIFY(!information.contains(QStringLiteral("total (kernel to seat)")));
+}
+
+void TestInputLatency::testRingBuffer()
+{
+    auto tracer = InputLatencyTracer::self();
+    tracer->setEnabled(true);
+    for (int i = 0; i < 5000; ++i) {
+        const qint64 now = InputLatencyTracer::now();
+        tracer->beginEvent(InputLatencyTracer::TouchEvent, now / 1000, now);
+        tracer->endEvent();
+    }
+    QVERIFY(tracer->information().contains(QStringLiteral("Recorded events: 4096\n")));
+}
+
+QTEST_GUILESS_MAIN(TestInputLatency)
+#include "test_input_latency.moc"
@@ -0,0 +1,249 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "abstract_backend.h"
+#include "composite.h"
+#include "effects.h"
+#include "scene.h"
+#include "shell_client.h"
+#include "virtualdesktops.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <KWayland/Client/compositor.h>
+#include <KWayland/Client/connection_thread.h>
+#include <KWayland/Client/event_queue.h>
+#include <KWayland/Client/registry.h>
+#include <KWayland/Client/shell.h>
+#include <KWayland/Client/shm_pool.h>
+#include <KWayland/Client/surface.h>
+
+#include <QRegularExpression>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_concurrent_prepaint-0");
+
+class ConcurrentPrePaintTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testIdleFramesAreSequential();
+    void testMinimizeAnimation();
+    void testNotOptedInEffect();
+
+private:
+    void render(KWayland::Client::Surface *surface);
+    void paintFrames();
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::ShmPool *m_shm = nullptr;
+    KWayland::Client::Shell *m_shell = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    QThread *m_thread = nullptr;
+    QList<KWayland::Client::Surface*> m_surfaces;
+    QList<ShellClient*> m_clients;
+};
+
+static EffectsHandlerImpl *effectsImpl()
+{
+    return static_cast<EffectsHandlerImpl*>(effects);
+}
+
+static quint64 concurrentPasses()
+{
+    // the counter of the scene is only exposed through the support information
+    static const QRegularExpression regExp(QStringLiteral("Concurrent effect pre-paint passes: (\\d+)"));
+    const auto match = regExp.match(Compositor::self()->scene()->supportInformation());
+    return match.hasMatch() ? match.captured(1).toULongLong() : 0;
+}
+
+void ConcurrentPrePaintTest::initTestCase()
+{
+    qRegisterMetaType<KWin::ShellClient*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    waylandServer()->backend()->setInitialWindowSize(QSize(1280, 1024));
+    waylandServer()->init(s_socketName.toLocal8Bit());
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QTRY_VERIFY(effects);
+
+    // only the effects under test
+    effectsImpl()->unloadAllEffects();
+    QVERIFY(effectsImpl()->loadEffect(QStringLiteral("minimizeanimation")));
+    QVERIFY(effectsImpl()->loadEffect(QStringLiteral("slide")));
+    VirtualDesktopManager::self()->setCount(2);
+}
+
+void ConcurrentPrePaintTest::init()
+{
+    using namespace KWayland::Client;
+    // setup connection
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    QVERIFY(!m_queue->isValid());
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    Registry registry;
+    registry.setEventQueue(m_queue);
+    QSignalSpy compositorSpy(&registry, &Registry::compositorAnnounced);
+    QSignalSpy shmSpy(&registry, &Registry::shmAnnounced);
+    QSignalSpy shellSpy(&registry, &Registry::shellAnnounced);
+    QSignalSpy allAnnounced(&registry, &Registry::interfacesAnnounced);
+    QVERIFY(allAnnounced.isValid());
+    QVERIFY(shmSpy.isValid());
+    QVERIFY(shellSpy.isValid());
+    QVERIFY(compositorSpy.isValid());
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    QVERIFY(allAnnounced.wait());
+    QVERIFY(!compositorSpy.isEmpty());
+    QVERIFY(!shmSpy.isEmpty());
+    QVERIFY(!shellSpy.isEmpty());
+
+    m_compositor = registry.createCompositor(compositorSpy.first().first().value<quint32>(), compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_compositor->isValid());
+    m_shm = registry.createShmPool(shmSpy.first().first().value<quint32>(), shmSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_shm->isValid());
+    m_shell = registry.createShell(shellSpy.first().first().value<quint32>(), shellSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_shell->isValid());
+
+    // enough windows for the scene to distribute the effect chain over threads
+    QSignalSpy clientAddedSpy(waylandServer(), &WaylandServer::shellClientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+    for (int i = 0; i < 6; ++i) {
+        Surface *surface = m_compositor->createSurface(m_compositor);
+        QVERIFY(surface);
+        ShellSurface *shellSurface = m_shell->createSurface(surface, surface);
+        QVERIFY(shellSurface);
+        render(surface);
+        QVERIFY(clientAddedSpy.wait());
+        m_surfaces << surface;
+        m_clients << clientAddedSpy.last().first().value<ShellClient*>();
+    }
+    VirtualDesktopManager::self()->setCurrent(1);
+    QTRY_VERIFY(!effectsImpl()->hasActiveEffects());
+}
+
+void ConcurrentPrePaintTest::cleanup()
+{
+    m_clients.clear();
+    m_surfaces.clear();
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_shm;
+    m_shm = nullptr;
+    delete m_shell;
+    m_shell = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_connection->deleteLater();
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+        m_connection = nullptr;
+    }
+}
+
+void ConcurrentPrePaintTest::render(KWayland::Client::Surface *surface)
+{
+    QImage img(QSize(100, 50), QImage::Format_ARGB32);
+    img.fill(Qt::blue);
+    surface->attachBuffer(m_shm->createBuffer(img));
+    surface->damage(QRect(0, 0, 100, 50));
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    m_connection->flush();
+}
+
+void ConcurrentPrePaintTest::paintFrames()
+{
+    // the second frame only starts once the first one is done
+    QSignalSpy aboutToCompositeSpy(Compositor::self(), &Compositor::aboutToComposite);
+    QVERIFY(aboutToCompositeSpy.isValid());
+    for (int i = 0; i < 2; ++i) {
+        Compositor::self()->addRepaintFull();
+        QVERIFY(aboutToCompositeSpy.wait());
+    }
+}
+
+void ConcurrentPrePaintTest::testIdleFramesAreSequential()
+{
+    // without active effects there is nothing to distribute over threads
+    const quint64 passes = concurrentPasses();
+    paintFrames();
+    QVERIFY(!effectsImpl()->hasActiveEffects());
+    QVERIFY(!effectsImpl()->isPrePaintWindowThreadSafe());
+    QCOMPARE(concurrentPasses(), passes);
+}
+
+void ConcurrentPrePaintTest::testMinimizeAnimation()
+{
+    // the minimize animation opted in, so its frames run the effect chain concurrently
+    const quint64 passes = concurrentPasses();
+    ShellClient *c = m_clients.first();
+    QVERIFY(c->isMinimizable());
+    c->minimize();
+    paintFrames();
+    QVERIFY(concurrentPasses() > passes);
+
+    // and the window is gone once the animation ended
+    QTRY_VERIFY(!effectsImpl()->hasActiveEffects());
+    QTRY_VERIFY(!Compositor::self()->scene()->isWindowVisibleInLastFrame(c));
+    c->unminimize();
+    QTRY_VERIFY(!effectsImpl()->hasActiveEffects());
+}
+
+void ConcurrentPrePaintTest::testNotOptedInEffect()
+{
+    // slide changes state shared between windows in prePaintWindow and keeps the sequential pass
+    const quint64 passes = concurrentPasses();
+    VirtualDesktopManager::self()->setCurrent(2);
+    paintFrames();
+    QVERIFY(effectsImpl()->hasActiveEffects());
+    QVERIFY(!effectsImpl()->isPrePaintWindowThreadSafe());
+    QCOMPARE(concurrentPasses(), passes);
+    VirtualDesktopManager::self()->setCurrent(1);
+    QTRY_VERIFY(!effectsImpl()->hasActiveEffects());
+}
+
+}
+
+WAYLANDTEST_MAIN(KWin::ConcurrentPrePaintTest)
+#include "concurrent_prepaint_test.moc"
@@ -0,0 +1,486 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#define WL_EGL_PLATFORM 1
+#include "kwin_wayland_test.h"
+#include "abstract_backend.h"
+#include "backends/drm/drm_backend.h"
+#include "composite.h"
+#include "effects.h"
+#include "scene.h"
+#include "screens.h"
+#include "shell_client.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <KWayland/Client/compositor.h>
+#include <KWayland/Client/connection_thread.h>
+#include <KWayland/Client/event_queue.h>
+#include <KWayland/Client/registry.h>
+#include <KWayland/Client/shell.h>
+#include <KWayland/Client/surface.h>
+#include <KWayland/Server/buffer_interface.h>
+#include <KWayland/Server/surface_interface.h>
+
+#include <QRegularExpression>
+#include <QTimer>
+#include <QtConcurrentRun>
+
+#include <functional>
+
+#include <epoxy/egl.h>
+#include <epoxy/gl.h>
+#include <wayland-egl.h>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_direct_scanout-0");
+
+/**
+ * Renders into a Wayland surface through EGL, so that the compositor gets a buffer it can scan out.
+ *
+ * All EGL calls block on roundtrips to the compositor running in the test's thread,
+ * thus they are performed in a different thread.
+ **/
+class EglClient
+{
+public:
+    ~EglClient();
+    bool init(wl_display *display, wl_surface *surface, const QSize &size);
+    bool render(const QColor &color);
+
+private:
+    bool initInThread(wl_display *display, wl_surface *surface, const QSize &size);
+    bool renderInThread(const QColor &color);
+    EGLDisplay m_display = EGL_NO_DISPLAY;
+    EGLContext m_context = EGL_NO_CONTEXT;
+    EGLSurface m_surface = EGL_NO_SURFACE;
+    wl_egl_window *m_window = nullptr;
+};
+
+static bool runInThread(std::function<bool()> function)
+{
+    QFutureWatcher<bool> watcher;
+    QSignalSpy finishedSpy(&watcher, &QFutureWatcher<bool>::finished);
+    watcher.setFuture(QtConcurrent::run(function));
+    // keep the compositor running while the client waits for it
+    if (!finishedSpy.wait()) {
+        return false;
+    }
+    return watcher.result();
+}
+
+EglClient::~EglClient()
+{
+    if (m_display == EGL_NO_DISPLAY) {
+        return;
+    }
+    runInThread([this] {
+        if (m_surface != EGL_NO_SURFACE) {
+            eglDestroySurface(m_display, m_surface);
+        }
+        if (m_context != EGL_NO_CONTEXT) {
+            eglDestroyContext(m_display, m_context);
+        }
+        eglTerminate(m_display);
+        return true;
+    });
+    if (m_window) {
+        wl_egl_window_destroy(m_window);
+    }
+}
+
+bool EglClient::init(wl_display *display, wl_surface *surface, const QSize &size)
+{
+    return runInThread([this, display, surface, size] {
+        return initInThread(display, surface, size);
+    });
+}
+
+bool EglClient::initInThread(wl_display *display, wl_surface *surface, const QSize &size)
+{
+    m_display = eglGetDisplay(display);
+    if (m_display == EGL_NO_DISPLAY) {
+        return false;
+    }
+    EGLint major, minor;
+    if (eglInitialize(m_display, &major, &minor) == EGL_FALSE) {
+        return false;
+    }
+    if (eglBindAPI(EGL_OPENGL_ES_API) == EGL_FALSE) {
+        return false;
+    }
+    // an opaque buffer, otherwise the window below would have to be composited
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE,    EGL_WINDOW_BIT,
+        EGL_RED_SIZE,        8,
+        EGL_GREEN_SIZE,      8,
+        EGL_BLUE_SIZE,       8,
+        EGL_ALPHA_SIZE,      0,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint count = 0;
+    if (eglChooseConfig(m_display, configAttribs, &config, 1, &count) == EGL_FALSE || count != 1) {
+        return false;
+    }
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 2,
+        EGL_NONE
+    };
+    m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (m_context == EGL_NO_CONTEXT) {
+        return false;
+    }
+    m_window = wl_egl_window_create(surface, size.width(), size.height());
+    m_surface = eglCreateWindowSurface(m_display, config, m_window, nullptr);
+    if (m_surface == EGL_NO_SURFACE) {
+        return false;
+    }
+    if (eglMakeCurrent(m_display, m_surface, m_surface, m_context) == EGL_FALSE) {
+        return false;
+    }
+    // don't wait for frame callbacks, the test triggers each frame itself
+    eglSwapInterval(m_display, 0);
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    return true;
+}
+
+bool EglClient::render(const QColor &color)
+{
+    return runInThread([this, color] {
+        return renderInThread(color);
+    });
+}
+
+bool EglClient::renderInThread(const QColor &color)
+{
+    // the thread pool might use a different thread than for the previous call
+    if (eglMakeCurrent(m_display, m_surface, m_surface, m_context) == EGL_FALSE) {
+        return false;
+    }
+    glClearColor(color.redF(), color.greenF(), color.blueF(), 1.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    const bool swapped = eglSwapBuffers(m_display, m_surface) == EGL_TRUE;
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    return swapped;
+}
+
+class DirectScanoutTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testFullscreenWindow();
+    void testOverlayWindow();
+    void testBufferReleasedAfterPageFlip_data();
+    void testBufferReleasedAfterPageFlip();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::Shell *m_shell = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+static bool isDrmBackend()
+{
+    return qstrcmp(waylandServer()->backend()->metaObject()->className(), "KWin::DrmBackend") == 0;
+}
+
+static quint64 clientBufferCount(const QString &pattern)
+{
+    // the counters of the drm backend are only exposed through the support information
+    const QRegularExpression regExp(QStringLiteral("(\\d+) client buffers %1").arg(pattern));
+    quint64 count = 0;
+    auto it = regExp.globalMatch(Compositor::self()->scene()->supportInformation());
+    while (it.hasNext()) {
+        count += it.next().captured(1).toULongLong();
+    }
+    return count;
+}
+
+static quint64 scannedOutBuffers()
+{
+    return clientBufferCount(QStringLiteral("scanned out"));
+}
+
+static quint64 overlayBuffers()
+{
+    return clientBufferCount(QStringLiteral("shown on the overlay plane"));
+}
+
+void DirectScanoutTest::initTestCase()
+{
+    qRegisterMetaType<KWin::ShellClient*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    waylandServer()->init(s_socketName.toLocal8Bit());
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    if (!isDrmBackend()) {
+        QSKIP("Direct scanout needs a drm device like vkms and a logind session");
+    }
+    QVERIFY(Compositor::self()->scene());
+    QVERIFY(Compositor::self()->scene()->compositingType() & OpenGLCompositing);
+}
+
+void DirectScanoutTest::init()
+{
+    using namespace KWayland::Client;
+    // setup connection
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    QVERIFY(!m_queue->isValid());
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    Registry registry;
+    registry.setEventQueue(m_queue);
+    QSignalSpy compositorSpy(&registry, &Registry::compositorAnnounced);
+    QSignalSpy shellSpy(&registry, &Registry::shellAnnounced);
+    QSignalSpy allAnnounced(&registry, &Registry::interfacesAnnounced);
+    QVERIFY(allAnnounced.isValid());
+    QVERIFY(shellSpy.isValid());
+    QVERIFY(compositorSpy.isValid());
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    QVERIFY(allAnnounced.wait());
+    QVERIFY(!compositorSpy.isEmpty());
+    QVERIFY(!shellSpy.isEmpty());
+
+    m_compositor = registry.createCompositor(compositorSpy.first().first().value<quint32>(), compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_compositor->isValid());
+    m_shell = registry.createShell(shellSpy.first().first().value<quint32>(), shellSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_shell->isValid());
+
+    screens()->setCurrent(0);
+}
+
+void DirectScanoutTest::cleanup()
+{
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_shell;
+    m_shell = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_connection->deleteLater();
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+        m_connection = nullptr;
+    }
+}
+
+void DirectScanoutTest::testFullscreenWindow()
+{
+    // a fullscreen window with an opaque client buffer is presented without compositing
+    using namespace KWayland::Client;
+
+    QSignalSpy clientAddedSpy(waylandServer(), &WaylandServer::shellClientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(!surface.isNull());
+    QScopedPointer<ShellSurface> shellSurface(m_shell->createSurface(surface.data()));
+    QVERIFY(!shellSurface.isNull());
+    shellSurface->setFullscreen();
+
+    const QRect screenGeometry = screens()->geometry(0);
+    EglClient client;
+    QVERIFY(client.init(m_connection->display(), *surface.data(), screenGeometry.size()));
+    QVERIFY(client.render(Qt::blue));
+
+    QVERIFY(clientAddedSpy.wait());
+    ShellClient *c = clientAddedSpy.first().first().value<ShellClient*>();
+    QVERIFY(c);
+    QTRY_COMPARE(c->geometry(), screenGeometry);
+    QVERIFY(!c->hasAlpha());
+    // effects animating the new window force compositing
+    QTRY_VERIFY(!static_cast<EffectsHandlerImpl*>(effects)->hasActiveEffects());
+
+    // every new client buffer gets imported and presented on the primary plane
+    const quint64 scannedOut = scannedOutBuffers();
+    QVERIFY(client.render(Qt::red));
+    QTRY_VERIFY(scannedOutBuffers() > scannedOut);
+    QTRY_VERIFY(Compositor::self()->scene()->isWindowVisibleInLastFrame(c));
+
+    const quint64 scannedOutAgain = scannedOutBuffers();
+    QVERIFY(client.render(Qt::green));
+    QTRY_VERIFY(scannedOutBuffers() > scannedOutAgain);
+}
+
+void DirectScanoutTest::testOverlayWindow()
+{
+    // an opaque window on top of the stacking order is shown on an overlay plane
+    // and the rest of the screen gets composited without it
+    using namespace KWayland::Client;
+    if (!static_cast<DrmBackend*>(waylandServer()->backend())->atomicModeSetting()) {
+        QSKIP("Overlay planes need atomic mode setting");
+    }
+
+    QSignalSpy clientAddedSpy(waylandServer(), &WaylandServer::shellClientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(!surface.isNull());
+    QScopedPointer<ShellSurface> shellSurface(m_shell->createSurface(surface.data()));
+    QVERIFY(!shellSurface.isNull());
+
+    EglClient client;
+    QVERIFY(client.init(m_connection->display(), *surface.data(), QSize(256, 256)));
+    QVERIFY(client.render(Qt::blue));
+
+    QVERIFY(clientAddedSpy.wait());
+    ShellClient *c = clientAddedSpy.first().first().value<ShellClient*>();
+    QVERIFY(c);
+    QCOMPARE(c->geometry().size(), QSize(256, 256));
+    QVERIFY(screens()->geometry(0).contains(c->geometry()));
+    QTRY_VERIFY(!static_cast<EffectsHandlerImpl*>(effects)->hasActiveEffects());
+
+    const quint64 overlays = overlayBuffers();
+    const quint64 scannedOut = scannedOutBuffers();
+    QVERIFY(client.render(Qt::red));
+    QTRY_VERIFY(overlayBuffers() > overlays);
+    QTRY_VERIFY(Compositor::self()->scene()->isWindowVisibleInLastFrame(c));
+    // the window does not cover the screen, so it must not be scanned out
+    QCOMPARE(scannedOutBuffers(), scannedOut);
+
+    const quint64 overlaysAgain = overlayBuffers();
+    QVERIFY(client.render(Qt::green));
+    QTRY_VERIFY(overlayBuffers() > overlaysAgain);
+}
+
+void DirectScanoutTest::testBufferReleasedAfterPageFlip_data()
+{
+    QTest::addColumn<bool>("fullscreen");
+
+    QTest::newRow("scanout") << true;
+    QTest::newRow("overlay") << false;
+}
+
+void DirectScanoutTest::testBufferReleasedAfterPageFlip()
+{
+    // a replaced client buffer is still shown until the page flip to its successor completed,
+    // the client must not get it back through wl_buffer.release before
+    using namespace KWayland::Client;
+    QFETCH(bool, fullscreen);
+    DrmBackend *backend = static_cast<DrmBackend*>(waylandServer()->backend());
+    if (!fullscreen && !backend->atomicModeSetting()) {
+        QSKIP("Overlay planes need atomic mode setting");
+    }
+    DrmOutput *output = backend->outputs().first();
+
+    QSignalSpy clientAddedSpy(waylandServer(), &WaylandServer::shellClientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(!surface.isNull());
+    QScopedPointer<ShellSurface> shellSurface(m_shell->createSurface(surface.data()));
+    QVERIFY(!shellSurface.isNull());
+    if (fullscreen) {
+        shellSurface->setFullscreen();
+    }
+
+    const QSize size = fullscreen ? screens()->geometry(0).size() : QSize(256, 256);
+    EglClient client;
+    QVERIFY(client.init(m_connection->display(), *surface.data(), size));
+    QVERIFY(client.render(Qt::blue));
+
+    QVERIFY(clientAddedSpy.wait());
+    ShellClient *c = clientAddedSpy.first().first().value<ShellClient*>();
+    QVERIFY(c);
+    QTRY_COMPARE(c->geometry().size(), size);
+    QTRY_VERIFY(!static_cast<EffectsHandlerImpl*>(effects)->hasActiveEffects());
+
+    auto presentedBuffers = fullscreen ? scannedOutBuffers : overlayBuffers;
+    quint64 presented = presentedBuffers();
+    QVERIFY(client.render(Qt::red));
+    QTRY_VERIFY(presentedBuffers() > presented);
+    QPointer<KWayland::Server::BufferInterface> shown = c->surface()->buffer();
+    QVERIFY(!shown.isNull());
+    QTRY_VERIFY(!output->isPageFlipPending());
+    QVERIFY(shown->isReferenced());
+
+    // look at the buffer while the page flip to its successor is pending
+    presented = presentedBuffers();
+    bool checkedWhileFlipPending = false;
+    bool referencedWhileFlipPending = true;
+    QTimer pollTimer;
+    pollTimer.setInterval(1);
+    connect(&pollTimer, &QTimer::timeout, this,
+        [&] {
+            if (!output->isPageFlipPending() || presentedBuffers() == presented) {
+                return;
+            }
+            checkedWhileFlipPending = true;
+            referencedWhileFlipPending = referencedWhileFlipPending && !shown.isNull() && shown->isReferenced();
+        }
+    );
+    pollTimer.start();
+    QVERIFY(client.render(Qt::green));
+    QTRY_VERIFY(checkedWhileFlipPending);
+    QVERIFY(referencedWhileFlipPending);
+    // and it gets released once the page flip completed
+    QTRY_VERIFY(!output->isPageFlipPending());
+    pollTimer.stop();
+    QTRY_VERIFY(shown.isNull() || !shown->isReferenced());
+}
+
+}
+
+static void selectDrmBackend()
+{
+    // the drm backend needs a device to drive and session control through logind,
+    // without them the test falls back to the virtual backend and skips
+    if (QFile::exists(QStringLiteral("/sys/module/vkms")) && qEnvironmentVariableIsSet("XDG_SESSION_ID")) {
+        setenv("KWIN_WAYLAND_TEST_BACKEND", KWINDRMBACKENDPATH, true);
+        // overlay planes are only used with atomic mode setting
+        setenv("KWIN_DRM_AMS", "1", true);
+    }
+    // the client uses Wayland as its EGL platform, the backend creates its display on gbm explicitly
+    setenv("EGL_PLATFORM", "wayland", true);
+}
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 6, 0))
+WAYLANDTEST_MAIN_HELPER(KWin::DirectScanoutTest, selectDrmBackend(); QCoreApplication::setAttribute(Qt::AA_DisableHighDpiScaling))
+#else
+WAYLANDTEST_MAIN_HELPER(KWin::DirectScanoutTest, selectDrmBackend())
+#endif
+#include "direct_scanout_test.moc"
@@ -0,0 +1,301 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "abstract_backend.h"
+#include "composite.h"
+#include "options.h"
+#include "scene.h"
+#include "shell_client.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <KWayland/Client/compositor.h>
+#include <KWayland/Client/connection_thread.h>
+#include <KWayland/Client/event_queue.h>
+#include <KWayland/Client/registry.h>
+#include <KWayland/Client/shell.h>
+#include <KWayland/Client/shm_pool.h>
+#include <KWayland/Client/surface.h>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_frame_callback_throttling-0");
+static const int s_interval = 1000;
+
+class FrameCallbackThrottlingTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testVisibleSurface();
+    void testOffscreenSurface();
+    void testOccludedSurface();
+    void testSentWhenVisibleAgain();
+    void testThrottlingDisabled();
+
+private:
+    ShellClient *createWindow(KWayland::Client::Surface **surface, const QColor &color);
+    void render(KWayland::Client::Surface *surface, const QColor &color);
+    void commitAndPaint(KWayland::Client::Surface *surface, ShellClient *c);
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::ShmPool *m_shm = nullptr;
+    KWayland::Client::Shell *m_shell = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+void FrameCallbackThrottlingTest::initTestCase()
+{
+    qRegisterMetaType<KWin::ShellClient*>();
+    qRegisterMetaType<KWin::Toplevel*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    waylandServer()->backend()->setInitialWindowSize(QSize(1280, 1024));
+    waylandServer()->init(s_socketName.toLocal8Bit());
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QVERIFY(Compositor::self());
+}
+
+void FrameCallbackThrottlingTest::init()
+{
+    using namespace KWayland::Client;
+    options->setHiddenFrameCallbackInterval(s_interval);
+    // setup connection
+    m_connection = new ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &ConnectionThread::connected);
+    QVERIFY(connectedSpy.isValid());
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new EventQueue(this);
+    QVERIFY(!m_queue->isValid());
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    Registry registry;
+    registry.setEventQueue(m_queue);
+    QSignalSpy compositorSpy(&registry, &Registry::compositorAnnounced);
+    QSignalSpy shmSpy(&registry, &Registry::shmAnnounced);
+    QSignalSpy shellSpy(&registry, &Registry::shellAnnounced);
+    QSignalSpy allAnnounced(&registry, &Registry::interfacesAnnounced);
+    QVERIFY(allAnnounced.isValid());
+    QVERIFY(shmSpy.isValid());
+    QVERIFY(shellSpy.isValid());
+    QVERIFY(compositorSpy.isValid());
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    QVERIFY(allAnnounced.wait());
+    QVERIFY(!compositorSpy.isEmpty());
+    QVERIFY(!shmSpy.isEmpty());
+    QVERIFY(!shellSpy.isEmpty());
+
+    m_compositor = registry.createCompositor(compositorSpy.first().first().value<quint32>(), compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_compositor->isValid());
+    m_shm = registry.createShmPool(shmSpy.first().first().value<quint32>(), shmSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_shm->isValid());
+    m_shell = registry.createShell(shellSpy.first().first().value<quint32>(), shellSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_shell->isValid());
+}
+
+void FrameCallbackThrottlingTest::cleanup()
+{
+    delete m_compositor;
+    m_compositor = nullptr;
+    delete m_shm;
+    m_shm = nullptr;
+    delete m_shell;
+    m_shell = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_connection->deleteLater();
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+        m_connection = nullptr;
+    }
+    options->setHiddenFrameCallbackInterval(Options::defaultHiddenFrameCallbackInterval());
+}
+
+void FrameCallbackThrottlingTest::render(KWayland::Client::Surface *surface, const QColor &color)
+{
+    // no alpha channel, so that the window occludes what is below it
+    QImage img(QSize(100, 50), QImage::Format_RGB32);
+    img.fill(color);
+    surface->attachBuffer(m_shm->createBuffer(img));
+    surface->damage(QRect(0, 0, 100, 50));
+    surface->commit(KWayland::Client::Surface::CommitFlag::FrameCallback);
+    m_connection->flush();
+}
+
+ShellClient *FrameCallbackThrottlingTest::createWindow(KWayland::Client::Surface **surface, const QColor &color)
+{
+    using namespace KWayland::Client;
+    QSignalSpy clientAddedSpy(waylandServer(), &WaylandServer::shellClientAdded);
+    if (!clientAddedSpy.isValid()) {
+        return nullptr;
+    }
+    *surface = m_compositor->createSurface(m_compositor);
+    m_shell->createSurface(*surface, *surface);
+    render(*surface, color);
+    if (!clientAddedSpy.wait()) {
+        return nullptr;
+    }
+    return clientAddedSpy.first().first().value<ShellClient*>();
+}
+
+void FrameCallbackThrottlingTest::commitAndPaint(KWayland::Client::Surface *surface, ShellClient *c)
+{
+    // the frame callback gets sent after the frame including the committed damage got painted
+    QSignalSpy damagedSpy(c, &Toplevel::damaged);
+    QVERIFY(damagedSpy.isValid());
+    render(surface, Qt::red);
+    QVERIFY(damagedSpy.wait());
+    Compositor::self()->addRepaintFull();
+}
+
+void FrameCallbackThrottlingTest::testVisibleSurface()
+{
+    using namespace KWayland::Client;
+    Surface *surface = nullptr;
+    ShellClient *c = createWindow(&surface, Qt::blue);
+    QVERIFY(c);
+    QSignalSpy frameRenderedSpy(surface, &Surface::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    QVERIFY(frameRenderedSpy.wait());
+
+    QElapsedTimer timer;
+    timer.start();
+    commitAndPaint(surface, c);
+    QVERIFY(frameRenderedSpy.wait());
+    QVERIFY(Compositor::self()->scene()->isWindowVisibleInLastFrame(c));
+    QVERIFY(timer.elapsed() < s_interval);
+}
+
+void FrameCallbackThrottlingTest::testOffscreenSurface()
+{
+    using namespace KWayland::Client;
+    Surface *surface = nullptr;
+    ShellClient *c = createWindow(&surface, Qt::blue);
+    QVERIFY(c);
+    QSignalSpy frameRenderedSpy(surface, &Surface::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    QVERIFY(frameRenderedSpy.wait());
+
+    c->move(QPoint(5000, 5000));
+    QElapsedTimer timer;
+    timer.start();
+    commitAndPaint(surface, c);
+    // the callback is withheld for the interval
+    QVERIFY(!frameRenderedSpy.wait(s_interval / 2));
+    QVERIFY(!Compositor::self()->scene()->isWindowVisibleInLastFrame(c));
+    QVERIFY(frameRenderedSpy.wait(s_interval));
+    // timers may fire up to 5 % early
+    QVERIFY(timer.elapsed() >= s_interval * 95 / 100);
+}
+
+void FrameCallbackThrottlingTest::testOccludedSurface()
+{
+    using namespace KWayland::Client;
+    Surface *surface = nullptr;
+    ShellClient *c = createWindow(&surface, Qt::blue);
+    QVERIFY(c);
+    QSignalSpy frameRenderedSpy(surface, &Surface::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    QVERIFY(frameRenderedSpy.wait());
+
+    // an opaque window on top covers the first one completely
+    Surface *coverSurface = nullptr;
+    ShellClient *cover = createWindow(&coverSurface, Qt::green);
+    QVERIFY(cover);
+    cover->move(c->pos());
+    QCOMPARE(cover->geometry(), c->geometry());
+    QVERIFY(workspace()->stackingOrder().indexOf(cover) > workspace()->stackingOrder().indexOf(c));
+
+    QElapsedTimer timer;
+    timer.start();
+    commitAndPaint(surface, c);
+    QVERIFY(!frameRenderedSpy.wait(s_interval / 2));
+    QVERIFY(!Compositor::self()->scene()->isWindowVisibleInLastFrame(c));
+    QVERIFY(Compositor::self()->scene()->isWindowVisibleInLastFrame(cover));
+    QVERIFY(frameRenderedSpy.wait(s_interval));
+    QVERIFY(timer.elapsed() >= s_interval * 95 / 100);
+}
+
+void FrameCallbackThrottlingTest::testSentWhenVisibleAgain()
+{
+    using namespace KWayland::Client;
+    Surface *surface = nullptr;
+    ShellClient *c = createWindow(&surface, Qt::blue);
+    QVERIFY(c);
+    QSignalSpy frameRenderedSpy(surface, &Surface::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    QVERIFY(frameRenderedSpy.wait());
+
+    const QPoint pos = c->pos();
+    c->move(QPoint(5000, 5000));
+    commitAndPaint(surface, c);
+    QVERIFY(!frameRenderedSpy.wait(s_interval / 4));
+
+    // the withheld callback is sent with the first frame showing the window again
+    QElapsedTimer timer;
+    timer.start();
+    c->move(pos);
+    Compositor::self()->addRepaintFull();
+    QVERIFY(frameRenderedSpy.wait());
+    QVERIFY(timer.elapsed() < s_interval / 2);
+}
+
+void FrameCallbackThrottlingTest::testThrottlingDisabled()
+{
+    using namespace KWayland::Client;
+    options->setHiddenFrameCallbackInterval(0);
+    Surface *surface = nullptr;
+    ShellClient *c = createWindow(&surface, Qt::blue);
+    QVERIFY(c);
+    QSignalSpy frameRenderedSpy(surface, &Surface::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    QVERIFY(frameRenderedSpy.wait());
+
+    c->move(QPoint(5000, 5000));
+    QElapsedTimer timer;
+    timer.start();
+    commitAndPaint(surface, c);
+    QVERIFY(frameRenderedSpy.wait());
+    QVERIFY(timer.elapsed() < s_interval / 2);
+}
+
+}
+
+WAYLANDTEST_MAIN(KWin::FrameCallbackThrottlingTest)
+#include "frame_callback_throttling_test.moc"
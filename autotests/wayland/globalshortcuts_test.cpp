@@ -0,0 +1,203 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "abstract_backend.h"
+#include "globalshortcuts.h"
+#include "input.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <KGlobalAccel/private/kglobalaccel_interface.h>
+
+#include <QAction>
+
+#include <xkbcommon/xkbcommon-keysyms.h>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_globalshortcuts-0");
+
+/**
+ * Stands in for the kglobalaccel plugin and records the key combinations forwarded to it.
+ **/
+class FakeGlobalAccel : public KGlobalAccelInterface
+{
+    Q_OBJECT
+public:
+    explicit FakeGlobalAccel(QObject *parent = nullptr)
+        : KGlobalAccelInterface(parent)
+    {
+    }
+    bool grabKey(int key, bool grab) override {
+        Q_UNUSED(key)
+        Q_UNUSED(grab)
+        return true;
+    }
+    void setEnabled(bool enabled) override {
+        Q_UNUSED(enabled)
+    }
+    QVector<int> checkedKeys;
+
+public Q_SLOTS:
+    bool checkKeyPressed(int keyQt) {
+        checkedKeys << keyQt;
+        return true;
+    }
+};
+
+class GlobalShortcutsTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testKeyShortcut();
+    void testPointerShortcut();
+    void testAxisShortcut();
+    void testRemovedShortcut();
+    void testGlobalAccelBacktab_data();
+    void testGlobalAccelBacktab();
+    void benchmarkNonMatchingKey();
+    void benchmarkMatchingKey();
+};
+
+void GlobalShortcutsTest::initTestCase()
+{
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    waylandServer()->backend()->setInitialWindowSize(QSize(1280, 1024));
+    waylandServer()->init(s_socketName.toLocal8Bit());
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+}
+
+void GlobalShortcutsTest::testKeyShortcut()
+{
+    QScopedPointer<QAction> action(new QAction(nullptr));
+    action->setObjectName(QStringLiteral("globalshortcuts-test-key"));
+    QSignalSpy triggeredSpy(action.data(), &QAction::triggered);
+    QVERIFY(triggeredSpy.isValid());
+    input()->registerShortcut(Qt::META + Qt::SHIFT + Qt::Key_F12, action.data());
+
+    auto shortcuts = input()->shortcuts();
+    QVERIFY(!shortcuts->processKey(Qt::MetaModifier | Qt::ShiftModifier, XKB_KEY_F11));
+    QVERIFY(!shortcuts->processKey(Qt::MetaModifier, XKB_KEY_F12));
+    QVERIFY(!shortcuts->processKey(Qt::NoModifier, XKB_KEY_F12));
+    QVERIFY(shortcuts->processKey(Qt::MetaModifier | Qt::ShiftModifier, XKB_KEY_F12));
+    QVERIFY(triggeredSpy.wait());
+    QCOMPARE(triggeredSpy.count(), 1);
+}
+
+void GlobalShortcutsTest::testPointerShortcut()
+{
+    QScopedPointer<QAction> action(new QAction(nullptr));
+    QSignalSpy triggeredSpy(action.data(), &QAction::triggered);
+    QVERIFY(triggeredSpy.isValid());
+    input()->registerPointerShortcut(Qt::MetaModifier, Qt::LeftButton, action.data());
+
+    auto shortcuts = input()->shortcuts();
+    QVERIFY(!shortcuts->processPointerPressed(Qt::MetaModifier, Qt::RightButton));
+    QVERIFY(!shortcuts->processPointerPressed(Qt::NoModifier, Qt::LeftButton));
+    QVERIFY(shortcuts->processPointerPressed(Qt::MetaModifier, Qt::LeftButton));
+    QVERIFY(triggeredSpy.wait());
+    QCOMPARE(triggeredSpy.count(), 1);
+}
+
+void GlobalShortcutsTest::testAxisShortcut()
+{
+    QScopedPointer<QAction> action(new QAction(nullptr));
+    QSignalSpy triggeredSpy(action.data(), &QAction::triggered);
+    QVERIFY(triggeredSpy.isValid());
+    input()->registerAxisShortcut(Qt::MetaModifier, PointerAxisDown, action.data());
+
+    auto shortcuts = input()->shortcuts();
+    QVERIFY(!shortcuts->processAxis(Qt::MetaModifier, PointerAxisUp));
+    QVERIFY(!shortcuts->processAxis(Qt::ControlModifier, PointerAxisDown));
+    QVERIFY(shortcuts->processAxis(Qt::MetaModifier, PointerAxisDown));
+    QVERIFY(triggeredSpy.wait());
+    QCOMPARE(triggeredSpy.count(), 1);
+}
+
+void GlobalShortcutsTest::testRemovedShortcut()
+{
+    // deleting the action has to remove the shortcut from the lookup table
+    QAction *action = new QAction(nullptr);
+    action->setObjectName(QStringLiteral("globalshortcuts-test-removed"));
+    input()->registerShortcut(Qt::META + Qt::SHIFT + Qt::Key_F10, action);
+    delete action;
+    QVERIFY(!input()->shortcuts()->processKey(Qt::MetaModifier | Qt::ShiftModifier, XKB_KEY_F10));
+}
+
+void GlobalShortcutsTest::testGlobalAccelBacktab_data()
+{
+    QTest::addColumn<int>("grabbedKey");
+
+    QTest::newRow("Shift+Tab") << int(Qt::META + Qt::SHIFT + Qt::Key_Tab);
+    QTest::newRow("Shift+Backtab") << int(Qt::META + Qt::SHIFT + Qt::Key_Backtab);
+    QTest::newRow("Backtab") << int(Qt::META + Qt::Key_Backtab);
+}
+
+void GlobalShortcutsTest::testGlobalAccelBacktab()
+{
+    // Shift+Tab produces the Backtab keysym, it has to reach kglobalaccel
+    // however the shortcut got grabbed
+    QFETCH(int, grabbedKey);
+    FakeGlobalAccel globalAccel;
+    auto shortcuts = input()->shortcuts();
+    shortcuts->setKGlobalAccelInterface(&globalAccel);
+    shortcuts->setKGlobalAccelKeyGrabbed(grabbedKey, true);
+
+    QVERIFY(!shortcuts->processKey(Qt::MetaModifier, XKB_KEY_Tab));
+    QVERIFY(globalAccel.checkedKeys.isEmpty());
+    QVERIFY(shortcuts->processKey(Qt::MetaModifier | Qt::ShiftModifier, XKB_KEY_ISO_Left_Tab));
+    QCOMPARE(globalAccel.checkedKeys.count(), 1);
+    QCOMPARE(globalAccel.checkedKeys.first(), int(Qt::META + Qt::SHIFT + Qt::Key_Backtab));
+
+    // no longer forwarded once ungrabbed
+    shortcuts->setKGlobalAccelKeyGrabbed(grabbedKey, false);
+    QVERIFY(!shortcuts->processKey(Qt::MetaModifier | Qt::ShiftModifier, XKB_KEY_ISO_Left_Tab));
+    QCOMPARE(globalAccel.checkedKeys.count(), 1);
+    shortcuts->setKGlobalAccelInterface(nullptr);
+}
+
+void GlobalShortcutsTest::benchmarkNonMatchingKey()
+{
+    auto shortcuts = input()->shortcuts();
+    QBENCHMARK {
+        shortcuts->processKey(Qt::NoModifier, XKB_KEY_a);
+    }
+}
+
+void GlobalShortcutsTest::benchmarkMatchingKey()
+{
+    QScopedPointer<QAction> action(new QAction(nullptr));
+    action->setObjectName(QStringLiteral("globalshortcuts-test-benchmark"));
+    input()->registerShortcut(Qt::META + Qt::SHIFT + Qt::Key_F9, action.data());
+
+    auto shortcuts = input()->shortcuts();
+    QBENCHMARK {
+        shortcuts->processKey(Qt::MetaModifier | Qt::ShiftModifier, XKB_KEY_F9);
+    }
+}
+
+}
+
+WAYLANDTEST_MAIN(KWin::GlobalShortcutsTest)
+#include "globalshortcuts_test.moc"
@@ -0,0 +1,169 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "abstract_backend.h"
+#include "input.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <QKeyEvent>
+#include <QMouseEvent>
+
+#include <linux/input.h>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_input_filters-0");
+
+class InputFiltersTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testActiveFilters_data();
+    void testActiveFilters();
+    void testFilterOrder();
+    void benchmarkPointerDispatch_data();
+    void benchmarkPointerDispatch();
+    void benchmarkKeyDispatch_data();
+    void benchmarkKeyDispatch();
+    void benchmarkTouchDispatch_data();
+    void benchmarkTouchDispatch();
+};
+
+void InputFiltersTest::initTestCase()
+{
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    waylandServer()->backend()->setInitialWindowSize(QSize(1280, 1024));
+    waylandServer()->init(s_socketName.toLocal8Bit());
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+}
+
+void InputFiltersTest::testActiveFilters_data()
+{
+    QTest::addColumn<int>("type");
+
+    QTest::newRow("pointer") << int(InputEventFilter::PointerEvents);
+    QTest::newRow("wheel") << int(InputEventFilter::WheelEvents);
+    QTest::newRow("key") << int(InputEventFilter::KeyEvents);
+    QTest::newRow("touch") << int(InputEventFilter::TouchEvents);
+}
+
+void InputFiltersTest::testActiveFilters()
+{
+    // every active filter handling the type is in the chain, all others are not
+    QFETCH(int, type);
+    const auto active = input()->activeFilters(type);
+    QVERIFY(!active.isEmpty());
+    for (InputEventFilter *filter : input()->filters()) {
+        const bool expected = filter->isActive() && (filter->eventTypes() & type);
+        QCOMPARE(active.contains(filter), expected);
+    }
+}
+
+void InputFiltersTest::testFilterOrder()
+{
+    // screen is not locked and no window is moved, so only the forwarding filter handles touch
+    const auto touch = input()->activeFilters(InputEventFilter::TouchEvents);
+    QCOMPARE(touch.count(), 1);
+    QCOMPARE(touch.first(), input()->filters().last());
+
+    // the chains keep the installation order
+    const auto all = input()->filters();
+    const auto pointer = input()->activeFilters(InputEventFilter::PointerEvents);
+    int last = -1;
+    for (InputEventFilter *filter : pointer) {
+        const int index = all.indexOf(filter);
+        QVERIFY(index > last);
+        last = index;
+    }
+}
+
+static void addDispatchRows()
+{
+    QTest::addColumn<bool>("activeOnly");
+
+    QTest::newRow("all filters") << false;
+    QTest::newRow("active filters") << true;
+}
+
+void InputFiltersTest::benchmarkPointerDispatch_data()
+{
+    addDispatchRows();
+}
+
+void InputFiltersTest::benchmarkPointerDispatch()
+{
+    QFETCH(bool, activeOnly);
+    const auto filters = activeOnly ? input()->activeFilters(InputEventFilter::PointerEvents) : input()->filters();
+    QMouseEvent event(QEvent::MouseMove, QPointF(100, 100), QPointF(100, 100), Qt::NoButton, Qt::NoButton, Qt::NoModifier);
+    QBENCHMARK {
+        for (InputEventFilter *filter : filters) {
+            if (filter->pointerEvent(&event, 0)) {
+                break;
+            }
+        }
+    }
+}
+
+void InputFiltersTest::benchmarkKeyDispatch_data()
+{
+    addDispatchRows();
+}
+
+void InputFiltersTest::benchmarkKeyDispatch()
+{
+    QFETCH(bool, activeOnly);
+    const auto filters = activeOnly ? input()->activeFilters(InputEventFilter::KeyEvents) : input()->filters();
+    QKeyEvent event(QEvent::KeyRelease, Qt::Key_A, Qt::NoModifier, KEY_A, 0, 0);
+    QBENCHMARK {
+        for (InputEventFilter *filter : filters) {
+            if (filter->keyEvent(&event)) {
+                break;
+            }
+        }
+    }
+}
+
+void InputFiltersTest::benchmarkTouchDispatch_data()
+{
+    addDispatchRows();
+}
+
+void InputFiltersTest::benchmarkTouchDispatch()
+{
+    QFETCH(bool, activeOnly);
+    const auto filters = activeOnly ? input()->activeFilters(InputEventFilter::TouchEvents) : input()->filters();
+    QBENCHMARK {
+        for (InputEventFilter *filter : filters) {
+            if (filter->touchMotion(0, QPointF(100, 100), 0)) {
+                break;
+            }
+        }
+    }
+}
+
+}
+
+WAYLANDTEST_MAIN(KWin::InputFiltersTest)
+#include "input_filters_test.moc"
@@ -45,6 +45,7 @@ private Q_SLOTS:
     void testPointerPressRelease();
     void testPointerAxis();
     void testKeyboard();
+    void testKeyRepeat();
 };
 
 class HelperWindow : public QRasterWindow
@@ -62,6 +63,7 @@ Q_SIGNALS:
     void mouseReleased();
     void wheel();
     void keyPressed();
+    void keyRepeated();
     void keyReleased();
 
 protected:
@@ -125,8 +127,11 @@ void HelperWindow::wheelEvent(QWheelEvent *event)
 
 void HelperWindow::keyPressEvent(QKeyEvent *event)
 {
-    Q_UNUSED(event)
-    emit keyPressed();
+    if (event->isAutoRepeat()) {
+        emit keyRepeated();
+    } else {
+        emit keyPressed();
+    }
 }
 
 void HelperWindow::keyReleaseEvent(QKeyEvent *event)
@@ -262,6 +267,52 @@ void InternalWindowTest::testKeyboard()
     QCOMPARE(pressSpy.count(), 1);
 }
 
+void InternalWindowTest::testKeyRepeat()
+{
+    // KWin repeats a held key for its internal windows itself,
+    // with the default delay of 660 ms and rate of 25 per second
+    QSignalSpy clientAddedSpy(waylandServer(), &WaylandServer::shellClientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+    HelperWindow win;
+    win.setGeometry(0, 0, 100, 100);
+    win.show();
+    QSignalSpy pressSpy(&win, &HelperWindow::keyPressed);
+    QVERIFY(pressSpy.isValid());
+    QSignalSpy repeatSpy(&win, &HelperWindow::keyRepeated);
+    QVERIFY(repeatSpy.isValid());
+    QSignalSpy releaseSpy(&win, &HelperWindow::keyReleased);
+    QVERIFY(releaseSpy.isValid());
+    QVERIFY(clientAddedSpy.wait());
+    QCOMPARE(clientAddedSpy.count(), 1);
+
+    quint32 timestamp = 1;
+    waylandServer()->backend()->pointerMotion(QPoint(50, 50), timestamp++);
+
+    QElapsedTimer timer;
+    timer.start();
+    waylandServer()->backend()->keyboardKeyPressed(KEY_A, timestamp++);
+    QTRY_COMPARE(pressSpy.count(), 1);
+    // nothing is repeated before the delay passed, the coarse timer may fire 5 % early
+    QVERIFY(!repeatSpy.wait(500));
+    QVERIFY(repeatSpy.wait());
+    const qint64 firstRepeat = timer.elapsed();
+    QVERIFY(firstRepeat >= 660 * 95 / 100);
+
+    // followed by one repeat every 40 ms
+    QTRY_VERIFY(repeatSpy.count() >= 6);
+    const qint64 repeating = timer.elapsed() - firstRepeat;
+    QVERIFY(repeating >= 5 * 40 * 95 / 100);
+    QVERIFY(repeating < 1000);
+    QCOMPARE(pressSpy.count(), 1);
+
+    // and it stops with the release
+    waylandServer()->backend()->keyboardKeyReleased(KEY_A, timestamp++);
+    QTRY_COMPARE(releaseSpy.count(), 1);
+    const int repeats = repeatSpy.count();
+    QVERIFY(!repeatSpy.wait(200));
+    QCOMPARE(repeatSpy.count(), repeats);
+}
+
 }
 
 WAYLANDTEST_MAIN(KWin::InternalWindowTest)
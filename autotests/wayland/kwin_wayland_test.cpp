@@ -48,7 +48,9 @@ WaylandTestApplication::WaylandTestApplication(int &argc, char **argv)
 #endif
     qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
     WaylandServer *server = WaylandServer::create(this);
-    QPluginLoader loader(QStringLiteral(KWINBACKENDPATH));
+    // tests which need real hardware can select a different backend plugin
+    const QString backend = QString::fromLocal8Bit(qgetenv("KWIN_WAYLAND_TEST_BACKEND"));
+    QPluginLoader loader(backend.isEmpty() ? QStringLiteral(KWINBACKENDPATH) : backend);
     loader.instance()->setParent(server);
 }
 
@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "abstract_client.h"
 #include "cursor.h"
 #include "deleted.h"
+#include "options.h"
 #include "screenedge.h"
 #include "screens.h"
 #include "wayland_server.h"
@@ -41,6 +42,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <KWayland/Server/seat_interface.h>
 
+#include <linux/input.h>
+
 namespace KWin
 {
 
@@ -55,6 +58,7 @@ private Q_SLOTS:
     void cleanup();
     void testWarpingUpdatesFocus();
     void testWarpingGeneratesPointerMotion();
+    void testCoalescedMotion();
     void testUpdateFocusAfterScreenChange();
 
 private:
@@ -166,6 +170,8 @@ void PointerInputTest::cleanup()
         m_thread = nullptr;
         m_connection = nullptr;
     }
+    // also when a test failed while coalescing
+    options->setCoalescePointerMotion(Options::defaultCoalescePointerMotion());
 }
 
 void PointerInputTest::render(KWayland::Client::Surface *surface, const QSize &size)
@@ -265,6 +271,62 @@ void PointerInputTest::testWarpingGeneratesPointerMotion()
     QCOMPARE(movedSpy.last().first().toPointF(), QPointF(26, 26));
 }
 
+void PointerInputTest::testCoalescedMotion()
+{
+    // this test verifies that with coalescing enabled motion is delivered once per frame
+    // and that a button press is delivered at the position of the preceding motion
+    using namespace KWayland::Client;
+    options->setCoalescePointerMotion(true);
+    auto pointer = m_seat->createPointer(m_seat);
+    QVERIFY(pointer);
+    QVERIFY(pointer->isValid());
+    QSignalSpy enteredSpy(pointer, &Pointer::entered);
+    QVERIFY(enteredSpy.isValid());
+    QSignalSpy movedSpy(pointer, &Pointer::motion);
+    QVERIFY(movedSpy.isValid());
+    QSignalSpy buttonSpy(pointer, &Pointer::buttonStateChanged);
+    QVERIFY(buttonSpy.isValid());
+
+    // create a window
+    QSignalSpy clientAddedSpy(waylandServer(), &WaylandServer::shellClientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+    Surface *surface = m_compositor->createSurface(m_compositor);
+    QVERIFY(surface);
+    ShellSurface *shellSurface = m_shell->createSurface(surface, surface);
+    QVERIFY(shellSurface);
+    render(surface);
+    QVERIFY(clientAddedSpy.wait());
+    QVERIFY(workspace()->activeClient());
+
+    // enter
+    waylandServer()->backend()->pointerMotion(QPointF(25, 25), 1);
+    QVERIFY(enteredSpy.wait());
+    if (movedSpy.isEmpty()) {
+        QVERIFY(movedSpy.wait());
+    }
+    movedSpy.clear();
+
+    // several motion events are merged into one
+    waylandServer()->backend()->pointerMotion(QPointF(30, 30), 2);
+    waylandServer()->backend()->pointerMotion(QPointF(35, 35), 3);
+    waylandServer()->backend()->pointerMotion(QPointF(40, 40), 4);
+    QCOMPARE(Cursor::pos(), QPoint(25, 25));
+    QVERIFY(movedSpy.wait());
+    QCOMPARE(movedSpy.count(), 1);
+    QCOMPARE(movedSpy.first().first().toPointF(), QPointF(40, 40));
+    QCOMPARE(Cursor::pos(), QPoint(40, 40));
+
+    // a button press flushes the pending motion first
+    waylandServer()->backend()->pointerMotion(QPointF(50, 45), 5);
+    waylandServer()->backend()->pointerButtonPressed(BTN_LEFT, 6);
+    QCOMPARE(Cursor::pos(), QPoint(50, 45));
+    QVERIFY(buttonSpy.wait());
+    QCOMPARE(movedSpy.count(), 2);
+    QCOMPARE(movedSpy.last().first().toPointF(), QPointF(50, 45));
+    waylandServer()->backend()->pointerButtonReleased(BTN_LEFT, 7);
+    QVERIFY(buttonSpy.wait());
+}
+
 void PointerInputTest::testUpdateFocusAfterScreenChange()
 {
     // this test verifies that a pointer enter event is generated when the cursor changes to another
@@ -0,0 +1,201 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "abstract_backend.h"
+#include "client.h"
+#include "composite.h"
+#include "options.h"
+#include "scene.h"
+#include "virtualdesktops.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <QRegularExpression>
+
+#include <xcb/xcb.h>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_resident_desktops-0");
+static const qint64 s_mebibyte = 1024 * 1024;
+
+class ResidentDesktopsTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testSwitchBackHits();
+    void testBudgetEviction();
+
+private:
+    Client *createWindow(const QSize &size);
+    xcb_connection_t *m_connection = nullptr;
+    QList<xcb_window_t> m_windows;
+};
+
+struct PrefetchCounts {
+    int hits = 0;
+    int misses = 0;
+};
+
+static PrefetchCounts prefetchCounts()
+{
+    // the counters of the scene are only exposed through the support information
+    static const QRegularExpression regExp(QStringLiteral("Windows with content on desktop switches: (\\d+) hits, (\\d+) misses"));
+    const auto match = regExp.match(Compositor::self()->scene()->supportInformation());
+    PrefetchCounts counts;
+    if (match.hasMatch()) {
+        counts.hits = match.captured(1).toInt();
+        counts.misses = match.captured(2).toInt();
+    }
+    return counts;
+}
+
+static qint64 pixmapSize(Client *c)
+{
+    // what Workspace::updateResidentDesktops accounts for the window
+    return qint64(c->width()) * c->height() * 4;
+}
+
+void ResidentDesktopsTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Client*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    waylandServer()->backend()->setInitialWindowSize(QSize(1280, 1024));
+    waylandServer()->init(s_socketName.toLocal8Bit());
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QVERIFY(Compositor::self());
+    VirtualDesktopManager::self()->setCount(3);
+}
+
+void ResidentDesktopsTest::init()
+{
+    options->setHiddenPreviews(HiddenPreviewsRecentDesktops);
+    VirtualDesktopManager::self()->setCurrent(1);
+    m_connection = xcb_connect(nullptr, nullptr);
+    QVERIFY(!xcb_connection_has_error(m_connection));
+}
+
+void ResidentDesktopsTest::cleanup()
+{
+    for (xcb_window_t w : m_windows) {
+        xcb_destroy_window(m_connection, w);
+    }
+    m_windows.clear();
+    xcb_flush(m_connection);
+    xcb_disconnect(m_connection);
+    m_connection = nullptr;
+    QTRY_VERIFY(workspace()->clientList().isEmpty());
+    VirtualDesktopManager::self()->setCurrent(1);
+    options->setHiddenPreviews(Options::defaultHiddenPreviews());
+    options->setHiddenPreviewsBudget(Options::defaultHiddenPreviewsBudget());
+}
+
+Client *ResidentDesktopsTest::createWindow(const QSize &size)
+{
+    // new windows go to the current desktop
+    QSignalSpy clientAddedSpy(workspace(), &Workspace::clientAdded);
+    if (!clientAddedSpy.isValid()) {
+        return nullptr;
+    }
+    const xcb_window_t w = xcb_generate_id(m_connection);
+    const uint32_t values[] = { xcb_setup_roots_iterator(xcb_get_setup(m_connection)).data->white_pixel };
+    xcb_create_window(m_connection, XCB_COPY_FROM_PARENT, w, rootWindow(), 0, 0, size.width(), size.height(),
+                      0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, XCB_CW_BACK_PIXEL, values);
+    xcb_map_window(m_connection, w);
+    xcb_flush(m_connection);
+    m_windows << w;
+    if (!clientAddedSpy.wait()) {
+        return nullptr;
+    }
+    Client *c = clientAddedSpy.first().first().value<Client*>();
+    // the pixmap exists once the window got painted
+    QElapsedTimer timer;
+    timer.start();
+    while (!Compositor::self()->scene()->isWindowVisibleInLastFrame(c) && timer.elapsed() < 5000) {
+        Compositor::self()->addRepaintFull();
+        QTest::qWait(50);
+    }
+    return Compositor::self()->scene()->isWindowVisibleInLastFrame(c) ? c : nullptr;
+}
+
+void ResidentDesktopsTest::testSwitchBackHits()
+{
+    // the window of the desktop left fits into the budget and keeps its content
+    Client *c = createWindow(QSize(200, 100));
+    QVERIFY(c);
+    QCOMPARE(c->desktop(), 1);
+    QVERIFY(pixmapSize(c) < options->hiddenPreviewsBudget() * s_mebibyte);
+
+    const PrefetchCounts before = prefetchCounts();
+    VirtualDesktopManager::self()->setCurrent(2);
+    QVERIFY(workspace()->isDesktopResident(1));
+    QVERIFY(!c->isOnCurrentDesktop());
+    QVERIFY(!c->isHiddenInternal());
+
+    VirtualDesktopManager::self()->setCurrent(1);
+    const PrefetchCounts after = prefetchCounts();
+    QCOMPARE(after.hits, before.hits + 1);
+    QCOMPARE(after.misses, before.misses);
+}
+
+void ResidentDesktopsTest::testBudgetEviction()
+{
+    // each window fits into the budget on its own, but not both of them
+    options->setHiddenPreviewsBudget(1);
+    Client *first = createWindow(QSize(420, 300));
+    QVERIFY(first);
+    QCOMPARE(first->desktop(), 1);
+    VirtualDesktopManager::self()->setCurrent(2);
+    Client *second = createWindow(QSize(420, 300));
+    QVERIFY(second);
+    QCOMPARE(second->desktop(), 2);
+    QVERIFY(pixmapSize(first) <= s_mebibyte);
+    QVERIFY(pixmapSize(second) <= s_mebibyte);
+    QVERIFY(pixmapSize(first) + pixmapSize(second) > s_mebibyte);
+
+    // the least recently used desktop gets evicted
+    VirtualDesktopManager::self()->setCurrent(3);
+    QVERIFY(workspace()->isDesktopResident(2));
+    QVERIFY(!workspace()->isDesktopResident(1));
+    QVERIFY(!second->isHiddenInternal());
+    QVERIFY(first->isHiddenInternal());
+
+    // and switching back to it has to wait for new content
+    const PrefetchCounts before = prefetchCounts();
+    VirtualDesktopManager::self()->setCurrent(1);
+    const PrefetchCounts after = prefetchCounts();
+    QCOMPARE(after.hits, before.hits);
+    QCOMPARE(after.misses, before.misses + 1);
+
+    // while the desktop kept resident still hits
+    VirtualDesktopManager::self()->setCurrent(2);
+    QCOMPARE(prefetchCounts().hits, after.hits + 1);
+}
+
+}
+
+WAYLANDTEST_MAIN(KWin::ResidentDesktopsTest)
+#include "resident_desktops_test.moc"
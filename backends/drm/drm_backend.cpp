@@ -70,8 +70,6 @@ DrmBackend::DrmBackend(QObject *parent)
     , m_udevMonitor(m_udev->monitor())
 {
     handleOutputs();
-    m_cursor[0] = nullptr;
-    m_cursor[1] = nullptr;
 }
 
 DrmBackend::~DrmBackend()
@@ -82,8 +80,10 @@ DrmBackend::~DrmBackend()
             QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
         }
         qDeleteAll(m_outputs);
-        delete m_cursor[0];
-        delete m_cursor[1];
+        qDeleteAll(m_planes);
+        for (const CursorBuffer &c : m_cursorBuffers) {
+            delete c.buffer;
+        }
         close(m_fd);
     }
 }
@@ -123,17 +123,23 @@ void DrmBackend::reactivate()
         return;
     }
     m_active = true;
-    DrmBuffer *c = m_cursor[(m_cursorIndex + 1) % 2];
-    const QPoint cp = Cursor::pos() - softwareCursorHotspot();
     for (auto it = m_outputs.constBegin(); it != m_outputs.constEnd(); ++it) {
         DrmOutput *o = *it;
         o->pageFlipped();
         o->blank();
-        o->showCursor(c);
-        o->moveCursor(cp);
     }
+    restoreCursor();
     // restart compositor
     m_pageFlipsPending = 0;
+    m_compositingBlocks = 0;
+    for (auto it = m_outputs.constBegin(); it != m_outputs.constEnd(); ++it) {
+        (*it)->m_blockingPageFlip = false;
+    }
+    emit reactivated();
+    // the page flip events got lost while the session was inactive
+    for (auto it = m_outputs.constBegin(); it != m_outputs.constEnd(); ++it) {
+        emit outputPageFlipped(*it);
+    }
     if (Compositor *compositor = Compositor::self()) {
         compositor->bufferSwapComplete();
         compositor->addRepaintFull();
@@ -146,9 +152,7 @@ void DrmBackend::deactivate()
         return;
     }
     // block compositor
-    if (m_pageFlipsPending == 0 && Compositor::self()) {
-        Compositor::self()->aboutToSwapBuffers();
-    }
+    blockCompositing();
     // hide cursor and disable
     for (auto it = m_outputs.constBegin(); it != m_outputs.constEnd(); ++it) {
         DrmOutput *o = *it;
@@ -167,12 +171,32 @@ void DrmBackend::pageFlipHandler(int fd, unsigned int frame, unsigned int sec, u
     auto output = reinterpret_cast<DrmOutput*>(data);
     output->pageFlipped();
     output->m_backend->m_pageFlipsPending--;
-    if (output->m_backend->m_pageFlipsPending == 0) {
+    if (output->m_blockingPageFlip) {
+        output->m_blockingPageFlip = false;
         // TODO: improve, this currently means we wait for all page flips or all outputs.
         // It would be better to driver the repaint per output
-        if (Compositor::self()) {
-            Compositor::self()->bufferSwapComplete();
-        }
+        output->m_backend->unblockCompositing();
+    }
+    emit output->m_backend->outputPageFlipped(output);
+}
+
+void DrmBackend::blockCompositing()
+{
+    m_compositingBlocks++;
+    if (m_compositingBlocks == 1 && Compositor::self()) {
+        Compositor::self()->aboutToSwapBuffers();
+    }
+}
+
+void DrmBackend::unblockCompositing()
+{
+    if (m_compositingBlocks == 0) {
+        // already reset when the session got reactivated
+        return;
+    }
+    m_compositingBlocks--;
+    if (m_compositingBlocks == 0 && Compositor::self()) {
+        Compositor::self()->bufferSwapComplete();
     }
 }
 
@@ -206,6 +230,9 @@ void DrmBackend::openDrm()
         }
     );
     m_drmId = device->sysNum();
+    if (qEnvironmentVariableIsSet("KWIN_DRM_AMS")) {
+        initPlanes();
+    }
     queryResources();
 
     // setup udevMonitor
@@ -226,8 +253,7 @@ void DrmBackend::openDrm()
                     if (device->hasProperty("HOTPLUG", "1")) {
                         qCDebug(KWIN_DRM) << "Received hot plug event for monitored drm device";
                         queryResources();
-                        m_cursorIndex = (m_cursorIndex + 1) % 2;
-                        updateCursor();
+                        restoreCursor();
                     }
                 }
             );
@@ -285,6 +311,22 @@ void DrmBackend::queryResources()
             drmOutput->m_mode = connector->modes[0];
         }
         drmOutput->m_connector = connector->connector_id;
+        for (int j = 0; j < resources->count_crtcs; ++j) {
+            if (resources->crtcs[j] == crtcId) {
+                drmOutput->m_crtcIndex = j;
+                break;
+            }
+        }
+        if (m_atomicModeSetting) {
+            drmOutput->m_primaryPlane = findPlane(int(DrmPlane::Type::Primary), drmOutput->m_crtcIndex);
+            drmOutput->m_overlayPlane = findPlane(int(DrmPlane::Type::Overlay), drmOutput->m_crtcIndex);
+            if (drmOutput->m_primaryPlane) {
+                drmOutput->m_primaryPlane->m_output = drmOutput;
+            }
+            if (drmOutput->m_overlayPlane) {
+                drmOutput->m_overlayPlane->m_output = drmOutput;
+            }
+        }
         drmOutput->init(connector.data());
         qCDebug(KWIN_DRM) << "Found new output with uuid" << drmOutput->uuid();
         connectedOutputs << drmOutput;
@@ -326,6 +368,8 @@ void DrmBackend::readOutputsConfiguration()
     for (auto it = m_outputs.begin(); it != m_outputs.end(); ++it) {
         const auto outputConfig = configGroup.group((*it)->uuid());
         (*it)->setGlobalPos(outputConfig.readEntry<QPoint>("Position", pos));
+        // more than three buffers would exceed what gbm surfaces provide
+        (*it)->m_swapChainDepth = qBound(2, outputConfig.readEntry("SwapChainDepth", 2), 3);
         // TODO: add mode
         pos.setX(pos.x() + (*it)->size().width());
     }
@@ -356,6 +400,51 @@ DrmOutput *DrmBackend::findOutput(quint32 connector)
     return nullptr;
 }
 
+void DrmBackend::initPlanes()
+{
+    if (drmSetClientCap(m_fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1) != 0 ||
+            drmSetClientCap(m_fd, DRM_CLIENT_CAP_ATOMIC, 1) != 0) {
+        qCWarning(KWIN_DRM) << "Atomic mode setting not supported, using legacy page flips";
+        return;
+    }
+    ScopedDrmPointer<_drmModePlaneRes, &drmModeFreePlaneResources> planeResources(drmModeGetPlaneResources(m_fd));
+    if (!planeResources) {
+        qCWarning(KWIN_DRM) << "drmModeGetPlaneResources failed, using legacy page flips";
+        return;
+    }
+    for (uint32_t i = 0; i < planeResources->count_planes; ++i) {
+        DrmPlane *plane = new DrmPlane(this, planeResources->planes[i]);
+        if (!plane->init()) {
+            delete plane;
+            continue;
+        }
+        m_planes << plane;
+    }
+    const bool hasPrimary = std::any_of(m_planes.constBegin(), m_planes.constEnd(),
+        [] (DrmPlane *plane) {
+            return plane->type() == DrmPlane::Type::Primary;
+        }
+    );
+    if (!hasPrimary) {
+        qCWarning(KWIN_DRM) << "No primary planes found, using legacy page flips";
+        qDeleteAll(m_planes);
+        m_planes.clear();
+        return;
+    }
+    qCDebug(KWIN_DRM) << "Using atomic mode setting with" << m_planes.count() << "planes";
+    m_atomicModeSetting = true;
+}
+
+DrmPlane *DrmBackend::findPlane(int type, int crtcIndex) const
+{
+    auto it = std::find_if(m_planes.constBegin(), m_planes.constEnd(),
+        [type, crtcIndex] (DrmPlane *plane) {
+            return int(plane->type()) == type && !plane->output() && plane->isCrtcSupported(crtcIndex);
+        }
+    );
+    return it != m_planes.constEnd() ? *it : nullptr;
+}
+
 quint32 DrmBackend::findCrtc(drmModeRes *res, drmModeConnector *connector, bool *ok)
 {
     if (ok) {
@@ -401,14 +490,17 @@ bool DrmBackend::crtcIsUsed(quint32 crtc)
     return it != m_outputs.constEnd();
 }
 
-void DrmBackend::present(DrmBuffer *buffer, DrmOutput *output)
+bool DrmBackend::present(DrmBuffer *buffer, DrmOutput *output, bool blocking)
 {
     if (output->present(buffer)) {
         m_pageFlipsPending++;
-        if (m_pageFlipsPending == 1 && Compositor::self()) {
-            Compositor::self()->aboutToSwapBuffers();
+        if (blocking) {
+            output->m_blockingPageFlip = true;
+            blockCompositing();
         }
+        return true;
     }
+    return false;
 }
 
 void DrmBackend::installCursorFromServer()
@@ -435,12 +527,15 @@ void DrmBackend::initCursor()
     } else {
         cursorSize.setHeight(64);
     }
-    m_cursor[0] = createBuffer(cursorSize);
-    m_cursor[0]->map(QImage::Format_ARGB32_Premultiplied);
-    m_cursor[0]->image()->fill(Qt::transparent);
-    m_cursor[1] = createBuffer(cursorSize);
-    m_cursor[1]->map(QImage::Format_ARGB32_Premultiplied);
-    m_cursor[0]->image()->fill(Qt::transparent);
+    // a few buffers so that the cursors used in turn, e.g. when hovering decorations and
+    // text input, or the frames of animated cursors, don't need to be painted again
+    static const int s_cursorBufferCount = 4;
+    m_cursorBuffers.resize(s_cursorBufferCount);
+    for (CursorBuffer &c : m_cursorBuffers) {
+        c.buffer = createBuffer(cursorSize);
+        c.buffer->map(QImage::Format_ARGB32_Premultiplied);
+        c.buffer->image()->fill(Qt::transparent);
+    }
     // now we have screens and can set cursors, so start tracking
     connect(this, &DrmBackend::cursorChanged, this, &DrmBackend::updateCursor);
     connect(Cursor::self(), &Cursor::posChanged, this, &DrmBackend::moveCursor);
@@ -449,11 +544,14 @@ void DrmBackend::initCursor()
 
 void DrmBackend::setCursor()
 {
-    DrmBuffer *c = m_cursor[m_cursorIndex];
-    m_cursorIndex = (m_cursorIndex + 1) % 2;
+    if (m_currentCursor == -1) {
+        return;
+    }
+    DrmBuffer *c = m_cursorBuffers.at(m_currentCursor).buffer;
     for (auto it = m_outputs.constBegin(); it != m_outputs.constEnd(); ++it) {
         (*it)->showCursor(c);
     }
+    m_cursorVisible = true;
 }
 
 void DrmBackend::updateCursor()
@@ -463,14 +561,37 @@ void DrmBackend::updateCursor()
         hideCursor();
         return;
     }
-    QImage *c = m_cursor[m_cursorIndex]->image();
-    c->fill(Qt::transparent);
-    QPainter p;
-    p.begin(c);
-    p.drawImage(QPoint(0, 0), cursorImage);
-    p.end();
-
-    setCursor();
+    // the cursor image is copied for each update, so compare the content and not just the cacheKey
+    int index = -1;
+    for (int i = 0; i < m_cursorBuffers.count(); ++i) {
+        if (m_cursorBuffers.at(i).image == cursorImage) {
+            index = i;
+            break;
+        }
+    }
+    if (index == -1) {
+        // paint into the least recently used buffer, which is never the shown one
+        index = 0;
+        for (int i = 1; i < m_cursorBuffers.count(); ++i) {
+            if (m_cursorBuffers.at(i).lastUsed < m_cursorBuffers.at(index).lastUsed) {
+                index = i;
+            }
+        }
+        CursorBuffer &c = m_cursorBuffers[index];
+        QImage *image = c.buffer->image();
+        image->fill(Qt::transparent);
+        QPainter p;
+        p.begin(image);
+        p.drawImage(QPoint(0, 0), cursorImage);
+        p.end();
+        c.image = cursorImage;
+    }
+    m_cursorBuffers[index].lastUsed = ++m_cursorUpdates;
+    if (index != m_currentCursor || !m_cursorVisible) {
+        m_currentCursor = index;
+        setCursor();
+    }
+    // the hotspot might have changed
     moveCursor();
 }
 
@@ -479,11 +600,31 @@ void DrmBackend::hideCursor()
     for (auto it = m_outputs.constBegin(); it != m_outputs.constEnd(); ++it) {
         (*it)->hideCursor();
     }
+    m_cursorVisible = false;
 }
 
 void DrmBackend::moveCursor()
 {
+    // invoked directly from the input handling, a move only updates the cursor plane
+    // and neither waits for nor triggers a compositing pass
     const QPoint p = Cursor::pos() - softwareCursorHotspot();
+    if (p == m_cursorPos) {
+        return;
+    }
+    m_cursorPos = p;
+    for (auto it = m_outputs.constBegin(); it != m_outputs.constEnd(); ++it) {
+        (*it)->moveCursor(p);
+    }
+}
+
+void DrmBackend::restoreCursor()
+{
+    if (m_currentCursor == -1 || softwareCursor().isNull()) {
+        return;
+    }
+    setCursor();
+    const QPoint p = Cursor::pos() - softwareCursorHotspot();
+    m_cursorPos = p;
     for (auto it = m_outputs.constBegin(); it != m_outputs.constEnd(); ++it) {
         (*it)->moveCursor(p);
     }
@@ -534,6 +675,18 @@ DrmBuffer *DrmBackend::createBuffer(gbm_surface *surface)
 #endif
 }
 
+DrmBuffer *DrmBackend::createBuffer(gbm_bo *bo)
+{
+#if HAVE_GBM
+    DrmBuffer *b = new DrmBuffer(this, bo);
+    m_buffers << b;
+    return b;
+#else
+    Q_UNUSED(bo)
+    return nullptr;
+#endif
+}
+
 void DrmBackend::bufferDestroyed(DrmBuffer *b)
 {
     m_buffers.removeAll(b);
@@ -561,6 +714,12 @@ DrmOutput::~DrmOutput()
 {
     hideCursor();
     cleanupBlackBuffer();
+    if (m_primaryPlane) {
+        m_primaryPlane->m_output = nullptr;
+    }
+    if (m_overlayPlane) {
+        m_overlayPlane->m_output = nullptr;
+    }
     delete m_waylandOutput.data();
 }
 
@@ -620,6 +779,9 @@ bool DrmOutput::present(DrmBuffer *buffer)
             return false;
         }
     }
+    if (m_primaryPlane) {
+        return presentAtomic(buffer);
+    }
     const bool ok = drmModePageFlip(m_backend->fd(), m_crtcId, buffer->bufferId(), DRM_MODE_PAGE_FLIP_EVENT, this) == 0;
     if (ok) {
         m_currentBuffer = buffer;
@@ -630,6 +792,83 @@ bool DrmOutput::present(DrmBuffer *buffer)
     return ok;
 }
 
+bool DrmOutput::presentAtomic(DrmBuffer *buffer)
+{
+    drmModeAtomicReq *request = drmModeAtomicAlloc();
+    if (!request) {
+        return false;
+    }
+    bool ok = addPlanes(request, buffer, m_overlayBuffer, m_overlayGeometry);
+    if (ok) {
+        // the primary plane and the overlay plane get flipped together with the same vblank
+        ok = drmModeAtomicCommit(m_backend->fd(), request, DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, this) == 0;
+    }
+    drmModeAtomicFree(request);
+    if (ok) {
+        m_currentBuffer = buffer;
+        m_overlayEnabled = m_overlayBuffer != nullptr;
+    } else {
+        qCWarning(KWIN_DRM) << "Atomic commit failed";
+        buffer->releaseGbm();
+    }
+    return ok;
+}
+
+bool DrmOutput::setOverlay(DrmBuffer *buffer, const QRect &geometry, DrmBuffer *primary)
+{
+    if (!buffer) {
+        m_overlayBuffer = nullptr;
+        m_overlayGeometry = QRect();
+        return true;
+    }
+    if (!m_overlayPlane || !primary || primary->bufferId() == 0 || buffer->bufferId() == 0) {
+        return false;
+    }
+    drmModeAtomicReq *request = drmModeAtomicAlloc();
+    if (!request) {
+        return false;
+    }
+    bool ok = addPlanes(request, primary, buffer, geometry);
+    if (ok) {
+        // only asks the driver whether the hardware can show this configuration
+        ok = drmModeAtomicCommit(m_backend->fd(), request, DRM_MODE_ATOMIC_TEST_ONLY, nullptr) == 0;
+    }
+    drmModeAtomicFree(request);
+    if (ok) {
+        m_overlayBuffer = buffer;
+        m_overlayGeometry = geometry;
+    }
+    return ok;
+}
+
+bool DrmOutput::addPlanes(drmModeAtomicReq *request, DrmBuffer *primary, DrmBuffer *overlay, const QRect &overlayGeometry) const
+{
+    auto addPlane = [request] (DrmPlane *plane, quint32 crtcId, DrmBuffer *buffer, const QRect &geometry) {
+        using P = DrmPlane::Property;
+        const quint32 id = plane->id();
+        const QSize sourceSize = buffer ? buffer->size() : QSize();
+        // source coordinates are in 16.16 fixed point
+        bool ok = drmModeAtomicAddProperty(request, id, plane->propertyId(P::FbId), buffer ? buffer->bufferId() : 0) > 0;
+        ok = ok && drmModeAtomicAddProperty(request, id, plane->propertyId(P::CrtcId), buffer ? crtcId : 0) > 0;
+        ok = ok && drmModeAtomicAddProperty(request, id, plane->propertyId(P::SrcX), 0) > 0;
+        ok = ok && drmModeAtomicAddProperty(request, id, plane->propertyId(P::SrcY), 0) > 0;
+        ok = ok && drmModeAtomicAddProperty(request, id, plane->propertyId(P::SrcW), sourceSize.width() << 16) > 0;
+        ok = ok && drmModeAtomicAddProperty(request, id, plane->propertyId(P::SrcH), sourceSize.height() << 16) > 0;
+        ok = ok && drmModeAtomicAddProperty(request, id, plane->propertyId(P::CrtcX), geometry.x()) > 0;
+        ok = ok && drmModeAtomicAddProperty(request, id, plane->propertyId(P::CrtcY), geometry.y()) > 0;
+        ok = ok && drmModeAtomicAddProperty(request, id, plane->propertyId(P::CrtcW), geometry.width()) > 0;
+        ok = ok && drmModeAtomicAddProperty(request, id, plane->propertyId(P::CrtcH), geometry.height()) > 0;
+        return ok;
+    };
+    if (!addPlane(m_primaryPlane, m_crtcId, primary, QRect(QPoint(0, 0), size()))) {
+        return false;
+    }
+    if (!m_overlayPlane || (!overlay && !m_overlayEnabled)) {
+        return true;
+    }
+    return addPlane(m_overlayPlane, m_crtcId, overlay, overlay ? overlayGeometry : QRect());
+}
+
 void DrmOutput::pageFlipped()
 {
     if (!m_currentBuffer) {
@@ -1051,6 +1290,60 @@ void DrmOutput::setGlobalPos(const QPoint &pos)
     }
 }
 
+DrmPlane::DrmPlane(DrmBackend *backend, quint32 id)
+    : m_backend(backend)
+    , m_id(id)
+{
+}
+
+bool DrmPlane::init()
+{
+    ScopedDrmPointer<_drmModePlane, &drmModeFreePlane> plane(drmModeGetPlane(m_backend->fd(), m_id));
+    if (!plane) {
+        return false;
+    }
+    m_possibleCrtcs = plane->possible_crtcs;
+    static const QVector<QByteArray> s_propertyNames = {
+        QByteArrayLiteral("type"),
+        QByteArrayLiteral("FB_ID"),
+        QByteArrayLiteral("CRTC_ID"),
+        QByteArrayLiteral("SRC_X"),
+        QByteArrayLiteral("SRC_Y"),
+        QByteArrayLiteral("SRC_W"),
+        QByteArrayLiteral("SRC_H"),
+        QByteArrayLiteral("CRTC_X"),
+        QByteArrayLiteral("CRTC_Y"),
+        QByteArrayLiteral("CRTC_W"),
+        QByteArrayLiteral("CRTC_H")
+    };
+    ScopedDrmPointer<_drmModeObjectProperties, &drmModeFreeObjectProperties> properties(
+        drmModeObjectGetProperties(m_backend->fd(), m_id, DRM_MODE_OBJECT_PLANE));
+    if (!properties) {
+        return false;
+    }
+    for (uint32_t i = 0; i < properties->count_props; ++i) {
+        ScopedDrmPointer<_drmModeProperty, &drmModeFreeProperty> property(drmModeGetProperty(m_backend->fd(), properties->props[i]));
+        if (!property) {
+            continue;
+        }
+        const int index = s_propertyNames.indexOf(QByteArray(property->name));
+        if (index == -1) {
+            continue;
+        }
+        m_propertyIds[index] = property->prop_id;
+        if (index == int(Property::Type)) {
+            m_type = Type(properties->prop_values[i]);
+        }
+    }
+    // all properties are required to assign buffers in an atomic commit
+    for (int i = 0; i < int(Property::Count); ++i) {
+        if (m_propertyIds[i] == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
 DrmBuffer::DrmBuffer(DrmBackend *backend, const QSize &size)
     : m_backend(backend)
     , m_size(size)
@@ -1104,6 +1397,19 @@ DrmBuffer::DrmBuffer(DrmBackend *backend, gbm_surface *surface)
 #endif
 }
 
+DrmBuffer::DrmBuffer(DrmBackend *backend, gbm_bo *bo)
+    : m_backend(backend)
+    , m_bo(bo)
+{
+#if HAVE_GBM
+    m_size = QSize(gbm_bo_get_width(m_bo), gbm_bo_get_height(m_bo));
+    m_stride = gbm_bo_get_stride(m_bo);
+    if (drmModeAddFB(m_backend->fd(), m_size.width(), m_size.height(), 24, 32, m_stride, gbm_bo_get_handle(m_bo).u32, &m_bufferId) != 0) {
+        qCWarning(KWIN_DRM) << "drmModeAddFB for imported buffer failed";
+    }
+#endif
+}
+
 DrmBuffer::~DrmBuffer()
 {
     m_backend->bufferDestroyed(this);
@@ -1120,6 +1426,11 @@ DrmBuffer::~DrmBuffer()
         drmIoctl(m_backend->fd(), DRM_IOCTL_MODE_DESTROY_DUMB, &destroyArgs);
     }
     releaseGbm();
+#if HAVE_GBM
+    if (m_bo && !m_surface) {
+        gbm_bo_destroy(m_bo);
+    }
+#endif
 }
 
 bool DrmBuffer::map(QImage::Format format)
@@ -1145,7 +1456,8 @@ bool DrmBuffer::map(QImage::Format format)
 void DrmBuffer::releaseGbm()
 {
 #if HAVE_GBM
-    if (m_bo) {
+    // an imported buffer object is owned by the DrmBuffer and stays until destruction
+    if (m_bo && m_surface) {
         gbm_surface_release_buffer(m_surface, m_bo);
         m_bo = nullptr;
     }
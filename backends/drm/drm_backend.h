@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QImage>
 #include <QPointer>
 #include <QSize>
+#include <xf86drm.h>
 #include <xf86drmMode.h>
 
 struct gbm_bo;
@@ -45,6 +46,7 @@ class UdevMonitor;
 
 class DrmBuffer;
 class DrmOutput;
+class DrmPlane;
 
 template <typename Pointer, void (*cleanupFunc)(Pointer*)>
 struct DrmCleanup
@@ -74,7 +76,21 @@ public:
     void init() override;
     DrmBuffer *createBuffer(const QSize &size);
     DrmBuffer *createBuffer(gbm_surface *surface);
-    void present(DrmBuffer *buffer, DrmOutput *output);
+    /**
+     * Creates a buffer for the imported @p bo, e.g. a client buffer to be scanned out directly.
+     * The DrmBuffer takes over the ownership of @p bo.
+     **/
+    DrmBuffer *createBuffer(gbm_bo *bo);
+    /**
+     * Page flips @p output to @p buffer. A @p blocking presentation blocks the Compositor
+     * until the page flip completed, otherwise the caller is responsible for throttling.
+     **/
+    bool present(DrmBuffer *buffer, DrmOutput *output, bool blocking = true);
+    /**
+     * Blocks the Compositor from starting new frames until a matching unblockCompositing().
+     **/
+    void blockCompositing();
+    void unblockCompositing();
 
     QSize size() const;
     int fd() const {
@@ -87,10 +103,23 @@ public:
         return m_buffers;
     }
     void bufferDestroyed(DrmBuffer *b);
+    /**
+     * Whether page flips are performed through atomic mode setting, which allows to
+     * use overlay planes. Enabled through the environment variable KWIN_DRM_AMS.
+     **/
+    bool atomicModeSetting() const {
+        return m_atomicModeSetting;
+    }
 
 Q_SIGNALS:
     void outputRemoved(KWin::DrmOutput *output);
     void outputAdded(KWin::DrmOutput *output);
+    void outputPageFlipped(KWin::DrmOutput *output);
+    /**
+     * Emitted when the session got active again. Pending page flips and compositing
+     * blocks got dropped and all outputs are blanked.
+     **/
+    void reactivated();
 
 private:
     static void pageFlipHandler(int fd, unsigned int frame, unsigned int sec, unsigned int usec, void *data);
@@ -103,6 +132,11 @@ private:
     void updateCursor();
     void hideCursor();
     void moveCursor();
+    /**
+     * Shows the current cursor buffer on all outputs and moves it to the current position,
+     * used when outputs got (re)enabled.
+     **/
+    void restoreCursor();
     void initCursor();
     quint32 findCrtc(drmModeRes *res, drmModeConnector *connector, bool *ok = nullptr);
     bool crtcIsUsed(quint32 crtc);
@@ -110,16 +144,34 @@ private:
     void readOutputsConfiguration();
     QByteArray generateOutputConfigurationUuid() const;
     DrmOutput *findOutput(quint32 connector);
+    void initPlanes();
+    DrmPlane *findPlane(int type, int crtcIndex) const;
     QScopedPointer<Udev> m_udev;
     QScopedPointer<UdevMonitor> m_udevMonitor;
     int m_fd = -1;
     int m_drmId = 0;
     QVector<DrmOutput*> m_outputs;
-    DrmBuffer *m_cursor[2];
-    int m_cursorIndex = 0;
+    /**
+     * Pre-allocated cursor plane buffers. Each holds the cursor image it got painted with,
+     * so switching back to a recently used cursor only requires showing the buffer again.
+     **/
+    struct CursorBuffer {
+        DrmBuffer *buffer = nullptr;
+        QImage image;
+        quint64 lastUsed = 0;
+    };
+    QVector<CursorBuffer> m_cursorBuffers;
+    int m_currentCursor = -1;
+    quint64 m_cursorUpdates = 0;
+    bool m_cursorVisible = false;
+    // the position last passed to the outputs, moves to the same position are skipped
+    QPoint m_cursorPos;
     int m_pageFlipsPending = 0;
+    int m_compositingBlocks = 0;
     bool m_active = false;
     QVector<DrmBuffer*> m_buffers;
+    bool m_atomicModeSetting = false;
+    QVector<DrmPlane*> m_planes;
 };
 
 class DrmOutput : public QObject
@@ -137,6 +189,13 @@ public:
     void hideCursor();
     void moveCursor(const QPoint &globalPos);
     bool present(DrmBuffer *buffer);
+    /**
+     * Shows @p buffer on the overlay plane at @p geometry in output coordinates with the next
+     * present(), a @c null buffer disables the overlay plane again. The configuration gets
+     * validated with a test only atomic commit together with the currently shown @p primary buffer.
+     * @returns @c false if there is no usable overlay plane or the test commit failed
+     **/
+    bool setOverlay(DrmBuffer *buffer, const QRect &geometry, DrmBuffer *primary);
     void pageFlipped();
     void init(drmModeConnector *connector);
     void restoreSaved();
@@ -160,6 +219,16 @@ public:
     QByteArray uuid() const {
         return m_uuid;
     }
+    /**
+     * Number of buffers used for presenting, read from the output configuration.
+     * Two means double buffering, three allows to render a frame while another one waits for the page flip.
+     **/
+    int swapChainDepth() const {
+        return m_swapChainDepth;
+    }
+    bool isPageFlipPending() const {
+        return m_currentBuffer != nullptr;
+    }
 
 Q_SIGNALS:
     void dpmsChanged();
@@ -175,11 +244,23 @@ private:
     void reenableDpms();
     void initUuid();
     void setGlobalPos(const QPoint &pos);
+    bool presentAtomic(DrmBuffer *buffer);
+    /**
+     * Adds the plane properties for the primary and the overlay plane to @p request.
+     **/
+    bool addPlanes(drmModeAtomicReq *request, DrmBuffer *primary, DrmBuffer *overlay, const QRect &overlayGeometry) const;
 
     DrmBackend *m_backend;
     QPoint m_globalPos;
     quint32 m_crtcId = 0;
+    int m_crtcIndex = 0;
     quint32 m_connector = 0;
+    DrmPlane *m_primaryPlane = nullptr;
+    DrmPlane *m_overlayPlane = nullptr;
+    DrmBuffer *m_overlayBuffer = nullptr;
+    QRect m_overlayGeometry;
+    // whether the overlay plane needs to be disabled with the next commit
+    bool m_overlayEnabled = false;
     quint32 m_lastStride = 0;
     bool m_lastGbm = false;
     drmModeModeInfo m_mode;
@@ -196,6 +277,62 @@ private:
     ScopedDrmPointer<_drmModeProperty, &drmModeFreeProperty> m_dpms;
     DpmsMode m_dpmsMode = DpmsMode::On;
     QByteArray m_uuid;
+    int m_swapChainDepth = 2;
+    bool m_blockingPageFlip = false;
+};
+
+/**
+ * A hardware plane as exposed with universal planes, used for atomic mode setting.
+ **/
+class DrmPlane
+{
+public:
+    enum class Type {
+        Overlay = DRM_PLANE_TYPE_OVERLAY,
+        Primary = DRM_PLANE_TYPE_PRIMARY,
+        Cursor = DRM_PLANE_TYPE_CURSOR
+    };
+    enum class Property {
+        Type,
+        FbId,
+        CrtcId,
+        SrcX,
+        SrcY,
+        SrcW,
+        SrcH,
+        CrtcX,
+        CrtcY,
+        CrtcW,
+        CrtcH,
+        Count
+    };
+    quint32 id() const {
+        return m_id;
+    }
+    Type type() const {
+        return m_type;
+    }
+    bool isCrtcSupported(int crtcIndex) const {
+        return m_possibleCrtcs & (1 << crtcIndex);
+    }
+    quint32 propertyId(Property property) const {
+        return m_propertyIds[int(property)];
+    }
+    DrmOutput *output() const {
+        return m_output;
+    }
+
+private:
+    friend class DrmBackend;
+    friend class DrmOutput;
+    DrmPlane(DrmBackend *backend, quint32 id);
+    bool init();
+    DrmBackend *m_backend;
+    quint32 m_id;
+    Type m_type = Type::Overlay;
+    quint32 m_possibleCrtcs = 0;
+    quint32 m_propertyIds[int(Property::Count)] = {};
+    DrmOutput *m_output = nullptr;
 };
 
 class DrmBuffer
@@ -231,6 +368,7 @@ private:
     friend class DrmBackend;
     DrmBuffer(DrmBackend *backend, const QSize &size);
     DrmBuffer(DrmBackend *backend, gbm_surface *surface);
+    DrmBuffer(DrmBackend *backend, gbm_bo *bo);
     DrmBackend *m_backend;
     gbm_surface *m_surface = nullptr;
     gbm_bo *m_bo = nullptr;
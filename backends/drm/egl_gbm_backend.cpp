@@ -24,8 +24,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "logging.h"
 #include "options.h"
 #include "screens.h"
+#include "toplevel.h"
+#include "virtual_terminal.h"
 // kwin libs
 #include <kwinglplatform.h>
+// KWayland
+#include <KWayland/Server/buffer_interface.h>
+#include <KWayland/Server/surface_interface.h>
 // Qt
 #include <QOpenGLContext>
 // system
@@ -43,6 +48,8 @@ EglGbmBackend::EglGbmBackend(DrmBackend *b)
     setIsDirectRendering(true);
     setSyncsToVBlank(true);
     connect(m_backend, &DrmBackend::outputAdded, this, &EglGbmBackend::createOutput);
+    connect(m_backend, &DrmBackend::outputPageFlipped, this, &EglGbmBackend::outputPageFlipped);
+    connect(m_backend, &DrmBackend::reactivated, this, &EglGbmBackend::reactivated);
     connect(m_backend, &DrmBackend::outputRemoved, this,
         [this] (DrmOutput *output) {
             auto it = std::find_if(m_outputs.begin(), m_outputs.end(),
@@ -55,6 +62,7 @@ EglGbmBackend::EglGbmBackend(DrmBackend *b)
             }
             cleanupOutput(*it);
             m_outputs.erase(it);
+            updateCompositingBlock();
         }
     );
 }
@@ -78,6 +86,15 @@ void EglGbmBackend::cleanupSurfaces()
 void EglGbmBackend::cleanupOutput(const Output &o)
 {
     // TODO: cleanup front buffer?
+    qDeleteAll(o.queuedBuffers);
+    releaseClientBuffer(o.scanout);
+    releaseClientBuffer(o.overlay);
+    for (const ClientBuffer &clientBuffer : o.replacedClientBuffers) {
+        releaseClientBuffer(clientBuffer);
+    }
+    for (const ClientBuffer &clientBuffer : o.flipReleasedClientBuffers) {
+        releaseClientBuffer(clientBuffer);
+    }
     if (o.eglSurface != EGL_NO_SURFACE) {
         eglDestroySurface(eglDisplay(), o.eglSurface);
     }
@@ -233,10 +250,20 @@ void EglGbmBackend::present()
 void EglGbmBackend::presentOnOutput(EglGbmBackend::Output &o)
 {
     eglSwapBuffers(eglDisplay(), o.eglSurface);
-    auto oldBuffer = o.buffer;
-    o.buffer = m_backend->createBuffer(o.gbmSurface);
-    m_backend->present(o.buffer, o.output);
-    delete oldBuffer;
+    DrmBuffer *buffer = m_backend->createBuffer(o.gbmSurface);
+    const int depth = o.output->swapChainDepth();
+    if (depth <= 2) {
+        presentBuffer(o, buffer, true);
+    } else if (!o.output->isPageFlipPending() && o.queuedBuffers.isEmpty()) {
+        presentBuffer(o, buffer, false);
+    } else {
+        // the frame gets flipped to as soon as the pending page flip completed,
+        // compositing is blocked before the queue can overflow
+        o.queuedBuffers.enqueue(buffer);
+        o.statistics.queued++;
+        o.statistics.maxQueueDepth = qMax(o.statistics.maxQueueDepth, o.queuedBuffers.count());
+    }
+    updateCompositingBlock();
     if (supportsBufferAge()) {
         eglQuerySurface(eglDisplay(), o.eglSurface, EGL_BUFFER_AGE_EXT, &o.bufferAge);
     }
@@ -280,6 +307,226 @@ QRegion EglGbmBackend::prepareRenderingForScreen(int screenId)
     return QRegion();
 }
 
+void EglGbmBackend::presentBuffer(Output &o, DrmBuffer *buffer, bool blocking)
+{
+    auto oldBuffer = o.buffer;
+    o.buffer = buffer;
+    const bool presented = m_backend->present(o.buffer, o.output, blocking);
+    delete oldBuffer;
+    o.statistics.presented++;
+    if (o.scanout.drmBuffer) {
+        o.replacedClientBuffers << o.scanout;
+        o.scanout = ClientBuffer();
+    }
+    if (presented) {
+        replacedClientBuffersPresented(o);
+    }
+}
+
+void EglGbmBackend::outputPageFlipped(DrmOutput *output)
+{
+    auto it = std::find_if(m_outputs.begin(), m_outputs.end(),
+        [output] (const Output &o) {
+            return o.output == output;
+        }
+    );
+    if (it == m_outputs.end()) {
+        return;
+    }
+    // the client buffers replaced by this page flip are no longer shown
+    releaseFlippedClientBuffers(*it);
+    if ((*it).queuedBuffers.isEmpty()) {
+        return;
+    }
+    presentBuffer(*it, (*it).queuedBuffers.dequeue(), false);
+    updateCompositingBlock();
+}
+
+void EglGbmBackend::reactivated()
+{
+    for (Output &o : m_outputs) {
+        qDeleteAll(o.queuedBuffers);
+        o.queuedBuffers.clear();
+        // released with the page flip of the next frame
+        if (o.scanout.drmBuffer) {
+            o.replacedClientBuffers << o.scanout;
+            o.scanout = ClientBuffer();
+        }
+        removeOverlay(o);
+        o.bufferAge = 0;
+        o.damageHistory.clear();
+    }
+    // the drm backend dropped all its compositing blocks
+    m_compositingBlocked = false;
+}
+
+void EglGbmBackend::updateCompositingBlock()
+{
+    const bool block = std::any_of(m_outputs.constBegin(), m_outputs.constEnd(),
+        [] (const Output &o) {
+            const int depth = o.output->swapChainDepth();
+            return depth > 2 && o.queuedBuffers.count() >= depth - 2;
+        }
+    );
+    if (block == m_compositingBlocked) {
+        return;
+    }
+    m_compositingBlocked = block;
+    if (block) {
+        m_backend->blockCompositing();
+    } else {
+        m_backend->unblockCompositing();
+    }
+}
+
+QString EglGbmBackend::supportInformation() const
+{
+    QString support;
+    for (const Output &o : m_outputs) {
+        support.append(QStringLiteral("Output %1: swap chain depth %2, %3 frames presented, %4 queued, maximum queue depth %5\n")
+            .arg(o.output->name())
+            .arg(o.output->swapChainDepth())
+            .arg(o.statistics.presented)
+            .arg(o.statistics.queued)
+            .arg(o.statistics.maxQueueDepth));
+        support.append(QStringLiteral("Output %1: %2 client buffers scanned out, %3 client buffers shown on the overlay plane\n")
+            .arg(o.output->name())
+            .arg(o.statistics.scannedOut)
+            .arg(o.statistics.overlays));
+    }
+    return support;
+}
+
+bool EglGbmBackend::directScanout(int screenId, Toplevel *toplevel)
+{
+    Output &o = m_outputs[screenId];
+    auto buffer = toplevel->surface()->buffer();
+    if (o.scanout.drmBuffer && o.scanout.buffer == buffer) {
+        // the client did not attach a new buffer, nothing changed on this screen
+        return true;
+    }
+    if (!o.output->isDpmsEnabled() || !VirtualTerminal::self()->isActive() || buffer->size() != o.output->size()) {
+        return false;
+    }
+    DrmBuffer *drmBuffer = importBuffer(buffer);
+    if (!drmBuffer) {
+        return false;
+    }
+    // the buffer covers the complete output, an overlay plane would be shown above it
+    removeOverlay(o);
+    if (!m_backend->present(drmBuffer, o.output)) {
+        delete drmBuffer;
+        return false;
+    }
+    if (o.scanout.drmBuffer) {
+        o.replacedClientBuffers << o.scanout;
+    }
+    replacedClientBuffersPresented(o);
+    o.scanout.drmBuffer = drmBuffer;
+    o.scanout.buffer = buffer;
+    o.scanout.geometry = QRect(QPoint(0, 0), o.output->size());
+    buffer->ref();
+    o.statistics.scannedOut++;
+    // the back buffers of the gbm surface did not get the updates which happened
+    // while scanning out, the next composited frame has to repaint everything
+    o.bufferAge = 0;
+    o.damageHistory.clear();
+    return true;
+}
+
+bool EglGbmBackend::assignOverlay(int screenId, Toplevel *toplevel)
+{
+    Output &o = m_outputs[screenId];
+    if (!toplevel) {
+        removeOverlay(o);
+        return false;
+    }
+    if (!m_backend->atomicModeSetting()) {
+        return false;
+    }
+    auto buffer = toplevel->surface()->buffer();
+    const QRect geometry = toplevel->geometry().translated(-o.output->geometry().topLeft());
+    if (o.overlay.drmBuffer && o.overlay.buffer == buffer && o.overlay.geometry == geometry) {
+        return true;
+    }
+    // the configuration gets tested against the primary buffer currently shown
+    DrmBuffer *primary = o.scanout.drmBuffer ? o.scanout.drmBuffer : o.buffer;
+    DrmBuffer *drmBuffer = primary ? importBuffer(buffer) : nullptr;
+    if (!drmBuffer) {
+        removeOverlay(o);
+        return false;
+    }
+    if (!o.output->setOverlay(drmBuffer, geometry, primary)) {
+        delete drmBuffer;
+        removeOverlay(o);
+        return false;
+    }
+    if (o.overlay.drmBuffer) {
+        // released once the page flip showing the new buffer completed
+        o.replacedClientBuffers << o.overlay;
+    }
+    o.overlay.drmBuffer = drmBuffer;
+    o.overlay.buffer = buffer;
+    o.overlay.geometry = geometry;
+    buffer->ref();
+    o.statistics.overlays++;
+    return true;
+}
+
+void EglGbmBackend::removeOverlay(Output &o)
+{
+    if (!o.overlay.drmBuffer) {
+        return;
+    }
+    o.output->setOverlay(nullptr, QRect(), nullptr);
+    // the plane only gets disabled with the next page flip, the buffer is shown until then
+    o.replacedClientBuffers << o.overlay;
+    o.overlay = ClientBuffer();
+}
+
+DrmBuffer *EglGbmBackend::importBuffer(KWayland::Server::BufferInterface *buffer)
+{
+    gbm_bo *bo = gbm_bo_import(m_device, GBM_BO_IMPORT_WL_BUFFER, buffer->resource(), GBM_BO_USE_SCANOUT);
+    if (!bo) {
+        return nullptr;
+    }
+    const uint32_t format = gbm_bo_get_format(bo);
+    if (format != GBM_FORMAT_XRGB8888 && format != GBM_FORMAT_ARGB8888) {
+        gbm_bo_destroy(bo);
+        return nullptr;
+    }
+    // the DrmBuffer owns the imported buffer object from here on
+    DrmBuffer *drmBuffer = m_backend->createBuffer(bo);
+    if (drmBuffer->bufferId() == 0) {
+        delete drmBuffer;
+        return nullptr;
+    }
+    return drmBuffer;
+}
+
+void EglGbmBackend::releaseClientBuffer(const ClientBuffer &clientBuffer)
+{
+    delete clientBuffer.drmBuffer;
+    if (clientBuffer.buffer) {
+        clientBuffer.buffer->unref();
+    }
+}
+
+void EglGbmBackend::replacedClientBuffersPresented(Output &o)
+{
+    // the page flip to the new buffers is only queued, the replaced ones stay on screen until it completed
+    o.flipReleasedClientBuffers << o.replacedClientBuffers;
+    o.replacedClientBuffers.clear();
+}
+
+void EglGbmBackend::releaseFlippedClientBuffers(Output &o)
+{
+    for (const ClientBuffer &clientBuffer : o.flipReleasedClientBuffers) {
+        releaseClientBuffer(clientBuffer);
+    }
+    o.flipReleasedClientBuffers.clear();
+}
+
 void EglGbmBackend::endRenderingFrame(const QRegion &renderedRegion, const QRegion &damagedRegion)
 {
     Q_UNUSED(renderedRegion)
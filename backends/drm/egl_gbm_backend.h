@@ -22,9 +22,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "abstract_egl_backend.h"
 #include "scene_opengl.h"
 
+#include <QPointer>
+#include <QQueue>
+
 struct gbm_device;
 struct gbm_surface;
 
+namespace KWayland
+{
+namespace Server
+{
+class BufferInterface;
+}
+}
+
 namespace KWin
 {
 class DrmBackend;
@@ -48,6 +59,9 @@ public:
     bool usesOverlayWindow() const override;
     bool perScreenRendering() const override;
     QRegion prepareRenderingForScreen(int screenId) override;
+    bool directScanout(int screenId, Toplevel *toplevel) override;
+    bool assignOverlay(int screenId, Toplevel *toplevel) override;
+    QString supportInformation() const override;
     void init() override;
 
 protected:
@@ -58,6 +72,14 @@ private:
     bool initializeEgl();
     bool initBufferConfigs();
     bool initRenderingContext();
+    /**
+     * @brief A client buffer shown without compositing and its framebuffer.
+     */
+    struct ClientBuffer {
+        DrmBuffer *drmBuffer = nullptr;
+        QPointer<KWayland::Server::BufferInterface> buffer;
+        QRect geometry;
+    };
     struct Output {
         DrmOutput *output = nullptr;
         DrmBuffer *buffer = nullptr;
@@ -68,14 +90,52 @@ private:
         * @brief The damage history for the past 10 frames.
         */
         QList<QRegion> damageHistory;
+        ClientBuffer scanout;
+        ClientBuffer overlay;
+        /**
+        * @brief Client buffers replaced since the last presentation, they are still shown until it got flipped.
+        */
+        QVector<ClientBuffer> replacedClientBuffers;
+        /**
+        * @brief Client buffers replaced by the pending page flip, released once it completed.
+        */
+        QVector<ClientBuffer> flipReleasedClientBuffers;
+        /**
+        * @brief Rendered buffers waiting for the pending page flip, only used with a swap chain depth above two.
+        */
+        QQueue<DrmBuffer*> queuedBuffers;
+        struct {
+            quint64 presented = 0;
+            quint64 queued = 0;
+            int maxQueueDepth = 0;
+            quint64 scannedOut = 0;
+            quint64 overlays = 0;
+        } statistics;
     };
     bool makeContextCurrent(const Output &output);
     void presentOnOutput(Output &output);
     void cleanupOutput(const Output &output);
+    DrmBuffer *importBuffer(KWayland::Server::BufferInterface *buffer);
+    void releaseClientBuffer(const ClientBuffer &clientBuffer);
+    void replacedClientBuffersPresented(Output &output);
+    void releaseFlippedClientBuffers(Output &output);
+    void removeOverlay(Output &output);
+    void presentBuffer(Output &output, DrmBuffer *buffer, bool blocking);
+    void outputPageFlipped(DrmOutput *output);
+    /**
+     * Drops the frames queued before the session got inactive and forgets the client
+     * buffers shown on the planes, the outputs got blanked in between.
+     **/
+    void reactivated();
+    /**
+     * Blocks the compositor while the buffer queue of any output is full.
+     **/
+    void updateCompositingBlock();
     void createOutput(DrmOutput *output);
     DrmBackend *m_backend;
     gbm_device *m_device = nullptr;
     QVector<Output> m_outputs;
+    bool m_compositingBlocked = false;
     friend class EglGbmTexture;
 };
 
@@ -890,7 +890,8 @@ void Client::updateVisibility()
     }
     info->setState(0, NET::Hidden);
     if (!isOnCurrentDesktop()) {
-        if (compositing() && options->hiddenPreviews() != HiddenPreviewsNever)
+        if (compositing() && options->hiddenPreviews() != HiddenPreviewsNever
+                && (options->hiddenPreviews() != HiddenPreviewsRecentDesktops || workspace()->isDesktopResident(desktop())))
             internalKeep();
         else
             internalHide();
@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "unmanaged.h"
 #include "deleted.h"
 #include "effects.h"
+#include "lanczosfilter.h"
 #include "overlaywindow.h"
 #include "scene.h"
 #include "scene_xrender.h"
@@ -36,6 +37,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "shadow.h"
 #include "useractions.h"
 #include "compositingprefs.h"
+#include "compositingconnection.h"
 #include "xcbutils.h"
 #include "abstract_backend.h"
 #include "shell_client.h"
@@ -45,6 +47,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <KWayland/Server/surface_interface.h>
 
 #include <stdio.h>
+#include <algorithm>
 
 #include <QtConcurrentRun>
 #include <QFutureWatcher>
@@ -104,6 +107,8 @@ Compositor::Compositor(QObject* workspace)
     unredirectTimer.setSingleShot(true);
     compositeResetTimer.setSingleShot(true);
     nextPaintReference.invalidate(); // Initialize the timer
+    m_withheldFrameCallbackTimer.setSingleShot(true);
+    connect(&m_withheldFrameCallbackTimer, &QTimer::timeout, this, &Compositor::sendWithheldFrameCallbacks);
 
     // 2 sec which should be enough to restart the compositor
     static const int compositorLostMessageDelay = 2000;
@@ -279,6 +284,11 @@ void Compositor::slotCompositingOptionsInitialized()
         return;
     }
 
+    if (kwinApp()->operationMode() == Application::OperationModeX11) {
+        m_compositingConnection = CompositingConnection::create(this);
+        m_damageEvents = qstrcmp(qgetenv("KWIN_DAMAGE_EVENTS"), "1") == 0;
+    }
+
     if (Workspace::self()) {
         startupWithWorkspace();
     } else {
@@ -286,6 +296,25 @@ void Compositor::slotCompositingOptionsInitialized()
     }
 }
 
+xcb_connection_t *Compositor::damageConnection() const
+{
+    if (m_compositingConnection) {
+        return m_compositingConnection->connection();
+    }
+    return connection();
+}
+
+QString Compositor::supportInformation() const
+{
+    return QStringLiteral("Damage tracking: %1\n"
+                          "Damaged windows in last frame: %2\n"
+                          "Damage requests in last frame: %3 (%4 region fetches)\n")
+        .arg(m_damageEvents ? QStringLiteral("DamageNotify rectangles") : QStringLiteral("region fetch"))
+        .arg(m_lastDamageStatistics.damagedWindows)
+        .arg(m_lastDamageStatistics.requests)
+        .arg(m_lastDamageStatistics.regionFetches);
+}
+
 void Compositor::claimCompositorSelection()
 {
     if (!cm_selection && kwinApp()->x11Connection()) {
@@ -378,10 +407,14 @@ void Compositor::finish()
         c->finishCompositing();
         xcb_composite_unredirect_subwindows(connection(), rootWindow(), XCB_COMPOSITE_REDIRECT_MANUAL);
     }
+    delete m_compositingConnection;
+    m_compositingConnection = nullptr;
     delete effects;
     effects = NULL;
     delete m_scene;
     m_scene = NULL;
+    m_withheldFrameCallbacks.clear();
+    m_withheldFrameCallbackTimer.stop();
     compositeTimer.stop();
     repaints_region = QRegion();
     if (Workspace::self()) {
@@ -654,20 +687,37 @@ void Compositor::performCompositing()
         return;
     }
 
+    // give coalesced input the chance to be delivered before the frame
+    emit aboutToComposite();
+
     // Create a list of all windows in the stacking order
     ToplevelList windows = Workspace::self()->xStackingOrder();
     ToplevelList damaged;
 
     // Reset the damage state of each window and fetch the damage region
     // without waiting for a reply
+    DamageStatistics damageStatistics;
     foreach (Toplevel *win, windows) {
-        if (win->resetAndFetchDamage())
+        if (win->resetAndFetchDamage()) {
             damaged << win;
+            if (win->isDamageReplyPending()) {
+                // create region, subtract, fetch, destroy region
+                damageStatistics.requests += 4;
+                damageStatistics.regionFetches++;
+            } else if (kwinApp()->operationMode() == Application::OperationModeX11) {
+                damageStatistics.requests++;
+            }
+        }
     }
+    damageStatistics.damagedWindows = damaged.count();
+    m_lastDamageStatistics = damageStatistics;
 
     if (damaged.count() > 0) {
         m_scene->triggerFence();
         xcb_flush(connection());
+        if (m_compositingConnection) {
+            xcb_flush(m_compositingConnection->connection());
+        }
     }
 
     // Move elevated windows to the top of the stacking order
@@ -679,16 +729,16 @@ void Compositor::performCompositing()
 
     // Get the replies
     foreach (Toplevel *win, damaged) {
-        // Discard the cached lanczos texture
+        win->getDamageRegionReply();
+
+        // Filter the damaged parts of the cached lanczos thumbnails again
         if (win->effectWindow()) {
-            const QVariant texture = win->effectWindow()->data(LanczosCacheRole);
-            if (texture.isValid()) {
-                delete static_cast<GLTexture *>(texture.value<void*>());
-                win->effectWindow()->setData(LanczosCacheRole, QVariant());
-            }
+            LanczosCache::addDamage(win->effectWindow(), win->damage());
         }
-
-        win->getDamageRegionReply();
+    }
+    if (m_compositingConnection) {
+        // events read while waiting for the replies
+        m_compositingConnection->processEvents();
     }
 
     if (repaints_region.isEmpty() && !windowRepaintsPending()) {
@@ -727,11 +777,7 @@ void Compositor::performCompositing()
     m_timeSinceStart += m_timeSinceLastVBlank;
 
     if (kwinApp()->shouldUseWaylandForCompositing()) {
-        for (Toplevel *win : damaged) {
-            if (auto surface = win->surface()) {
-                surface->frameRendered(m_timeSinceStart);
-            }
-        }
+        sendFrameCallbacks(damaged);
     }
 
     compositeTimer.stop(); // stop here to ensure *we* cause the next repaint schedule - not some effect through m_scene->paint()
@@ -747,6 +793,72 @@ void Compositor::performCompositing()
     }
 }
 
+void Compositor::sendFrameCallbacks(const QList<Toplevel*> &damaged)
+{
+    const int interval = options->hiddenFrameCallbackInterval();
+    // callbacks withheld in an earlier frame are sent as soon as the window gets visible again
+    for (auto it = m_withheldFrameCallbacks.begin(); it != m_withheldFrameCallbacks.end();) {
+        Toplevel *win = (*it).window.data();
+        if (!win || interval <= 0 || m_scene->isWindowVisibleInLastFrame(win)) {
+            if (win && win->surface()) {
+                win->surface()->frameRendered(m_timeSinceStart);
+            }
+            it = m_withheldFrameCallbacks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (Toplevel *win : damaged) {
+        auto surface = win->surface();
+        if (!surface) {
+            continue;
+        }
+        if (interval <= 0 || m_scene->isWindowVisibleInLastFrame(win)) {
+            surface->frameRendered(m_timeSinceStart);
+            continue;
+        }
+        // the surface is occluded, a client driving its animation by frame callbacks
+        // does not need to render more frames than the interval allows
+        auto it = std::find_if(m_withheldFrameCallbacks.constBegin(), m_withheldFrameCallbacks.constEnd(),
+            [win] (const WithheldFrameCallback &callback) {
+                return callback.window.data() == win;
+            }
+        );
+        if (it != m_withheldFrameCallbacks.constEnd()) {
+            continue;
+        }
+        WithheldFrameCallback callback;
+        callback.window = win;
+        callback.since.start();
+        m_withheldFrameCallbacks << callback;
+    }
+    if (!m_withheldFrameCallbacks.isEmpty() && !m_withheldFrameCallbackTimer.isActive()) {
+        m_withheldFrameCallbackTimer.start(interval);
+    }
+}
+
+void Compositor::sendWithheldFrameCallbacks()
+{
+    const int interval = options->hiddenFrameCallbackInterval();
+    qint64 next = interval;
+    for (auto it = m_withheldFrameCallbacks.begin(); it != m_withheldFrameCallbacks.end();) {
+        Toplevel *win = (*it).window.data();
+        const qint64 elapsed = (*it).since.elapsed();
+        if (!win || elapsed >= interval) {
+            if (win && win->surface()) {
+                win->surface()->frameRendered(m_timeSinceStart);
+            }
+            it = m_withheldFrameCallbacks.erase(it);
+        } else {
+            next = qMin(next, interval - elapsed);
+            ++it;
+        }
+    }
+    if (!m_withheldFrameCallbacks.isEmpty()) {
+        m_withheldFrameCallbackTimer.start(next);
+    }
+}
+
 bool Compositor::windowRepaintsPending() const
 {
     foreach (Toplevel * c, Workspace::self()->clientList())
@@ -969,8 +1081,20 @@ bool Toplevel::setupCompositing()
         return false;
 
     if (kwinApp()->operationMode() == Application::OperationModeX11) {
-        damage_handle = xcb_generate_id(connection());
-        xcb_damage_create(connection(), damage_handle, frameId(), XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+        CompositingConnection *compositingConnection = Compositor::self()->compositingConnection();
+        if (compositingConnection) {
+            // the frame has to exist on the server before the other connection can refer to it,
+            // flushing does not order the requests of different connections, a round trip does
+            Xcb::sync();
+        }
+        xcb_connection_t *c = Compositor::self()->damageConnection();
+        m_damageFromEvents = Compositor::self()->usesDamageEvents();
+        damage_handle = xcb_generate_id(c);
+        xcb_damage_create(c, damage_handle, frameId(),
+                          m_damageFromEvents ? XCB_DAMAGE_REPORT_LEVEL_DELTA_RECTANGLES : XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+        if (compositingConnection) {
+            compositingConnection->addDamage(damage_handle, this);
+        }
     }
 
     damage_region = QRegion(0, 0, width(), height());
@@ -1000,14 +1124,21 @@ void Toplevel::finishCompositing(ReleaseReason releaseReason)
         delete effect_window;
     }
 
+    if (CompositingConnection *compositingConnection = Compositor::self()->compositingConnection()) {
+        compositingConnection->removeDamage(damage_handle);
+    }
     if (kwinApp()->operationMode() == Application::OperationModeX11 &&
             releaseReason != ReleaseReason::Destroyed) {
-        xcb_damage_destroy(connection(), damage_handle);
+        xcb_damage_destroy(Compositor::self()->damageConnection(), damage_handle);
     }
 
     damage_handle = XCB_NONE;
     damage_region = QRegion();
     repaints_region = QRegion();
+    m_damageFromEvents = false;
+    m_damageEventsOverflow = false;
+    m_damageEventCount = 0;
+    m_damageEventsRegion = QRegion();
     effect_window = NULL;
 }
 
@@ -1018,6 +1149,22 @@ void Toplevel::discardWindowPixmap()
         effectWindow()->sceneWindow()->pixmapDiscarded();
 }
 
+void Toplevel::processDamageNotifyEvent(xcb_damage_notify_event_t *e)
+{
+    if (m_damageFromEvents && !m_damageEventsOverflow) {
+        // Complex damage would make the region expensive and cause an event per rectangle,
+        // give up on accumulating and fetch the damage region instead.
+        static const int s_maxDamageEvents = 32;
+        if (++m_damageEventCount > s_maxDamageEvents) {
+            m_damageEventsOverflow = true;
+            m_damageEventsRegion = QRegion();
+        } else {
+            m_damageEventsRegion += QRect(e->area.x, e->area.y, e->area.width, e->area.height);
+        }
+    }
+    damageNotifyEvent();
+}
+
 void Toplevel::damageNotifyEvent()
 {
     m_isDamaged = true;
@@ -1061,7 +1208,23 @@ bool Toplevel::resetAndFetchDamage()
         return true;
     }
 
-    xcb_connection_t *conn = connection();
+    xcb_connection_t *conn = Compositor::self()->damageConnection();
+
+    if (m_damageFromEvents) {
+        const bool overflow = m_damageEventsOverflow;
+        m_damageEventsOverflow = false;
+        m_damageEventCount = 0;
+        if (!overflow) {
+            // The damage is already known from the events, just reset it on the server
+            // so that new damage generates new events. No round trip needed.
+            xcb_damage_subtract(conn, damage_handle, XCB_NONE, XCB_NONE);
+            damage_region += m_damageEventsRegion;
+            repaints_region += m_damageEventsRegion;
+            m_damageEventsRegion = QRegion();
+            m_isDamaged = false;
+            return true;
+        }
+    }
 
     // Create a new region and copy the damage region to it,
     // resetting the damaged state.
@@ -1088,7 +1251,7 @@ void Toplevel::getDamageRegionReply()
 
     // Get the fetch-region reply
     xcb_xfixes_fetch_region_reply_t *reply =
-            xcb_xfixes_fetch_region_reply(connection(), m_regionCookie, 0);
+            xcb_xfixes_fetch_region_reply(Compositor::self()->damageConnection(), m_regionCookie, 0);
 
     if (!reply)
         return;
@@ -28,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // Qt
 #include <QObject>
 #include <QElapsedTimer>
+#include <QPointer>
 #include <QTimer>
 #include <QBasicTimer>
 #include <QRegion>
@@ -35,7 +36,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace KWin {
 
 class Client;
+class CompositingConnection;
 class Scene;
+class Toplevel;
 
 class CompositorSelectionOwner : public KSelectionOwner
 {
@@ -95,6 +98,29 @@ public:
         return m_scene;
     }
 
+    /**
+     * @returns The dedicated X connection for damage tracking, @c null if not used.
+     **/
+    CompositingConnection *compositingConnection() const {
+        return m_compositingConnection;
+    }
+    /**
+     * @returns The X connection on which the damage of windows is tracked.
+     **/
+    xcb_connection_t *damageConnection() const;
+    /**
+     * Whether the damage of windows is accumulated from the rectangles of the DamageNotify
+     * events instead of fetching the damage region for each damaged window each frame.
+     * Enabled by setting the environment variable @c KWIN_DAMAGE_EVENTS to @c 1.
+     **/
+    bool usesDamageEvents() const {
+        return m_damageEvents;
+    }
+    /**
+     * Information about the last composited frame for the support information.
+     **/
+    QString supportInformation() const;
+
     /**
      * @brief Checks whether the Compositor has already been created by the Workspace.
      *
@@ -186,6 +212,10 @@ public Q_SLOTS:
 Q_SIGNALS:
     void compositingToggled(bool active);
     void aboutToDestroy();
+    /**
+     * Emitted right before a new frame gets composited.
+     **/
+    void aboutToComposite();
 
 protected:
     void timerEvent(QTimerEvent *te);
@@ -208,9 +238,19 @@ private Q_SLOTS:
     void slotConfigChanged();
     void releaseCompositorSelection();
     void deleteUnusedSupportProperties();
+    /**
+     * Sends the frame callbacks withheld from hidden surfaces for longer than
+     * Options::hiddenFrameCallbackInterval.
+     **/
+    void sendWithheldFrameCallbacks();
 
 private:
     void claimCompositorSelection();
+    /**
+     * Sends the frame callbacks for the Wayland surfaces of @p damaged windows which got
+     * rendered. Surfaces which were not visible in the frame are throttled.
+     **/
+    void sendFrameCallbacks(const QList<Toplevel*> &damaged);
     void setCompositeTimer();
     bool windowRepaintsPending() const;
     /**
@@ -241,6 +281,20 @@ private:
     qint64 m_timeSinceLastVBlank;
     qint64 m_timeSinceStart = 0;
     Scene *m_scene;
+    CompositingConnection *m_compositingConnection = nullptr;
+    struct WithheldFrameCallback {
+        QPointer<Toplevel> window;
+        QElapsedTimer since;
+    };
+    QVector<WithheldFrameCallback> m_withheldFrameCallbacks;
+    QTimer m_withheldFrameCallbackTimer;
+    bool m_damageEvents = false;
+    struct DamageStatistics {
+        int damagedWindows = 0;
+        int requests = 0;
+        int regionFetches = 0;
+    };
+    DamageStatistics m_lastDamageStatistics;
     bool m_bufferSwapPending;
     bool m_composeAtSwapCompletion;
 
@@ -0,0 +1,110 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "compositingconnection.h"
+#include "toplevel.h"
+#include "utils.h"
+
+#include <QAbstractEventDispatcher>
+#include <QCoreApplication>
+#include <QSocketNotifier>
+
+#include <xcb/xfixes.h>
+#include <X11/Xlib.h>
+
+namespace KWin
+{
+
+CompositingConnection *CompositingConnection::create(QObject *parent)
+{
+    if (qstrcmp(qgetenv("KWIN_COMPOSITING_CONNECTION"), "1") != 0) {
+        return nullptr;
+    }
+    // the display KWin got started on, which is not necessarily $DISPLAY
+    const QByteArray displayName = display() ? QByteArray(DisplayString(display())) : qgetenv("DISPLAY");
+    xcb_connection_t *c = xcb_connect(displayName.isEmpty() ? nullptr : displayName.constData(), nullptr);
+    if (xcb_connection_has_error(c)) {
+        qCWarning(KWIN_CORE) << "Failed to open the compositing X connection";
+        xcb_disconnect(c);
+        return nullptr;
+    }
+    // extensions have to be initialized per connection
+    const xcb_query_extension_reply_t *damageExtension = xcb_get_extension_data(c, &xcb_damage_id);
+    const xcb_query_extension_reply_t *fixesExtension = xcb_get_extension_data(c, &xcb_xfixes_id);
+    if (!damageExtension || !damageExtension->present || !fixesExtension || !fixesExtension->present) {
+        qCWarning(KWIN_CORE) << "Damage or XFixes extension missing on the compositing X connection";
+        xcb_disconnect(c);
+        return nullptr;
+    }
+    auto damageCookie = xcb_damage_query_version_unchecked(c, XCB_DAMAGE_MAJOR_VERSION, XCB_DAMAGE_MINOR_VERSION);
+    auto fixesCookie = xcb_xfixes_query_version_unchecked(c, XCB_XFIXES_MAJOR_VERSION, XCB_XFIXES_MINOR_VERSION);
+    free(xcb_damage_query_version_reply(c, damageCookie, nullptr));
+    free(xcb_xfixes_query_version_reply(c, fixesCookie, nullptr));
+    qCDebug(KWIN_CORE) << "Using a dedicated X connection for damage tracking";
+    return new CompositingConnection(c, damageExtension->first_event, parent);
+}
+
+CompositingConnection::CompositingConnection(xcb_connection_t *c, uint8_t damageEventBase, QObject *parent)
+    : QObject(parent)
+    , m_connection(c)
+    , m_damageEventBase(damageEventBase)
+    , m_notifier(new QSocketNotifier(xcb_get_file_descriptor(c), QSocketNotifier::Read, this))
+{
+    connect(m_notifier, &QSocketNotifier::activated, this, &CompositingConnection::processEvents);
+    // replies read while waiting might have queued events without activating the notifier
+    connect(QCoreApplication::eventDispatcher(), &QAbstractEventDispatcher::aboutToBlock,
+            this, &CompositingConnection::processEvents);
+}
+
+CompositingConnection::~CompositingConnection()
+{
+    xcb_disconnect(m_connection);
+}
+
+void CompositingConnection::addDamage(xcb_damage_damage_t damage, Toplevel *window)
+{
+    m_damages.insert(damage, window);
+}
+
+void CompositingConnection::removeDamage(xcb_damage_damage_t damage)
+{
+    m_damages.remove(damage);
+}
+
+void CompositingConnection::processEvents()
+{
+    while (xcb_generic_event_t *event = xcb_poll_for_event(m_connection)) {
+        const uint8_t eventType = event->response_type & ~0x80;
+        if (!eventType) {
+            // e.g. BadDamage when destroying the damage of a window which got destroyed meanwhile
+            xcb_generic_error_t *error = reinterpret_cast<xcb_generic_error_t*>(event);
+            qCDebug(KWIN_CORE) << "XCB error on compositing connection:" << error->error_code
+                               << "resource id:" << error->resource_id;
+        } else if (eventType == m_damageEventBase + XCB_DAMAGE_NOTIFY) {
+            auto *damageEvent = reinterpret_cast<xcb_damage_notify_event_t*>(event);
+            if (Toplevel *window = m_damages.value(damageEvent->damage)) {
+                window->processDamageNotifyEvent(damageEvent);
+            }
+        }
+        free(event);
+    }
+    xcb_flush(m_connection);
+}
+
+}
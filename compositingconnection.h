@@ -0,0 +1,89 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_COMPOSITINGCONNECTION_H
+#define KWIN_COMPOSITINGCONNECTION_H
+
+#include <QHash>
+#include <QObject>
+
+#include <xcb/xcb.h>
+#include <xcb/damage.h>
+
+class QSocketNotifier;
+
+namespace KWin
+{
+
+class Toplevel;
+
+/**
+ * @brief A second X connection dedicated to the damage tracking of the Compositor.
+ *
+ * The damage objects of all windows are created on this connection, thus the DamageNotify
+ * events are delivered through it and the damage regions are fetched through it. The
+ * compositor no longer has to wait for replies queued behind window management requests
+ * on the main connection, and a flood of window management events does not delay the
+ * damage events.
+ *
+ * The connection is processed on the main thread through an own socket notifier. Only
+ * requests without a server grab dependency may be issued on it: the main connection
+ * might hold a server grab, which would block replies on this connection.
+ *
+ * Enabled by setting the environment variable @c KWIN_COMPOSITING_CONNECTION to @c 1.
+ **/
+class CompositingConnection : public QObject
+{
+    Q_OBJECT
+public:
+    virtual ~CompositingConnection();
+
+    /**
+     * Creates the CompositingConnection if enabled through the environment.
+     * @returns @c null if not enabled or if the connection could not be established
+     **/
+    static CompositingConnection *create(QObject *parent);
+
+    xcb_connection_t *connection() const {
+        return m_connection;
+    }
+
+    /**
+     * Registers the @p damage object created on this connection for @p window.
+     * DamageNotify events for it are passed to the @p window.
+     **/
+    void addDamage(xcb_damage_damage_t damage, Toplevel *window);
+    void removeDamage(xcb_damage_damage_t damage);
+
+    /**
+     * Dispatches all events already read from the connection.
+     **/
+    void processEvents();
+
+private:
+    CompositingConnection(xcb_connection_t *c, uint8_t damageEventBase, QObject *parent);
+    xcb_connection_t *m_connection;
+    uint8_t m_damageEventBase;
+    QSocketNotifier *m_notifier;
+    QHash<xcb_damage_damage_t, Toplevel*> m_damages;
+};
+
+}
+
+#endif
@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "atoms.h"
 #include "composite.h"
 #include "compositingprefs.h"
+#include "input_latency.h"
 #include "main.h"
 #include "placement.h"
 #include "kwinadaptor.h"
@@ -128,6 +129,20 @@ WRAP(QString, supportInformation)
 
 #undef WRAP
 
+void DBusInterface::setInputLatencyTracing(bool enabled)
+{
+    auto tracer = InputLatencyTracer::self();
+    if (enabled && !tracer->isEnabled()) {
+        tracer->reset();
+    }
+    tracer->setEnabled(enabled);
+}
+
+QString DBusInterface::inputLatencyInformation()
+{
+    return InputLatencyTracer::self()->information();
+}
+
 bool DBusInterface::startActivity(const QString &in0)
 {
 #ifdef KWIN_BUILD_ACTIVITIES
@@ -64,6 +64,15 @@ public Q_SLOTS: // METHODS
     bool stopActivity(const QString &in0);
     QString supportInformation();
     Q_NOREPLY void unclutterDesktop();
+    /**
+     * Enables or disables recording of input event latencies.
+     * Disabling keeps the recorded events until tracing gets enabled again.
+     **/
+    Q_NOREPLY void setInputLatencyTracing(bool enabled);
+    /**
+     * @returns latency histograms for each stage of the input event processing
+     **/
+    QString inputLatencyInformation();
 
 private Q_SLOTS:
     void becomeKWinService(const QString &service);
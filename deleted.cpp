@@ -22,7 +22,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "workspace.h"
 #include "client.h"
+#include "effects.h"
 #include "netinfo.h"
+#include "scene.h"
 #include "shadow.h"
 #include "decorations/decoratedclient.h"
 #include "decorations/decorationrenderer.h"
@@ -32,6 +34,65 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace KWin
 {
 
+namespace {
+
+/**
+ * Free list of memory blocks for Deleted. Only used from the main thread.
+ **/
+class DeletedPool
+{
+public:
+    ~DeletedPool() {
+        for (void *block : m_free) {
+            ::operator delete(block);
+        }
+    }
+    void *allocate() {
+        if (m_free.isEmpty()) {
+            if (m_free.capacity() < s_maxFree) {
+                m_free.reserve(s_maxFree);
+            }
+            return ::operator new(sizeof(Deleted));
+        }
+        return m_free.takeLast();
+    }
+    void release(void *block) {
+        if (m_free.count() >= s_maxFree) {
+            ::operator delete(block);
+            return;
+        }
+        m_free.append(block);
+    }
+
+private:
+    static const int s_maxFree = 64;
+    QVector<void*> m_free;
+};
+
+static DeletedPool s_pool;
+
+}
+
+void *Deleted::operator new(std::size_t size)
+{
+    if (size != sizeof(Deleted)) {
+        return ::operator new(size);
+    }
+    return s_pool.allocate();
+}
+
+void Deleted::operator delete(void *ptr, std::size_t size)
+{
+    if (!ptr) {
+        return;
+    }
+    if (size != sizeof(Deleted)) {
+        ::operator delete(ptr);
+        return;
+    }
+    s_pool.release(ptr);
+}
+
 Deleted::Deleted()
     : Toplevel()
     , delete_refcount(1)
@@ -117,6 +178,14 @@ void Deleted::unrefWindow()
 {
     if (--delete_refcount > 0)
         return;
+    // nothing will paint the window any more, release the pixmaps directly instead of
+    // keeping them till the delayed delete, e.g. many windows closing at once would
+    // otherwise keep all their pixmaps around at the same time
+    if (EffectWindowImpl *w = effectWindow()) {
+        if (Scene::Window *sceneWindow = w->sceneWindow()) {
+            sceneWindow->releasePixmaps();
+        }
+    }
     // needs to be delayed
     // a) when calling from effects, otherwise it'd be rather complicated to handle the case of the
     // window going away during a painting pass
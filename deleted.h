@@ -87,6 +87,13 @@ public:
     bool isFullScreen() const {
         return m_fullscreen;
     }
+
+    /**
+     * Deleted are allocated from a pool, as closing many windows at once (e.g. logout)
+     * creates and destroys a burst of them.
+     **/
+    static void *operator new(std::size_t size);
+    static void operator delete(void *ptr, std::size_t size);
 protected:
     virtual void debug(QDebug& stream) const;
     virtual bool shouldUnredirect() const;
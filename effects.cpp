@@ -30,6 +30,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "client.h"
 #include "cursor.h"
 #include "group.h"
+#include "lanczosfilter.h"
 #include "scene_xrender.h"
 #include "scene_qpainter.h"
 #include "unmanaged.h"
@@ -449,13 +450,25 @@ void EffectsHandlerImpl::postPaintScreen()
 
 void EffectsHandlerImpl::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int time)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->prePaintWindow(w, data, time);
-        --m_currentPaintWindowIterator;
+    EffectsIterator &iterator = s_concurrentPaintWindowIterator ? *s_concurrentPaintWindowIterator : m_currentPaintWindowIterator;
+    if (iterator != m_activeEffects.constEnd()) {
+        (*iterator++)->prePaintWindow(w, data, time);
+        --iterator;
     }
     // no special final code
 }
 
+thread_local EffectsHandlerImpl::EffectsIterator *EffectsHandlerImpl::s_concurrentPaintWindowIterator = nullptr;
+
+void EffectsHandlerImpl::prePaintWindowConcurrent(EffectWindow *w, WindowPrePaintData &data, int time)
+{
+    Q_ASSERT(m_prePaintWindowThreadSafe);
+    EffectsIterator iterator = m_activeEffects.constBegin();
+    s_concurrentPaintWindowIterator = &iterator;
+    prePaintWindow(w, data, time);
+    s_concurrentPaintWindowIterator = nullptr;
+}
+
 void EffectsHandlerImpl::paintWindow(EffectWindow* w, int mask, QRegion region, WindowPaintData& data)
 {
     if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
@@ -537,11 +550,15 @@ void EffectsHandlerImpl::startPaint()
 {
     m_activeEffects.clear();
     m_activeEffects.reserve(loaded_effects.count());
+    m_prePaintWindowThreadSafe = true;
     for(QVector< KWin::EffectPair >::const_iterator it = loaded_effects.constBegin(); it != loaded_effects.constEnd(); ++it) {
         if (it->second->isActive()) {
             m_activeEffects << it->second;
+            m_prePaintWindowThreadSafe = m_prePaintWindowThreadSafe && it->second->isPrePaintWindowThreadSafe();
         }
     }
+    // without active effects there is no work worth distributing over threads
+    m_prePaintWindowThreadSafe = m_prePaintWindowThreadSafe && !m_activeEffects.isEmpty();
     m_currentDrawWindowIterator = m_activeEffects.constBegin();
     m_currentPaintWindowIterator = m_activeEffects.constBegin();
     m_currentPaintScreenIterator = m_activeEffects.constBegin();
@@ -666,6 +683,15 @@ void EffectsHandlerImpl::setActiveFullScreenEffect(Effect* e)
     m_compositor->checkUnredirect();
 }
 
+bool EffectsHandlerImpl::hasActiveEffects() const
+{
+    return std::any_of(loaded_effects.constBegin(), loaded_effects.constEnd(),
+        [] (const EffectPair &pair) {
+            return pair.second->isActive();
+        }
+    );
+}
+
 Effect* EffectsHandlerImpl::activeFullScreenEffect() const
 {
     return fullscreen_effect;
@@ -1590,11 +1616,7 @@ EffectWindowImpl::EffectWindowImpl(Toplevel *toplevel)
 
 EffectWindowImpl::~EffectWindowImpl()
 {
-    QVariant cachedTextureVariant = data(LanczosCacheRole);
-    if (cachedTextureVariant.isValid()) {
-        GLTexture *cachedTexture = static_cast< GLTexture*>(cachedTextureVariant.value<void*>());
-        delete cachedTexture;
-    }
+    delete LanczosCache::fromWindow(this);
 }
 
 bool EffectWindowImpl::isPaintingEnabled()
@@ -199,6 +199,23 @@ public:
 
     // internal (used by kwin core or compositing code)
     void startPaint();
+    /**
+     * Whether at least one effect is active and all active effects support running
+     * prePaintWindow() concurrently.
+     * @see Effect::isPrePaintWindowThreadSafe
+     **/
+    bool isPrePaintWindowThreadSafe() const {
+        return m_prePaintWindowThreadSafe;
+    }
+    /**
+     * Runs the prePaintWindow() chain for @p w from a worker thread.
+     * Only allowed if isPrePaintWindowThreadSafe() returns @c true.
+     **/
+    void prePaintWindowConcurrent(EffectWindow *w, WindowPrePaintData &data, int time);
+    /**
+     * Whether any loaded effect is currently active, evaluated without starting a paint pass.
+     **/
+    bool hasActiveEffects() const;
     void grabbedKeyboardEvent(QKeyEvent* e);
     bool hasKeyboardGrab() const;
     void desktopResized(const QSize &size);
@@ -283,6 +300,9 @@ private:
     EffectsIterator m_currentPaintEffectFrameIterator;
     EffectsIterator m_currentPaintScreenIterator;
     EffectsIterator m_currentBuildQuadsIterator;
+    // chain position of prePaintWindow() on worker threads, see prePaintWindowConcurrent()
+    static thread_local EffectsIterator *s_concurrentPaintWindowIterator;
+    bool m_prePaintWindowThreadSafe = false;
     typedef QHash< QByteArray, QList< Effect*> > PropertyEffectMap;
     PropertyEffectMap m_propertiesForEffects;
     QHash<QByteArray, qulonglong> m_managedProperties;
@@ -46,6 +46,9 @@ public:
     int requestedEffectChainPosition() const override {
         return 50;
     }
+    bool isPrePaintWindowThreadSafe() const override {
+        return true;
+    }
 
     static bool supported();
 
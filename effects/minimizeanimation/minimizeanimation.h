@@ -48,6 +48,9 @@ public:
     int requestedEffectChainPosition() const override {
         return 50;
     }
+    bool isPrePaintWindowThreadSafe() const override {
+        return true;
+    }
 
 public Q_SLOTS:
     void slotWindowDeleted(KWin::EffectWindow *w);
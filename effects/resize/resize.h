@@ -47,6 +47,10 @@ public:
     int requestedEffectChainPosition() const override {
         return 60;
     }
+    bool isPrePaintWindowThreadSafe() const override {
+        // only reads the resized window and the animations of the passed in window
+        return true;
+    }
 
     bool isTextureScale() const {
         return m_features & TextureScale;
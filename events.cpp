@@ -746,7 +746,7 @@ bool Client::windowEvent(xcb_generic_event_t *e)
             updateShape();
         }
         if (eventType == Xcb::Extensions::self()->damageNotifyEvent() && reinterpret_cast<xcb_damage_notify_event_t*>(e)->drawable == frameId())
-            damageNotifyEvent();
+            processDamageNotifyEvent(reinterpret_cast<xcb_damage_notify_event_t*>(e));
         break;
     }
     return true; // eat all events
@@ -1491,7 +1491,7 @@ bool Unmanaged::windowEvent(xcb_generic_event_t *e)
             emit geometryShapeChanged(this, geometry());
         }
         if (eventType == Xcb::Extensions::self()->damageNotifyEvent())
-            damageNotifyEvent();
+            processDamageNotifyEvent(reinterpret_cast<xcb_damage_notify_event_t*>(e));
         break;
     }
     }
@@ -26,6 +26,95 @@ namespace KWin
 
 KWIN_SINGLETON_FACTORY_VARIABLE(FocusChain, s_manager)
 
+FocusChain::Chain::Chain()
+    : m_first(nullptr)
+    , m_last(nullptr)
+{
+}
+
+FocusChain::Chain::~Chain()
+{
+    Node *node = m_first;
+    while (node) {
+        Node *next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
+AbstractClient *FocusChain::Chain::previous(AbstractClient *client) const
+{
+    Node *node = m_nodes.value(client);
+    if (!node || !node->previous) {
+        return nullptr;
+    }
+    return node->previous->client;
+}
+
+void FocusChain::Chain::link(AbstractClient *client, Node *previous, Node *next)
+{
+    Q_ASSERT(!m_nodes.contains(client));
+    Node *node = new Node{client, previous, next};
+    if (previous) {
+        previous->next = node;
+    } else {
+        m_first = node;
+    }
+    if (next) {
+        next->previous = node;
+    } else {
+        m_last = node;
+    }
+    m_nodes.insert(client, node);
+}
+
+void FocusChain::Chain::append(AbstractClient *client)
+{
+    link(client, m_last, nullptr);
+}
+
+void FocusChain::Chain::prepend(AbstractClient *client)
+{
+    link(client, nullptr, m_first);
+}
+
+void FocusChain::Chain::insertBefore(AbstractClient *client, AbstractClient *reference)
+{
+    Node *node = m_nodes.value(reference);
+    if (!node) {
+        return;
+    }
+    link(client, node->previous, node);
+}
+
+void FocusChain::Chain::insertAfter(AbstractClient *client, AbstractClient *reference)
+{
+    Node *node = m_nodes.value(reference);
+    if (!node) {
+        return;
+    }
+    link(client, node, node->next);
+}
+
+void FocusChain::Chain::remove(AbstractClient *client)
+{
+    Node *node = m_nodes.take(client);
+    if (!node) {
+        return;
+    }
+    if (node->previous) {
+        node->previous->next = node->next;
+    } else {
+        m_first = node->next;
+    }
+    if (node->next) {
+        node->next->previous = node->previous;
+    } else {
+        m_last = node->previous;
+    }
+    delete node;
+}
+
 FocusChain::FocusChain(QObject *parent)
     : QObject(parent)
     , m_separateScreenFocus(false)
@@ -36,26 +125,34 @@ FocusChain::FocusChain(QObject *parent)
 
 FocusChain::~FocusChain()
 {
+    qDeleteAll(m_desktopFocusChains);
     s_manager = NULL;
 }
 
+FocusChain::Chain *FocusChain::desktopChain(uint desktop) const
+{
+    if (desktop == 0 || desktop > uint(m_desktopFocusChains.size())) {
+        return NULL;
+    }
+    return m_desktopFocusChains.at(desktop - 1);
+}
+
 void FocusChain::remove(AbstractClient *client)
 {
-    for (DesktopChains::iterator it = m_desktopFocusChains.begin();
-            it != m_desktopFocusChains.end();
-            ++it) {
-        it.value().removeAll(client);
+    for (Chain *chain : m_desktopFocusChains) {
+        chain->remove(client);
     }
-    m_mostRecentlyUsed.removeAll(client);
+    m_mostRecentlyUsed.remove(client);
 }
 
 void FocusChain::resize(uint previousSize, uint newSize)
 {
-    for (uint i = previousSize + 1; i <= newSize; ++i) {
-        m_desktopFocusChains.insert(i, QList<AbstractClient*>());
+    Q_UNUSED(previousSize)
+    while (uint(m_desktopFocusChains.size()) < newSize) {
+        m_desktopFocusChains.append(new Chain);
     }
-    for (uint i = previousSize; i > newSize; --i) {
-        m_desktopFocusChains.remove(i);
+    while (uint(m_desktopFocusChains.size()) > newSize) {
+        delete m_desktopFocusChains.takeLast();
     }
 }
 
@@ -66,20 +163,15 @@ AbstractClient *FocusChain::getForActivation(uint desktop) const
 
 AbstractClient *FocusChain::getForActivation(uint desktop, int screen) const
 {
-    DesktopChains::const_iterator it = m_desktopFocusChains.find(desktop);
-    if (it == m_desktopFocusChains.constEnd()) {
+    const Chain *chain = desktopChain(desktop);
+    if (!chain) {
         return NULL;
     }
-    const auto &chain = it.value();
-    for (int i = chain.size() - 1; i >= 0; --i) {
-        auto tmp = chain.at(i);
+    return chain->findLast([this, screen](AbstractClient *tmp) {
         // TODO: move the check into Client
-        if (tmp->isShown(false) && tmp->isOnCurrentActivity()
-            && ( !m_separateScreenFocus || tmp->screen() == screen)) {
-            return tmp;
-        }
-    }
-    return NULL;
+        return tmp->isShown(false) && tmp->isOnCurrentActivity()
+            && ( !m_separateScreenFocus || tmp->screen() == screen);
+    });
 }
 
 void FocusChain::update(AbstractClient *client, FocusChain::Change change)
@@ -92,12 +184,10 @@ void FocusChain::update(AbstractClient *client, FocusChain::Change change)
 
     if (client->isOnAllDesktops()) {
         // Now on all desktops, add it to focus chains it is not already in
-        for (DesktopChains::iterator it = m_desktopFocusChains.begin();
-                it != m_desktopFocusChains.end();
-                ++it) {
-            auto &chain = it.value();
+        for (int i = 0; i < m_desktopFocusChains.size(); ++i) {
+            Chain &chain = *m_desktopFocusChains.at(i);
             // Making first/last works only on current desktop, don't affect all desktops
-            if (it.key() == m_currentDesktop
+            if (uint(i + 1) == m_currentDesktop
                     && (change == MakeFirst || change == MakeLast)) {
                 if (change == MakeFirst) {
                     makeFirstInChain(client, chain);
@@ -110,14 +200,12 @@ void FocusChain::update(AbstractClient *client, FocusChain::Change change)
         }
     } else {
         // Now only on desktop, remove it anywhere else
-        for (DesktopChains::iterator it = m_desktopFocusChains.begin();
-                it != m_desktopFocusChains.end();
-                ++it) {
-            auto &chain = it.value();
-            if (client->isOnDesktop(it.key())) {
+        for (int i = 0; i < m_desktopFocusChains.size(); ++i) {
+            Chain &chain = *m_desktopFocusChains.at(i);
+            if (client->isOnDesktop(i + 1)) {
                 updateClientInChain(client, change, chain);
             } else {
-                chain.removeAll(client);
+                chain.remove(client);
             }
         }
     }
@@ -126,7 +214,7 @@ void FocusChain::update(AbstractClient *client, FocusChain::Change change)
     updateClientInChain(client, change, m_mostRecentlyUsed);
 }
 
-void FocusChain::updateClientInChain(AbstractClient *client, FocusChain::Change change, QList< AbstractClient * >& chain)
+void FocusChain::updateClientInChain(AbstractClient *client, FocusChain::Change change, Chain &chain)
 {
     if (change == MakeFirst) {
         makeFirstInChain(client, chain);
@@ -137,15 +225,15 @@ void FocusChain::updateClientInChain(AbstractClient *client, FocusChain::Change
     }
 }
 
-void FocusChain::insertClientIntoChain(AbstractClient *client, QList< AbstractClient * >& chain)
+void FocusChain::insertClientIntoChain(AbstractClient *client, Chain &chain)
 {
     if (chain.contains(client)) {
         return;
     }
     if (m_activeClient && m_activeClient != client &&
-            !chain.empty() && chain.last() == m_activeClient) {
+            chain.last() == m_activeClient) {
         // Add it after the active client
-        chain.insert(chain.size() - 1, client);
+        chain.insertBefore(client, m_activeClient);
     } else {
         // Otherwise add as the first one
         chain.append(client);
@@ -158,41 +246,35 @@ void FocusChain::moveAfterClient(AbstractClient *client, AbstractClient *referen
         return;
     }
 
-    for (DesktopChains::iterator it = m_desktopFocusChains.begin();
-            it != m_desktopFocusChains.end();
-            ++it) {
-        if (!client->isOnDesktop(it.key())) {
+    for (int i = 0; i < m_desktopFocusChains.size(); ++i) {
+        if (!client->isOnDesktop(i + 1)) {
             continue;
         }
-        moveAfterClientInChain(client, reference, it.value());
+        moveAfterClientInChain(client, reference, *m_desktopFocusChains.at(i));
     }
     moveAfterClientInChain(client, reference, m_mostRecentlyUsed);
 }
 
-void FocusChain::moveAfterClientInChain(AbstractClient *client, AbstractClient *reference, QList<AbstractClient *> &chain)
+void FocusChain::moveAfterClientInChain(AbstractClient *client, AbstractClient *reference, Chain &chain)
 {
-    if (!chain.contains(reference)) {
+    if (client == reference || !chain.contains(reference)) {
         return;
     }
+    chain.remove(client);
     if (AbstractClient::belongToSameApplication(reference, client)) {
-        chain.removeAll(client);
-        chain.insert(chain.indexOf(reference), client);
+        chain.insertBefore(client, reference);
     } else {
-        chain.removeAll(client);
-        for (int i = chain.size() - 1; i >= 0; --i) {
-            if (AbstractClient::belongToSameApplication(reference, chain.at(i))) {
-                chain.insert(i, client);
-                break;
-            }
+        AbstractClient *sameApplication = chain.findLast([reference](AbstractClient *c) {
+            return AbstractClient::belongToSameApplication(reference, c);
+        });
+        if (sameApplication) {
+            chain.insertBefore(client, sameApplication);
         }
     }
 }
 
 AbstractClient *FocusChain::firstMostRecentlyUsed() const
 {
-    if (m_mostRecentlyUsed.isEmpty()) {
-        return NULL;
-    }
     return m_mostRecentlyUsed.first();
 }
 
@@ -201,14 +283,13 @@ AbstractClient *FocusChain::nextMostRecentlyUsed(AbstractClient *reference) cons
     if (m_mostRecentlyUsed.isEmpty()) {
         return NULL;
     }
-    const int index = m_mostRecentlyUsed.indexOf(reference);
-    if (index == -1) {
+    if (!m_mostRecentlyUsed.contains(reference)) {
         return m_mostRecentlyUsed.first();
     }
-    if (index == 0) {
-        return m_mostRecentlyUsed.last();
+    if (AbstractClient *previous = m_mostRecentlyUsed.previous(reference)) {
+        return previous;
     }
-    return m_mostRecentlyUsed.at(index - 1);
+    return m_mostRecentlyUsed.last();
 }
 
 // copied from activation.cpp
@@ -221,49 +302,45 @@ bool FocusChain::isUsableFocusCandidate(AbstractClient *c, AbstractClient *prev)
 
 AbstractClient *FocusChain::nextForDesktop(AbstractClient *reference, uint desktop) const
 {
-    DesktopChains::const_iterator it = m_desktopFocusChains.find(desktop);
-    if (it == m_desktopFocusChains.end()) {
+    const Chain *chain = desktopChain(desktop);
+    if (!chain) {
         return NULL;
     }
-    const auto &chain = it.value();
-    for (int i = chain.size() - 1; i >= 0; --i) {
-        auto client = chain.at(i);
-        if (isUsableFocusCandidate(client, reference)) {
-            return client;
-        }
-    }
-    return NULL;
+    return chain->findLast([this, reference](AbstractClient *client) {
+        return isUsableFocusCandidate(client, reference);
+    });
 }
 
-void FocusChain::makeFirstInChain(AbstractClient *client, QList< AbstractClient * >& chain)
+void FocusChain::makeFirstInChain(AbstractClient *client, Chain &chain)
 {
-    chain.removeAll(client);
+    chain.remove(client);
     if (client->isMinimized()) { // add it before the first minimized ...
-        for (int i = chain.count()-1; i >= 0; --i) {
-            if (chain.at(i)->isMinimized()) {
-                chain.insert(i+1, client);
-                return;
-            }
+        AbstractClient *minimized = chain.findLast([](AbstractClient *c) {
+            return c->isMinimized();
+        });
+        if (minimized) {
+            chain.insertAfter(client, minimized);
+        } else {
+            chain.prepend(client); // ... or at end of chain
         }
-        chain.prepend(client); // ... or at end of chain
     } else {
         chain.append(client);
     }
 }
 
-void FocusChain::makeLastInChain(AbstractClient *client, QList< AbstractClient * >& chain)
+void FocusChain::makeLastInChain(AbstractClient *client, Chain &chain)
 {
-    chain.removeAll(client);
+    chain.remove(client);
     chain.prepend(client);
 }
 
 bool FocusChain::contains(AbstractClient *client, uint desktop) const
 {
-    DesktopChains::const_iterator it = m_desktopFocusChains.find(desktop);
-    if (it == m_desktopFocusChains.end()) {
+    const Chain *chain = desktopChain(desktop);
+    if (!chain) {
         return false;
     }
-    return it.value().contains(client);
+    return chain->contains(client);
 }
 
 } // namespace
@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // Qt
 #include <QObject>
 #include <QHash>
+#include <QVector>
 
 namespace KWin
 {
@@ -37,8 +38,9 @@ class AbstractClient;
  *
  * Internally this FocusChain holds multiple independent chains. There is one chain of most recently
  * used Clients which is primarily used by TabBox to build up the list of Clients for navigation.
- * The chains are organized as a normal QList of Clients with the most recently used Client being the
- * last item of the list, that is a LIFO like structure.
+ * The chains are organized as doubly linked lists of Clients with the most recently used Client being
+ * the last item of the list, that is a LIFO like structure. Each chain also maps the Clients to their
+ * nodes, so that moving or removing a Client does not depend on the length of the chain.
  *
  * In addition there is one chain for each virtual desktop which is used to determine which Client
  * should get activated when the user switches to another virtual desktop.
@@ -189,6 +191,61 @@ public Q_SLOTS:
     bool isUsableFocusCandidate(AbstractClient *c, AbstractClient *prev) const;
 
 private:
+    /**
+     * @brief A single focus chain.
+     *
+     * The Clients are kept in a doubly linked list from the least recently used Client (first) to
+     * the most recently used Client (last) together with a hash from the Client to its node.
+     * This makes lookup, insertion and removal independent of the length of the chain.
+     **/
+    class Chain
+    {
+    public:
+        Chain();
+        ~Chain();
+        bool contains(AbstractClient *client) const;
+        bool isEmpty() const;
+        /**
+         * @return The least recently used Client or @c null if the chain is empty.
+         **/
+        AbstractClient *first() const;
+        /**
+         * @return The most recently used Client or @c null if the chain is empty.
+         **/
+        AbstractClient *last() const;
+        /**
+         * @return The Client before @p client or @c null if @p client is the first one or not in the chain.
+         **/
+        AbstractClient *previous(AbstractClient *client) const;
+        void append(AbstractClient *client);
+        void prepend(AbstractClient *client);
+        /**
+         * Inserts @p client before @p reference. Does nothing if @p reference is not in the chain.
+         **/
+        void insertBefore(AbstractClient *client, AbstractClient *reference);
+        /**
+         * Inserts @p client after @p reference. Does nothing if @p reference is not in the chain.
+         **/
+        void insertAfter(AbstractClient *client, AbstractClient *reference);
+        void remove(AbstractClient *client);
+        /**
+         * @return The last Client in the chain for which @p predicate returns @c true or @c null.
+         **/
+        template <typename Predicate>
+        AbstractClient *findLast(Predicate predicate) const;
+
+    private:
+        Q_DISABLE_COPY(Chain)
+        struct Node {
+            AbstractClient *client;
+            Node *previous;
+            Node *next;
+        };
+        void link(AbstractClient *client, Node *previous, Node *next);
+        QHash<AbstractClient*, Node*> m_nodes;
+        Node *m_first;
+        Node *m_last;
+    };
     /**
      * @brief Makes @p client the first Client in the given focus @p chain.
      *
@@ -199,7 +256,7 @@ private:
      * @param chain The focus chain to operate on
      * @return void
      **/
-    void makeFirstInChain(AbstractClient *client, QList<AbstractClient*> &chain);
+    void makeFirstInChain(AbstractClient *client, Chain &chain);
     /**
      * @brief Makes @p client the last Client in the given focus @p chain.
      *
@@ -210,13 +267,17 @@ private:
      * @param chain The focus chain to operate on
      * @return void
      **/
-    void makeLastInChain(AbstractClient *client, QList<AbstractClient*> &chain);
-    void moveAfterClientInChain(AbstractClient *client, AbstractClient *reference, QList<AbstractClient*> &chain);
-    void updateClientInChain(AbstractClient *client, Change change, QList<AbstractClient*> &chain);
-    void insertClientIntoChain(AbstractClient *client, QList<AbstractClient*> &chain);
-    typedef QHash<uint, QList<AbstractClient*> > DesktopChains;
-    QList<AbstractClient*> m_mostRecentlyUsed;
-    DesktopChains m_desktopFocusChains;
+    void makeLastInChain(AbstractClient *client, Chain &chain);
+    void moveAfterClientInChain(AbstractClient *client, AbstractClient *reference, Chain &chain);
+    void updateClientInChain(AbstractClient *client, Change change, Chain &chain);
+    void insertClientIntoChain(AbstractClient *client, Chain &chain);
+    /**
+     * @return The focus chain of @p desktop or @c null if there is no such virtual desktop.
+     **/
+    Chain *desktopChain(uint desktop) const;
+    Chain m_mostRecentlyUsed;
+    // focus chain of virtual desktop n is at index n - 1
+    QVector<Chain*> m_desktopFocusChains;
     bool m_separateScreenFocus;
     AbstractClient *m_activeClient;
     uint m_currentDesktop;
@@ -224,6 +285,42 @@ private:
     KWIN_SINGLETON_VARIABLE(FocusChain, s_manager)
 };
 
+inline
+bool FocusChain::Chain::contains(AbstractClient *client) const
+{
+    return m_nodes.contains(client);
+}
+
+inline
+bool FocusChain::Chain::isEmpty() const
+{
+    return m_nodes.isEmpty();
+}
+
+inline
+AbstractClient *FocusChain::Chain::first() const
+{
+    return m_first ? m_first->client : nullptr;
+}
+
+inline
+AbstractClient *FocusChain::Chain::last() const
+{
+    return m_last ? m_last->client : nullptr;
+}
+
+template <typename Predicate>
+inline
+AbstractClient *FocusChain::Chain::findLast(Predicate predicate) const
+{
+    for (Node *node = m_last; node; node = node->previous) {
+        if (predicate(node->client)) {
+            return node->client;
+        }
+    }
+    return nullptr;
+}
+
 inline
 bool FocusChain::contains(AbstractClient *client) const
 {
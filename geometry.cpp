@@ -833,6 +833,7 @@ void Workspace::setClientIsMoving(AbstractClient *c)
         ++block_focus;
     else
         --block_focus;
+    emit movingClientChanged();
 }
 
 // When kwin crashes, windows will not be gravitated back to their original position
@@ -151,6 +151,63 @@ void GlobalShortcutsManager::objectDeleted(QObject *object)
     handleDestroyedAction(object, m_shortcuts);
     handleDestroyedAction(object, m_pointerShortcuts);
     handleDestroyedAction(object, m_axisShortcuts);
+    rebuildLookup();
+}
+
+template <typename T>
+void GlobalShortcutsManager::addToLookup(LookupKey::Kind kind, const T &shortcuts)
+{
+    for (auto it = shortcuts.constBegin(); it != shortcuts.constEnd(); ++it) {
+        const auto &list = it.value();
+        for (auto it2 = list.constBegin(); it2 != list.constEnd(); ++it2) {
+            m_lookup.insert({kind, uint(it.key()), uint(it2.key())}, it2.value());
+        }
+    }
+}
+
+void GlobalShortcutsManager::rebuildLookup()
+{
+    m_lookup.clear();
+    addToLookup(LookupKey::Key, m_shortcuts);
+    addToLookup(LookupKey::PointerButtons, m_pointerShortcuts);
+    addToLookup(LookupKey::Axis, m_axisShortcuts);
+}
+
+void GlobalShortcutsManager::setKGlobalAccelInterface(KGlobalAccelInterface *interface)
+{
+    m_kglobalAccelInterface = interface;
+    m_checkKeyPressed = QMetaMethod();
+    if (!interface) {
+        m_kglobalAccelKeys.clear();
+        return;
+    }
+    const QMetaObject *mo = interface->metaObject();
+    const int index = mo->indexOfMethod(QMetaObject::normalizedSignature("checkKeyPressed(int)").constData());
+    if (index != -1) {
+        m_checkKeyPressed = mo->method(index);
+    } else {
+        qCWarning(KWIN_CORE) << "kglobalaccel interface does not provide checkKeyPressed";
+    }
+}
+
+static int normalizedKeyQt(int keyQt)
+{
+    // kglobalaccel treats Backtab and Shift+Tab as the same key combination
+    if ((keyQt & ~Qt::KeyboardModifierMask) == Qt::Key_Backtab) {
+        return (keyQt & Qt::KeyboardModifierMask) | Qt::SHIFT | Qt::Key_Tab;
+    }
+    return keyQt;
+}
+
+void GlobalShortcutsManager::setKGlobalAccelKeyGrabbed(int keyQt, bool grabbed)
+{
+    // several grabbed keys can share the normalized key combination
+    const int key = normalizedKeyQt(keyQt);
+    if (grabbed) {
+        m_kglobalAccelKeys[key]++;
+    } else if (m_kglobalAccelKeys.contains(key) && --m_kglobalAccelKeys[key] == 0) {
+        m_kglobalAccelKeys.remove(key);
+    }
 }
 
 template <typename T, typename R>
@@ -194,18 +251,21 @@ void GlobalShortcutsManager::registerShortcut(QAction *action, const QKeySequenc
         return;
     }
     addShortcut(m_shortcuts, action, mods, static_cast<uint32_t>(keysym));
+    rebuildLookup();
     connect(action, &QAction::destroyed, this, &GlobalShortcutsManager::objectDeleted);
 }
 
 void GlobalShortcutsManager::registerPointerShortcut(QAction *action, Qt::KeyboardModifiers modifiers, Qt::MouseButtons pointerButtons)
 {
     addShortcut(m_pointerShortcuts, action, modifiers, pointerButtons);
+    rebuildLookup();
     connect(action, &QAction::destroyed, this, &GlobalShortcutsManager::objectDeleted);
 }
 
 void GlobalShortcutsManager::registerAxisShortcut(QAction *action, Qt::KeyboardModifiers modifiers, PointerAxisDirection axis)
 {
     addShortcut(m_axisShortcuts, action, modifiers, axis);
+    rebuildLookup();
     connect(action, &QAction::destroyed, this, &GlobalShortcutsManager::objectDeleted);
 }
 
@@ -229,51 +289,57 @@ QKeySequence GlobalShortcutsManager::getShortcutForAction(const QString &compone
     return QKeySequence(parts.first());
 }
 
-template <typename T, typename U>
-bool processShortcut(Qt::KeyboardModifiers mods, T key, U &shortcuts)
+bool GlobalShortcutsManager::lookup(LookupKey::Kind kind, Qt::KeyboardModifiers mods, uint value)
 {
-    auto it = shortcuts.find(mods);
-    if (it == shortcuts.end()) {
+    auto it = m_lookup.constFind({kind, uint(mods), value});
+    if (it == m_lookup.constEnd()) {
         return false;
     }
-    auto it2 = (*it).find(key);
-    if (it2 == (*it).end()) {
-        return false;
-    }
-    it2.value()->invoke();
+    it.value()->invoke();
     return true;
 }
 
+int GlobalShortcutsManager::keyQtForKeysym(uint32_t key)
+{
+    auto it = m_keyQtCache.constFind(key);
+    if (it != m_keyQtCache.constEnd()) {
+        return it.value();
+    }
+    int keyQt = 0;
+    if (!KKeyServer::symXToKeyQt(key, &keyQt)) {
+        keyQt = 0;
+    }
+    m_keyQtCache.insert(key, keyQt);
+    return keyQt;
+}
+
 bool GlobalShortcutsManager::processKey(Qt::KeyboardModifiers mods, uint32_t key)
 {
-    if (m_kglobalAccelInterface) {
-        bool retVal = false;
-        int keyQt = 0;
-        if (KKeyServer::symXToKeyQt(key, &keyQt)) {
-            QMetaObject::invokeMethod(m_kglobalAccelInterface,
-                                    "checkKeyPressed",
-                                    Qt::DirectConnection,
-                                    Q_RETURN_ARG(bool, retVal),
-                                    Q_ARG(int, int(mods) | keyQt));
+    if (m_kglobalAccelInterface && !m_kglobalAccelKeys.isEmpty()) {
+        const int keyQt = keyQtForKeysym(key);
+        // only call into kglobalaccel if it grabbed this key combination
+        if (keyQt != 0 && m_kglobalAccelKeys.contains(normalizedKeyQt(int(mods) | keyQt)) && m_checkKeyPressed.isValid()) {
+            bool retVal = false;
+            m_checkKeyPressed.invoke(m_kglobalAccelInterface,
+                                     Qt::DirectConnection,
+                                     Q_RETURN_ARG(bool, retVal),
+                                     Q_ARG(int, int(mods) | keyQt));
             if (retVal) {
                 return true;
             }
         }
     }
-    if (processShortcut(mods, key, m_shortcuts)) {
-        return true;
-    }
-    return false;
+    return lookup(LookupKey::Key, mods, key);
 }
 
 bool GlobalShortcutsManager::processPointerPressed(Qt::KeyboardModifiers mods, Qt::MouseButtons pointerButtons)
 {
-    return processShortcut(mods, pointerButtons, m_pointerShortcuts);
+    return lookup(LookupKey::PointerButtons, mods, uint(pointerButtons));
 }
 
 bool GlobalShortcutsManager::processAxis(Qt::KeyboardModifiers mods, PointerAxisDirection axis)
 {
-    return processShortcut(mods, axis, m_axisShortcuts);
+    return lookup(LookupKey::Axis, mods, uint(axis));
 }
 
 } // namespace
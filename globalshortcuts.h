@@ -24,7 +24,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // KDE
 #include <KSharedConfig>
 // Qt
+#include <QHash>
 #include <QKeySequence>
+#include <QMetaMethod>
 
 class QAction;
 class KGlobalAccelD;
@@ -102,12 +104,45 @@ public:
      */
     bool processAxis(Qt::KeyboardModifiers modifiers, PointerAxisDirection axis);
 
-    void setKGlobalAccelInterface(KGlobalAccelInterface *interface) {
-        m_kglobalAccelInterface = interface;
-    }
+    void setKGlobalAccelInterface(KGlobalAccelInterface *interface);
+    /**
+     * @brief Updates whether kglobalaccel has a shortcut grabbed for @p keyQt.
+     *
+     * Only key presses matching a grabbed key are forwarded to kglobalaccel, all other
+     * key presses are rejected through the lookup table without calling into the plugin.
+     *
+     * @param keyQt The key combination including the modifiers as used by Qt
+     * @param grabbed Whether kglobalaccel holds a shortcut for this key combination
+     */
+    void setKGlobalAccelKeyGrabbed(int keyQt, bool grabbed);
 
 private:
+    /**
+     * Key into the flat lookup table of all internal shortcuts. @c value is the keysym for
+     * keyboard shortcuts, the buttons for pointer shortcuts and the direction for axis shortcuts.
+     **/
+    struct LookupKey {
+        enum Kind {
+            Key,
+            PointerButtons,
+            Axis
+        };
+        int kind;
+        uint modifiers;
+        uint value;
+        bool operator==(const LookupKey &other) const {
+            return kind == other.kind && modifiers == other.modifiers && value == other.value;
+        }
+        friend uint qHash(const LookupKey &key, uint seed = 0) {
+            return ::qHash((quint64(key.kind) << 60) ^ (quint64(key.modifiers) << 32) ^ key.value, seed);
+        }
+    };
     void objectDeleted(QObject *object);
+    void rebuildLookup();
+    template <typename T>
+    void addToLookup(LookupKey::Kind kind, const T &shortcuts);
+    bool lookup(LookupKey::Kind kind, Qt::KeyboardModifiers modifiers, uint value);
+    int keyQtForKeysym(uint32_t key);
     QKeySequence getShortcutForAction(const QString &componentName, const QString &actionName, const QKeySequence &defaultShortcut);
     QHash<Qt::KeyboardModifiers, QHash<uint32_t, GlobalShortcut*> > m_shortcuts;
     QHash<Qt::KeyboardModifiers, QHash<Qt::MouseButtons, GlobalShortcut*> > m_pointerShortcuts;
@@ -115,6 +150,11 @@ private:
     KSharedConfigPtr m_config;
     KGlobalAccelD *m_kglobalAccel = nullptr;
     KGlobalAccelInterface *m_kglobalAccelInterface = nullptr;
+    QMetaMethod m_checkKeyPressed;
+    // normalized grabbed key combinations and how many grabs map to them
+    QHash<int, int> m_kglobalAccelKeys;
+    QHash<LookupKey, GlobalShortcut*> m_lookup;
+    QHash<uint32_t, int> m_keyQtCache;
 };
 
 class GlobalShortcut
@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "client.h"
 #include "effects.h"
 #include "globalshortcuts.h"
+#include "input_latency.h"
 #include "logind.h"
 #include "main.h"
 #ifdef KWIN_BUILD_TABBOX
@@ -49,6 +50,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QKeyEvent>
 #include <QMouseEvent>
 #include <QTemporaryFile>
+#include <QTimer>
 // KDE
 #include <kkeyserver.h>
 //screenlocker
@@ -58,8 +60,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <xkbcommon/xkbcommon-keysyms.h>
 // system
 #include <linux/input.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <sys/mman.h>
 #include <unistd.h>
+#if HAVE_MEMFD
+#include <linux/memfd.h>
+#include <sys/syscall.h>
+#ifndef F_ADD_SEALS
+#define F_LINUX_SPECIFIC_BASE 1024
+#define F_ADD_SEALS (F_LINUX_SPECIFIC_BASE + 9)
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#define F_SEAL_WRITE 0x0008
+#endif
+#endif
 
 namespace KWin
 {
@@ -90,6 +106,9 @@ Xkb::Xkb(InputRedirection *input)
 
 Xkb::~Xkb()
 {
+    if (m_keymapFd != -1) {
+        close(m_keymapFd);
+    }
     xkb_state_unref(m_state);
     xkb_keymap_unref(m_keymap);
     xkb_context_unref(m_context);
@@ -134,9 +153,80 @@ void Xkb::updateKeymap(xkb_keymap *keymap)
     m_altModifier     = xkb_keymap_mod_get_index(m_keymap, XKB_MOD_NAME_ALT);
     m_metaModifier    = xkb_keymap_mod_get_index(m_keymap, XKB_MOD_NAME_LOGO);
 
+    compileQtKeyTable();
     createKeymapFile();
 }
 
+void Xkb::compileQtKeyTable()
+{
+    // resolve all keysyms reachable through the keymap once, so that key events don't need
+    // to go through KKeyServer's table search
+    m_qtKeys.clear();
+    xkb_keymap_key_for_each(m_keymap,
+        [] (xkb_keymap *keymap, xkb_keycode_t keycode, void *data) {
+            auto qtKeys = reinterpret_cast<QHash<xkb_keysym_t, int>*>(data);
+            const xkb_layout_index_t layouts = xkb_keymap_num_layouts_for_key(keymap, keycode);
+            for (xkb_layout_index_t layout = 0; layout < layouts; ++layout) {
+                const xkb_level_index_t levels = xkb_keymap_num_levels_for_key(keymap, keycode, layout);
+                for (xkb_level_index_t level = 0; level < levels; ++level) {
+                    const xkb_keysym_t *syms = nullptr;
+                    const int count = xkb_keymap_key_get_syms_by_level(keymap, keycode, layout, level, &syms);
+                    for (int i = 0; i < count; ++i) {
+                        if (qtKeys->contains(syms[i])) {
+                            continue;
+                        }
+                        int key = Qt::Key_unknown;
+                        KKeyServer::symXToKeyQt(syms[i], &key);
+                        qtKeys->insert(syms[i], key);
+                    }
+                }
+            }
+        }, &m_qtKeys);
+}
+
+static bool writeKeymap(int fd, const char *data, uint size)
+{
+    while (size > 0) {
+        const ssize_t written = write(fd, data, size);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+static int createKeymapFd(const QByteArray &keymap)
+{
+    // including the terminating null byte
+    const uint size = keymap.size() + 1;
+#if HAVE_MEMFD
+    int fd = syscall(SYS_memfd_create, "kwin-keymap", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd != -1) {
+        // seal the file so that no client is able to modify the keymap shared with all other clients
+        if (writeKeymap(fd, keymap.constData(), size) &&
+                fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == 0) {
+            return fd;
+        }
+        close(fd);
+    }
+    qCDebug(KWIN_CORE) << "Could not create sealed keymap, falling back to temporary file";
+#endif
+    QTemporaryFile tmp;
+    if (!tmp.open()) {
+        return -1;
+    }
+    if (!writeKeymap(tmp.handle(), keymap.constData(), size)) {
+        return -1;
+    }
+    // the duplicated descriptor keeps the file alive after QTemporaryFile removed it
+    return fcntl(tmp.handle(), F_DUPFD_CLOEXEC, 0);
+}
+
 void Xkb::createKeymapFile()
 {
     if (!waylandServer()) {
@@ -151,27 +241,22 @@ void Xkb::createKeymapFile()
     if (keymapString.isNull()) {
         return;
     }
-    const uint size = qstrlen(keymapString.data()) + 1;
-
-    QTemporaryFile *tmp = new QTemporaryFile(m_input);
-    if (!tmp->open()) {
-        delete tmp;
+    const QByteArray keymap(keymapString.data());
+    if (m_keymapFd != -1 && keymap == m_keymapString) {
+        // clients already got this keymap
         return;
     }
-    unlink(tmp->fileName().toUtf8().constData());
-    if (!tmp->resize(size)) {
-        delete tmp;
+    const int fd = createKeymapFd(keymap);
+    if (fd == -1) {
+        qCDebug(KWIN_CORE) << "Could not create keymap file";
         return;
     }
-    uchar *address = tmp->map(0, size);
-    if (!address) {
-        return;
+    waylandServer()->seat()->setKeymap(fd, keymap.size() + 1);
+    if (m_keymapFd != -1) {
+        close(m_keymapFd);
     }
-    if (qstrncpy(reinterpret_cast<char*>(address), keymapString.data(), size) == nullptr) {
-        delete tmp;
-        return;
-    }
-    waylandServer()->seat()->setKeymap(tmp->handle(), size);
+    m_keymapFd = fd;
+    m_keymapString = keymap;
 }
 
 void Xkb::updateModifiers(uint32_t modsDepressed, uint32_t modsLatched, uint32_t modsLocked, uint32_t group)
@@ -259,11 +344,25 @@ QString Xkb::toString(xkb_keysym_t keysym)
 
 Qt::Key Xkb::toQtKey(xkb_keysym_t keysym)
 {
+    auto it = m_qtKeys.constFind(keysym);
+    if (it != m_qtKeys.constEnd()) {
+        return static_cast<Qt::Key>(it.value());
+    }
+    // keysym not in the keymap, e.g. from fake input
     int key = Qt::Key_unknown;
     KKeyServer::symXToKeyQt(keysym, &key);
+    m_qtKeys.insert(keysym, key);
     return static_cast<Qt::Key>(key);
 }
 
+bool Xkb::shouldKeyRepeat(uint32_t key) const
+{
+    if (!m_keymap) {
+        return false;
+    }
+    return xkb_keymap_key_repeats(m_keymap, key + 8) != 0;
+}
+
 quint32 Xkb::getMods(quint32 components)
 {
     if (!m_state) {
@@ -280,7 +379,10 @@ quint32 Xkb::getGroup()
     return xkb_state_serialize_layout(m_state, XKB_STATE_LAYOUT_EFFECTIVE);
 }
 
-InputEventFilter::InputEventFilter() = default;
+InputEventFilter::InputEventFilter(EventTypes eventTypes)
+    : m_eventTypes(eventTypes)
+{
+}
 
 InputEventFilter::~InputEventFilter()
 {
@@ -289,6 +391,17 @@ InputEventFilter::~InputEventFilter()
     }
 }
 
+void InputEventFilter::setActive(bool active)
+{
+    if (m_active == active) {
+        return;
+    }
+    m_active = active;
+    if (input()) {
+        input()->m_activeFiltersDirty = true;
+    }
+}
+
 bool InputEventFilter::pointerEvent(QMouseEvent *event, quint32 nativeButton)
 {
     Q_UNUSED(event)
@@ -334,9 +447,13 @@ bool InputEventFilter::touchUp(quint32 id, quint32 time)
 #if HAVE_INPUT
 class VirtualTerminalFilter : public InputEventFilter {
 public:
+    VirtualTerminalFilter()
+        : InputEventFilter(KeyEvents)
+    {
+    }
     bool keyEvent(QKeyEvent *event) override {
         // really on press and not on release? X11 switches on press.
-        if (event->type() == QEvent::KeyPress) {
+        if (event->type() == QEvent::KeyPress && !event->isAutoRepeat()) {
             const xkb_keysym_t keysym = event->nativeVirtualKey();
             if (keysym >= XKB_KEY_XF86Switch_VT_1 && keysym <= XKB_KEY_XF86Switch_VT_12) {
                 VirtualTerminal::self()->activate(keysym - XKB_KEY_XF86Switch_VT_1 + 1);
@@ -350,6 +467,20 @@ public:
 
 class LockScreenFilter : public InputEventFilter {
 public:
+    LockScreenFilter()
+        : InputEventFilter(AllEvents)
+    {
+        // only relevant while the screen is locked
+        setActive(waylandServer()->isScreenLocked());
+        m_lockStateConnection = QObject::connect(ScreenLocker::KSldApp::self(), &ScreenLocker::KSldApp::lockStateChanged, waylandServer(),
+            [this] {
+                setActive(waylandServer()->isScreenLocked());
+            }
+        );
+    }
+    ~LockScreenFilter() {
+        QObject::disconnect(m_lockStateConnection);
+    }
     bool pointerEvent(QMouseEvent *event, quint32 nativeButton) override {
         if (!waylandServer()->isScreenLocked()) {
             return false;
@@ -363,6 +494,7 @@ public:
             }
             if (pointerSurfaceAllowed()) {
                 seat->setPointerPos(event->screenPos().toPoint());
+                InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
             }
         } else if (event->type() == QEvent::MouseButtonPress || event->type() == QEvent::MouseButtonRelease) {
             if (pointerSurfaceAllowed()) {
@@ -380,6 +512,7 @@ public:
             seat->setTimestamp(event->timestamp());
             const Qt::Orientation orientation = event->angleDelta().x() == 0 ? Qt::Vertical : Qt::Horizontal;
             seat->pointerAxis(orientation, orientation == Qt::Horizontal ? event->angleDelta().x() : event->angleDelta().y());
+            InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
         }
         return true;
     }
@@ -387,6 +520,10 @@ public:
         if (!waylandServer()->isScreenLocked()) {
             return false;
         }
+        if (event->isAutoRepeat()) {
+            // wayland clients repeat keys on their own
+            return true;
+        }
         input()->updateKeyboardWindow();
         if (!keyboardSurfaceAllowed()) {
             // don't pass event to seat
@@ -396,9 +533,11 @@ public:
         switch (event->type()) {
         case QEvent::KeyPress:
             seat->keyPressed(event->nativeScanCode());
+            InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
             break;
         case QEvent::KeyRelease:
             seat->keyReleased(event->nativeScanCode());
+            InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
             break;
         default:
             break;
@@ -416,6 +555,7 @@ public:
         }
         if (touchSurfaceAllowed()) {
             input()->insertTouchId(id, seat->touchDown(pos));
+            InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
         }
         return true;
     }
@@ -429,6 +569,7 @@ public:
             const qint32 kwaylandId = input()->touchId(id);
             if (kwaylandId != -1) {
                 seat->touchMove(kwaylandId, pos);
+                InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
             }
         }
         return true;
@@ -443,6 +584,7 @@ public:
             const qint32 kwaylandId = input()->touchId(id);
             if (kwaylandId != -1) {
                 seat->touchUp(kwaylandId);
+                InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
                 input()->removeTouchId(id);
             }
         }
@@ -467,10 +609,15 @@ private:
     bool touchSurfaceAllowed() const {
         return surfaceAllowed(&KWayland::Server::SeatInterface::focusedTouchSurface);
     }
+    QMetaObject::Connection m_lockStateConnection;
 };
 
 class EffectsFilter : public InputEventFilter {
 public:
+    EffectsFilter()
+        : InputEventFilter(PointerEvents | KeyEvents)
+    {
+    }
     bool pointerEvent(QMouseEvent *event, quint32 nativeButton) override {
         Q_UNUSED(nativeButton)
         if (!effects) {
@@ -489,6 +636,20 @@ public:
 
 class MoveResizeFilter : public InputEventFilter {
 public:
+    MoveResizeFilter()
+        : InputEventFilter(PointerEvents | WheelEvents | KeyEvents)
+    {
+        // only relevant while a window is moved or resized
+        setActive(false);
+        m_movingClientConnection = QObject::connect(workspace(), &Workspace::movingClientChanged, workspace(),
+            [this] {
+                setActive(workspace()->getMovingClient() != nullptr);
+            }
+        );
+    }
+    ~MoveResizeFilter() {
+        QObject::disconnect(m_movingClientConnection);
+    }
     bool pointerEvent(QMouseEvent *event, quint32 nativeButton) override {
         Q_UNUSED(nativeButton)
         AbstractClient *c = workspace()->getMovingClient();
@@ -528,10 +689,16 @@ public:
         }
         return true;
     }
+private:
+    QMetaObject::Connection m_movingClientConnection;
 };
 
 class GlobalShortcutFilter : public InputEventFilter {
 public:
+    GlobalShortcutFilter()
+        : InputEventFilter(PointerEvents | WheelEvents | KeyEvents)
+    {
+    }
     bool pointerEvent(QMouseEvent *event, quint32 nativeButton) override {
         Q_UNUSED(nativeButton);
         if (event->type() == QEvent::MouseButtonPress) {
@@ -558,7 +725,7 @@ public:
         return input()->shortcuts()->processAxis(event->modifiers(), direction);
     }
     bool keyEvent(QKeyEvent *event) override {
-        if (event->type() == QEvent::KeyPress) {
+        if (event->type() == QEvent::KeyPress && !event->isAutoRepeat()) {
             return input()->shortcuts()->processKey(event->modifiers(), event->nativeVirtualKey());
         }
         return false;
@@ -566,6 +733,11 @@ public:
 };
 
 class InternalWindowEventFilter : public InputEventFilter {
+public:
+    InternalWindowEventFilter()
+        : InputEventFilter(PointerEvents | WheelEvents | KeyEvents)
+    {
+    }
     bool pointerEvent(QMouseEvent *event, quint32 nativeButton) override {
         Q_UNUSED(nativeButton)
         auto internal = input()->pointer()->internalWindow();
@@ -611,6 +783,10 @@ class InternalWindowEventFilter : public InputEventFilter {
 
 class DecorationEventFilter : public InputEventFilter {
 public:
+    DecorationEventFilter()
+        : InputEventFilter(PointerEvents | WheelEvents)
+    {
+    }
     bool pointerEvent(QMouseEvent *event, quint32 nativeButton) override {
         Q_UNUSED(nativeButton)
         auto decoration = input()->pointer()->decoration();
@@ -678,6 +854,10 @@ public:
 class TabBoxInputFilter : public InputEventFilter
 {
 public:
+    TabBoxInputFilter()
+        : InputEventFilter(KeyEvents)
+    {
+    }
     bool keyEvent(QKeyEvent *event) override {
         if (!TabBox::TabBox::self() || !TabBox::TabBox::self()->isGrabbed()) {
             return false;
@@ -691,6 +871,10 @@ public:
 class ScreenEdgeInputFilter : public InputEventFilter
 {
 public:
+    ScreenEdgeInputFilter()
+        : InputEventFilter(PointerEvents)
+    {
+    }
     bool pointerEvent(QMouseEvent *event, quint32 nativeButton) override {
         Q_UNUSED(nativeButton)
         ScreenEdges::self()->isEntered(event);
@@ -715,6 +899,7 @@ public:
                 input()->pointer()->update();
             }
             seat->setPointerPos(event->globalPos());
+            InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
             break;
         case QEvent::MouseButtonPress: {
             bool passThrough = true;
@@ -727,11 +912,13 @@ public:
             }
             if (passThrough) {
                 seat->pointerButtonPressed(nativeButton);
+                InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
             }
             break;
         }
         case QEvent::MouseButtonRelease:
             seat->pointerButtonReleased(nativeButton);
+            InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
             if (event->buttons() == Qt::NoButton) {
                 input()->pointer()->update();
             }
@@ -746,21 +933,28 @@ public:
         seat->setTimestamp(event->timestamp());
         const Qt::Orientation orientation = event->angleDelta().x() == 0 ? Qt::Vertical : Qt::Horizontal;
         seat->pointerAxis(orientation, orientation == Qt::Horizontal ? event->angleDelta().x() : event->angleDelta().y());
+        InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
         return true;
     }
     bool keyEvent(QKeyEvent *event) override {
         if (!workspace()) {
             return false;
         }
+        if (event->isAutoRepeat()) {
+            // wayland clients repeat keys on their own
+            return true;
+        }
         auto seat = waylandServer()->seat();
         input()->updateKeyboardWindow();
         seat->setTimestamp(event->timestamp());
         switch (event->type()) {
         case QEvent::KeyPress:
             seat->keyPressed(event->nativeScanCode());
+            InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
             break;
         case QEvent::KeyRelease:
             seat->keyReleased(event->nativeScanCode());
+            InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
             break;
         default:
             break;
@@ -788,6 +982,7 @@ public:
             }
         }
         input()->insertTouchId(id, seat->touchDown(pos));
+        InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
         return true;
     }
     bool touchMotion(quint32 id, const QPointF &pos, quint32 time) override {
@@ -799,6 +994,7 @@ public:
         const qint32 kwaylandId = input()->touchId(id);
         if (kwaylandId != -1) {
             seat->touchMove(kwaylandId, pos);
+            InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
         }
         return true;
     }
@@ -811,6 +1007,7 @@ public:
         const qint32 kwaylandId = input()->touchId(id);
         if (kwaylandId != -1) {
             seat->touchUp(kwaylandId);
+            InputLatencyTracer::self()->mark(InputLatencyTracer::Deliver);
             input()->removeTouchId(id);
         }
         return true;
@@ -828,6 +1025,10 @@ InputRedirection::InputRedirection(QObject *parent)
     qRegisterMetaType<KWin::InputRedirection::KeyboardKeyState>();
     qRegisterMetaType<KWin::InputRedirection::PointerButtonState>();
     qRegisterMetaType<KWin::InputRedirection::PointerAxis>();
+    m_keyRepeat.timer = new QTimer(this);
+    // a coarse timer lets the repeat wake up together with other timers of the event loop
+    m_keyRepeat.timer->setTimerType(Qt::CoarseTimer);
+    connect(m_keyRepeat.timer, &QTimer::timeout, this, &InputRedirection::processKeyRepeat);
 #if HAVE_INPUT
     if (Application::usesLibinput()) {
         if (VirtualTerminal::self()) {
@@ -850,11 +1051,47 @@ InputRedirection::~InputRedirection()
 void InputRedirection::installInputEventFilter(InputEventFilter *filter)
 {
     m_filters << filter;
+    m_activeFiltersDirty = true;
 }
 
 void InputRedirection::uninstallInputEventFilter(InputEventFilter *filter)
 {
     m_filters.removeAll(filter);
+    m_activeFiltersDirty = true;
+}
+
+static const InputEventFilter::EventType s_filterEventTypes[] = {
+    InputEventFilter::PointerEvents,
+    InputEventFilter::WheelEvents,
+    InputEventFilter::KeyEvents,
+    InputEventFilter::TouchEvents
+};
+
+void InputRedirection::rebuildActiveFilters()
+{
+    for (int i = 0; i < 4; ++i) {
+        QVector<InputEventFilter*> filters;
+        for (InputEventFilter *filter : m_filters) {
+            if (filter->isActive() && filter->eventTypes().testFlag(s_filterEventTypes[i])) {
+                filters << filter;
+            }
+        }
+        m_activeFilters[i] = filters;
+    }
+    m_activeFiltersDirty = false;
+}
+
+QVector<InputEventFilter*> InputRedirection::activeFilters(int type)
+{
+    if (m_activeFiltersDirty) {
+        rebuildActiveFilters();
+    }
+    for (int i = 0; i < 4; ++i) {
+        if (s_filterEventTypes[i] == type) {
+            return m_activeFilters[i];
+        }
+    }
+    return QVector<InputEventFilter*>();
 }
 
 void InputRedirection::init()
@@ -969,16 +1206,25 @@ void InputRedirection::setupInputFilters()
 
 void InputRedirection::reconfigure()
 {
+    if (!waylandServer()) {
+        return;
+    }
+    const auto config = KSharedConfig::openConfig(QStringLiteral("kcminputrc"))->group(QStringLiteral("keyboard"));
+    const int delay = config.readEntry("RepeatDelay", 660);
+    const int rate = config.readEntry("RepeatRate", 25);
+    const bool enabled = config.readEntry("KeyboardRepeating", 0) == 0;
 #if HAVE_INPUT
     if (Application::usesLibinput()) {
-        const auto config = KSharedConfig::openConfig(QStringLiteral("kcminputrc"))->group(QStringLiteral("keyboard"));
-        const int delay = config.readEntry("RepeatDelay", 660);
-        const int rate = config.readEntry("RepeatRate", 25);
-        const bool enabled = config.readEntry("KeyboardRepeating", 0) == 0;
-
         waylandServer()->seat()->setKeyRepeatInfo(enabled ? rate : 0, delay);
     }
 #endif
+    const bool hostKeyRepeat = waylandServer()->backend() && waylandServer()->backend()->hasHostKeyRepeat();
+    m_keyRepeat.enabled = enabled && rate > 0 && !hostKeyRepeat;
+    m_keyRepeat.delay = delay;
+    m_keyRepeat.rate = rate;
+    if (!m_keyRepeat.enabled) {
+        stopKeyRepeat();
+    }
 }
 
 static KWayland::Server::SeatInterface *findSeat()
@@ -1013,7 +1259,7 @@ void InputRedirection::setupLibInput()
         connect(conn, &LibInput::Connection::keyChanged, this, &InputRedirection::processKeyboardKey);
         connect(conn, &LibInput::Connection::pointerMotion, this,
             [this] (QPointF delta, uint32_t time) {
-                m_pointer->processMotion(m_pointer->pos() + delta, time);
+                m_pointer->processRelativeMotion(delta, time);
             }
         );
         connect(conn, &LibInput::Connection::pointerMotionAbsolute, this,
@@ -1064,6 +1310,8 @@ void InputRedirection::setupLibInput()
         connect(VirtualTerminal::self(), &VirtualTerminal::activeChanged, m_libInput,
             [this] (bool active) {
                 if (!active) {
+                    // we won't get the release event of a pressed key
+                    stopKeyRepeat();
                     m_libInput->deactivate();
                 }
             }
@@ -1159,12 +1407,23 @@ void InputRedirection::updateKeyboardWindow()
 
 void InputRedirection::processKeyboardKey(uint32_t key, InputRedirection::KeyboardKeyState state, uint32_t time)
 {
+    // filters like move/resize rely on the current pointer position
+    m_pointer->flushPendingMotion();
     emit keyStateChanged(key, state);
     const Qt::KeyboardModifiers oldMods = keyboardModifiers();
     m_xkb->updateKey(key, state);
     if (oldMods != keyboardModifiers()) {
         emit keyboardModifiersChanged(keyboardModifiers(), oldMods);
     }
+    if (state == KeyboardKeyPressed) {
+        if (m_keyRepeat.enabled && m_xkb->shouldKeyRepeat(key)) {
+            m_keyRepeat.key = key;
+            m_keyRepeat.time = time;
+            m_keyRepeat.timer->start(m_keyRepeat.delay);
+        }
+    } else if (key == m_keyRepeat.key) {
+        stopKeyRepeat();
+    }
     const xkb_keysym_t keySym = m_xkb->toKeysym(key);
     QKeyEvent event((state == KeyboardKeyPressed) ? QEvent::KeyPress : QEvent::KeyRelease,
                     m_xkb->toQtKey(keySym),
@@ -1172,16 +1431,52 @@ void InputRedirection::processKeyboardKey(uint32_t key, InputRedirection::Keyboa
                     key,
                     keySym,
                     0,
-                    m_xkb->toString(m_xkb->toKeysym(key)));
+                    m_xkb->toString(keySym));
     event.setTimestamp(time);
 
-    for (auto it = m_filters.constBegin(), end = m_filters.constEnd(); it != end; it++) {
+    InputLatencyTracer::self()->mark(InputLatencyTracer::Filter);
+    const auto filters = activeFilters(InputEventFilter::KeyEvents);
+    for (auto it = filters.constBegin(), end = filters.constEnd(); it != end; it++) {
         if ((*it)->keyEvent(&event)) {
             return;
         }
     }
 }
 
+void InputRedirection::processKeyRepeat()
+{
+    // a single timer serves the seat, if the event loop was blocked the elapsed
+    // intervals are coalesced into one repeat event
+    m_keyRepeat.time += m_keyRepeat.timer->interval();
+    const int interval = 1000 / m_keyRepeat.rate;
+    if (m_keyRepeat.timer->interval() != interval) {
+        m_keyRepeat.timer->setInterval(interval);
+    }
+    const xkb_keysym_t keySym = m_xkb->toKeysym(m_keyRepeat.key);
+    QKeyEvent event(QEvent::KeyPress,
+                    m_xkb->toQtKey(keySym),
+                    m_xkb->modifiers(),
+                    m_keyRepeat.key,
+                    keySym,
+                    0,
+                    m_xkb->toString(keySym),
+                    true);
+    event.setTimestamp(m_keyRepeat.time);
+
+    const auto filters = activeFilters(InputEventFilter::KeyEvents);
+    for (auto it = filters.constBegin(), end = filters.constEnd(); it != end; it++) {
+        if ((*it)->keyEvent(&event)) {
+            return;
+        }
+    }
+}
+
+void InputRedirection::stopKeyRepeat()
+{
+    m_keyRepeat.timer->stop();
+    m_keyRepeat.key = 0;
+}
+
 void InputRedirection::processKeyboardModifiers(uint32_t modsDepressed, uint32_t modsLatched, uint32_t modsLocked, uint32_t group)
 {
     // TODO: send to proper Client and also send when active Client changes
@@ -1200,7 +1495,9 @@ void InputRedirection::processKeymapChange(int fd, uint32_t size)
 
 void InputRedirection::processTouchDown(qint32 id, const QPointF &pos, quint32 time)
 {
-    for (auto it = m_filters.constBegin(), end = m_filters.constEnd(); it != end; it++) {
+    InputLatencyTracer::self()->mark(InputLatencyTracer::Filter);
+    const auto filters = activeFilters(InputEventFilter::TouchEvents);
+    for (auto it = filters.constBegin(), end = filters.constEnd(); it != end; it++) {
         if ((*it)->touchDown(id, pos, time)) {
             return;
         }
@@ -1238,7 +1535,9 @@ void InputRedirection::updateTouchWindow(const QPointF &pos)
 
 void InputRedirection::processTouchUp(qint32 id, quint32 time)
 {
-    for (auto it = m_filters.constBegin(), end = m_filters.constEnd(); it != end; it++) {
+    InputLatencyTracer::self()->mark(InputLatencyTracer::Filter);
+    const auto filters = activeFilters(InputEventFilter::TouchEvents);
+    for (auto it = filters.constBegin(), end = filters.constEnd(); it != end; it++) {
         if ((*it)->touchUp(id, time)) {
             return;
         }
@@ -1247,7 +1546,9 @@ void InputRedirection::processTouchUp(qint32 id, quint32 time)
 
 void InputRedirection::processTouchMotion(qint32 id, const QPointF &pos, quint32 time)
 {
-    for (auto it = m_filters.constBegin(), end = m_filters.constEnd(); it != end; it++) {
+    InputLatencyTracer::self()->mark(InputLatencyTracer::Filter);
+    const auto filters = activeFilters(InputEventFilter::TouchEvents);
+    for (auto it = filters.constBegin(), end = filters.constEnd(); it != end; it++) {
         if ((*it)->touchMotion(id, pos, time)) {
             return;
         }
@@ -1375,6 +1676,11 @@ void InputRedirection::registerGlobalAccel(KGlobalAccelInterface *interface)
     m_shortcuts->setKGlobalAccelInterface(interface);
 }
 
+void InputRedirection::setGlobalAccelKeyGrabbed(int keyQt, bool grabbed)
+{
+    m_shortcuts->setKGlobalAccelKeyGrabbed(keyQt, grabbed);
+}
+
 void InputRedirection::registerShortcutForGlobalAccelTimestamp(QAction *action)
 {
     connect(action, &QAction::triggered, kwinApp(), [action] {
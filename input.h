@@ -31,6 +31,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 class KGlobalAccelInterface;
 class QKeySequence;
+class QTimer;
 
 struct xkb_context;
 struct xkb_keymap;
@@ -105,6 +106,7 @@ public:
     void registerPointerShortcut(Qt::KeyboardModifiers modifiers, Qt::MouseButton pointerButtons, QAction *action);
     void registerAxisShortcut(Qt::KeyboardModifiers modifiers, PointerAxisDirection axis, QAction *action);
     void registerGlobalAccel(KGlobalAccelInterface *interface);
+    void setGlobalAccelKeyGrabbed(int keyQt, bool grabbed);
 
     /**
      * @internal
@@ -154,6 +156,15 @@ public:
     QVector<InputEventFilter*> filters() const {
         return m_filters;
     }
+    /**
+     * The installed filters which are active and handle events of @p type (one
+     * InputEventFilter::EventType), in the order
+     * of installation. Only rebuilt if a filter got installed, uninstalled or changed its
+     * activation state.
+     *
+     * The returned vector is a shallow copy, so it stays valid while a filter changes the chain.
+     **/
+    QVector<InputEventFilter*> activeFilters(int type);
     PointerInputRedirection *pointer() const {
         return m_pointer;
     }
@@ -206,6 +217,9 @@ private:
     void reconfigure();
     void setupInputFilters();
     void installInputEventFilter(InputEventFilter *filter);
+    void rebuildActiveFilters();
+    void processKeyRepeat();
+    void stopKeyRepeat();
     PointerInputRedirection *m_pointer;
     QScopedPointer<Xkb> m_xkb;
     /**
@@ -218,16 +232,34 @@ private:
     QHash<qint32, qint32> m_touchIdMapper;
 
     GlobalShortcutsManager *m_shortcuts;
+    /**
+     * Server side key repeat, only delivered to KWin internal event filters.
+     * Wayland clients repeat keys on their own based on the repeat info of the seat.
+     **/
+    struct {
+        QTimer *timer = nullptr;
+        uint32_t key = 0;
+        uint32_t time = 0;
+        int delay = 660;
+        int rate = 25;
+        bool enabled = false;
+    } m_keyRepeat;
 
     LibInput::Connection *m_libInput = nullptr;
 
     QVector<InputEventFilter*> m_filters;
+    /**
+     * Active filters per event type, indexed by the bit of the InputEventFilter::EventType.
+     **/
+    QVector<InputEventFilter*> m_activeFilters[4];
+    bool m_activeFiltersDirty = true;
 
     KWIN_SINGLETON(InputRedirection)
     friend InputRedirection *input();
     friend class DecorationEventFilter;
     friend class InternalWindowEventFilter;
     friend class ForwardInputFilter;
+    friend class InputEventFilter;
 };
 
 /**
@@ -246,15 +278,35 @@ private:
  * a filter returns @c false the next one is invoked. This means a filter
  * installed early gets to see more events than a filter installed later on.
  *
+ * A filter declares the event types it handles in the constructor and is only
+ * invoked for those. A filter which is only relevant while a mode is active (e.g.
+ * a locked screen) can deactivate itself with setActive, it is then skipped for all
+ * events until it gets activated again.
+ *
  * Deleting an instance of InputEventFilter automatically uninstalls it from
  * InputRedirection.
  **/
 class InputEventFilter
 {
 public:
-    InputEventFilter();
+    enum EventType {
+        PointerEvents = 1 << 0,
+        WheelEvents = 1 << 1,
+        KeyEvents = 1 << 2,
+        TouchEvents = 1 << 3,
+        AllEvents = PointerEvents | WheelEvents | KeyEvents | TouchEvents
+    };
+    Q_DECLARE_FLAGS(EventTypes, EventType)
+    explicit InputEventFilter(EventTypes eventTypes = AllEvents);
     virtual ~InputEventFilter();
 
+    EventTypes eventTypes() const {
+        return m_eventTypes;
+    }
+    bool isActive() const {
+        return m_active;
+    }
+
     /**
      * Event filter for pointer events which can be described by a QMouseEvent.
      *
@@ -285,6 +337,13 @@ public:
     virtual bool touchDown(quint32 id, const QPointF &pos, quint32 time);
     virtual bool touchMotion(quint32 id, const QPointF &pos, quint32 time);
     virtual bool touchUp(quint32 id, quint32 time);
+
+protected:
+    void setActive(bool active);
+
+private:
+    EventTypes m_eventTypes;
+    bool m_active = true;
 };
 
 class Xkb
@@ -299,12 +358,14 @@ public:
     QString toString(xkb_keysym_t keysym);
     Qt::Key toQtKey(xkb_keysym_t keysym);
     Qt::KeyboardModifiers modifiers() const;
+    bool shouldKeyRepeat(uint32_t key) const;
 
     quint32 getMods(quint32 components);
     quint32 getGroup();
 private:
     void updateKeymap(xkb_keymap *keymap);
     void createKeymapFile();
+    void compileQtKeyTable();
     void updateModifiers();
     InputRedirection *m_input;
     xkb_context *m_context;
@@ -315,12 +376,20 @@ private:
     xkb_mod_index_t m_altModifier;
     xkb_mod_index_t m_metaModifier;
     Qt::KeyboardModifiers m_modifiers;
+    /**
+     * Sealed file descriptor holding the serialized keymap, shared by all clients.
+     **/
+    int m_keymapFd = -1;
+    QByteArray m_keymapString;
+    QHash<xkb_keysym_t, int> m_qtKeys;
     struct {
         uint pressCount = 0;
         Qt::KeyboardModifier modifier = Qt::NoModifier;
     } m_modOnlyShortcut;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(InputEventFilter::EventTypes)
+
 inline
 InputRedirection *input()
 {
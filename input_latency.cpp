@@ -0,0 +1,191 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "input_latency.h"
+
+#include <algorithm>
+
+#include <time.h>
+
+namespace KWin
+{
+
+static const int s_recordCount = 4096;
+// histogram buckets are powers of two in microseconds, the last bucket collects everything above
+static const int s_bucketCount = 18;
+
+InputLatencyTracer *InputLatencyTracer::self()
+{
+    static InputLatencyTracer s_tracer;
+    return &s_tracer;
+}
+
+InputLatencyTracer::InputLatencyTracer()
+    : m_enabled(qEnvironmentVariableIsSet("KWIN_INPUT_LATENCY_TRACING"))
+    , m_next(0)
+    , m_records(s_recordCount)
+{
+}
+
+void InputLatencyTracer::setEnabled(bool enabled)
+{
+    m_enabled.store(enabled);
+    if (!enabled) {
+        m_current = nullptr;
+    }
+}
+
+qint64 InputLatencyTracer::now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void InputLatencyTracer::beginEvent(EventType type, quint64 kernelTime, qint64 readTime)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    Record &record = m_records[m_next.fetchAndAddOrdered(1) % s_recordCount];
+    record.type = type;
+    record.stages[Kernel] = kernelTime * 1000;
+    record.stages[Read] = readTime;
+    record.stages[Dispatch] = now();
+    for (int i = Filter; i < StageCount; ++i) {
+        record.stages[i] = 0;
+    }
+    m_current = &record;
+}
+
+void InputLatencyTracer::mark(Stage stage)
+{
+    if (!m_current || m_current->stages[stage] != 0) {
+        return;
+    }
+    m_current->stages[stage] = now();
+}
+
+void InputLatencyTracer::endEvent()
+{
+    if (!m_current) {
+        return;
+    }
+    m_current->stages[Done] = now();
+    m_current = nullptr;
+}
+
+void InputLatencyTracer::reset()
+{
+    m_current = nullptr;
+    m_next.store(0);
+    for (auto &record : m_records) {
+        record.stages[Done] = 0;
+    }
+}
+
+namespace {
+struct Interval {
+    const char *name;
+    InputLatencyTracer::Stage from;
+    InputLatencyTracer::Stage to;
+};
+
+static const Interval s_intervals[] = {
+    {"libinput (kernel to read)", InputLatencyTracer::Kernel, InputLatencyTracer::Read},
+    {"event queue (read to dispatch)", InputLatencyTracer::Read, InputLatencyTracer::Dispatch},
+    {"redirection (dispatch to filters)", InputLatencyTracer::Dispatch, InputLatencyTracer::Filter},
+    {"filters (filters to seat)", InputLatencyTracer::Filter, InputLatencyTracer::Deliver},
+    {"total (kernel to seat)", InputLatencyTracer::Kernel, InputLatencyTracer::Deliver},
+    {"processing (dispatch to done)", InputLatencyTracer::Dispatch, InputLatencyTracer::Done}
+};
+
+static const char *s_eventTypeNames[] = {
+    "Keyboard",
+    "Pointer",
+    "Touch"
+};
+
+static int bucket(qint64 usec)
+{
+    int bucket = 0;
+    while (usec > 0 && bucket < s_bucketCount - 1) {
+        usec >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+}
+
+QString InputLatencyTracer::information() const
+{
+    QString support;
+    const QString yes = QStringLiteral("yes\n");
+    const QString no = QStringLiteral("no\n");
+    support.append(QStringLiteral("Input latency tracing\n"));
+    support.append(QStringLiteral("=====================\n"));
+    support.append(QStringLiteral("Enabled: "));
+    support.append(isEnabled() ? yes : no);
+    const int count = qMin<quint32>(m_next.load(), s_recordCount);
+    support.append(QStringLiteral("Recorded events: %1\n").arg(count));
+
+    for (int type = 0; type < EventTypeCount; ++type) {
+        bool headerWritten = false;
+        for (const Interval &interval : s_intervals) {
+            QVector<qint64> samples;
+            for (int i = 0; i < count; ++i) {
+                const Record &record = m_records.at(i);
+                // skip records which are still in flight or didn't pass both stages
+                if (record.type != type || record.stages[Done] == 0 ||
+                        record.stages[interval.from] == 0 || record.stages[interval.to] == 0) {
+                    continue;
+                }
+                samples << qMax<qint64>(0, (record.stages[interval.to] - record.stages[interval.from]) / 1000);
+            }
+            if (samples.isEmpty()) {
+                continue;
+            }
+            if (!headerWritten) {
+                support.append(QStringLiteral("\n%1 events\n").arg(QLatin1String(s_eventTypeNames[type])));
+                headerWritten = true;
+            }
+            std::sort(samples.begin(), samples.end());
+            QVector<int> histogram(s_bucketCount, 0);
+            for (qint64 sample : samples) {
+                histogram[bucket(sample)]++;
+            }
+            support.append(QStringLiteral("%1: %2 samples, median %3 us, 99th percentile %4 us, max %5 us\n")
+                .arg(QLatin1String(interval.name))
+                .arg(samples.count())
+                .arg(samples.at(samples.count() / 2))
+                .arg(samples.at(samples.count() * 99 / 100))
+                .arg(samples.last()));
+            for (int i = 0; i < s_bucketCount; ++i) {
+                if (histogram.at(i) == 0) {
+                    continue;
+                }
+                const QString upper = i == s_bucketCount - 1 ? QStringLiteral("inf") : QString::number(1 << i);
+                support.append(QStringLiteral("  < %1 us: %2\n").arg(upper, 8).arg(histogram.at(i)));
+            }
+        }
+    }
+    return support;
+}
+
+}
@@ -0,0 +1,124 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_INPUT_LATENCY_H
+#define KWIN_INPUT_LATENCY_H
+
+#include <kwin_export.h>
+
+#include <QAtomicInteger>
+#include <QString>
+#include <QVector>
+
+namespace KWin
+{
+
+/**
+ * @brief Records how long input events spend in the individual stages from the kernel to the client.
+ *
+ * Each traced event gets a record in a fixed size ring buffer. The stages are marked with
+ * CLOCK_MONOTONIC timestamps as the event passes through LibInput::Connection, InputRedirection,
+ * the InputEventFilter chain and finally the SeatInterface. Recording neither allocates nor locks,
+ * so tracing can stay enabled while reproducing lag. The collected records are evaluated into
+ * per stage latency histograms by information().
+ *
+ * Tracing is disabled by default. It can be enabled with the environment variable
+ * KWIN_INPUT_LATENCY_TRACING or through the D-Bus method setInputLatencyTracing.
+ **/
+class KWIN_EXPORT InputLatencyTracer
+{
+public:
+    enum Stage {
+        /**
+         * The timestamp the kernel assigned to the event.
+         **/
+        Kernel,
+        /**
+         * The event got read from libinput on the input thread.
+         **/
+        Read,
+        /**
+         * The event got taken from the event queue on the main thread.
+         **/
+        Dispatch,
+        /**
+         * InputRedirection updated its state and starts passing the event through the filters.
+         **/
+        Filter,
+        /**
+         * The event got sent to the focused client through the seat.
+         **/
+        Deliver,
+        /**
+         * Processing of the event finished.
+         **/
+        Done,
+        StageCount
+    };
+    enum EventType {
+        KeyEvent,
+        PointerEvent,
+        TouchEvent,
+        EventTypeCount
+    };
+    static InputLatencyTracer *self();
+
+    bool isEnabled() const {
+        return m_enabled.load();
+    }
+    void setEnabled(bool enabled);
+
+    /**
+     * Starts the record for the event which is about to be processed.
+     * @param kernelTime The event time as provided by libinput in microseconds
+     * @param readTime The timestamp the event got read from libinput
+     **/
+    void beginEvent(EventType type, quint64 kernelTime, qint64 readTime);
+    /**
+     * Marks @p stage for the current event. Only the first mark of a stage is recorded.
+     **/
+    void mark(Stage stage);
+    void endEvent();
+
+    /**
+     * @returns latency histograms for each stage over the recorded events
+     **/
+    QString information() const;
+    void reset();
+
+    /**
+     * @returns the current CLOCK_MONOTONIC time in nanoseconds
+     **/
+    static qint64 now();
+
+private:
+    InputLatencyTracer();
+    struct Record {
+        EventType type = KeyEvent;
+        qint64 stages[StageCount];
+    };
+    QAtomicInt m_enabled;
+    QAtomicInteger<quint32> m_next;
+    QVector<Record> m_records;
+    Record *m_current = nullptr;
+};
+
+}
+
+#endif
@@ -39,6 +39,7 @@ Compositing::Compositing(QObject *parent)
     : QObject(parent)
     , m_animationSpeed(0)
     , m_windowThumbnail(0)
+    , m_windowThumbnailBudget(0)
     , m_glScaleFilter(0)
     , m_xrScaleFilter(false)
     , m_unredirectFullscreen(false)
@@ -53,6 +54,7 @@ Compositing::Compositing(QObject *parent)
     reset();
     connect(this, &Compositing::animationSpeedChanged,       this, &Compositing::changed);
     connect(this, &Compositing::windowThumbnailChanged,      this, &Compositing::changed);
+    connect(this, &Compositing::windowThumbnailBudgetChanged, this, &Compositing::changed);
     connect(this, &Compositing::glScaleFilterChanged,        this, &Compositing::changed);
     connect(this, &Compositing::xrScaleFilterChanged,        this, &Compositing::changed);
     connect(this, &Compositing::unredirectFullscreenChanged, this, &Compositing::changed);
@@ -72,6 +74,7 @@ void Compositing::reset()
     KConfigGroup kwinConfig(KSharedConfig::openConfig(QStringLiteral("kwinrc")), QStringLiteral("Compositing"));
     setAnimationSpeed(kwinConfig.readEntry("AnimationSpeed", 3));
     setWindowThumbnail(kwinConfig.readEntry("HiddenPreviews", 5) - 4);
+    setWindowThumbnailBudget(kwinConfig.readEntry("HiddenPreviewsBudget", 256));
     setGlScaleFilter(kwinConfig.readEntry("GLTextureFilter", 2));
     setXrScaleFilter(kwinConfig.readEntry("XRenderSmoothScale", false));
     setUnredirectFullscreen(kwinConfig.readEntry("UnredirectFullscreen", false));
@@ -122,6 +125,7 @@ void Compositing::defaults()
 {
     setAnimationSpeed(3);
     setWindowThumbnail(1);
+    setWindowThumbnailBudget(256);
     setGlScaleFilter(2);
     setXrScaleFilter(false);
     setUnredirectFullscreen(false);
@@ -178,6 +182,11 @@ int Compositing::windowThumbnail() const
     return m_windowThumbnail;
 }
 
+int Compositing::windowThumbnailBudget() const
+{
+    return m_windowThumbnailBudget;
+}
+
 int Compositing::glScaleFilter() const
 {
     return m_glScaleFilter;
@@ -267,6 +276,15 @@ void Compositing::setWindowThumbnail(int index)
     emit windowThumbnailChanged(index);
 }
 
+void Compositing::setWindowThumbnailBudget(int budget)
+{
+    if (budget == m_windowThumbnailBudget) {
+        return;
+    }
+    m_windowThumbnailBudget = budget;
+    emit windowThumbnailBudgetChanged(budget);
+}
+
 void Compositing::setXrScaleFilter(bool filter)
 {
     if (filter == m_xrScaleFilter) {
@@ -300,6 +318,7 @@ void Compositing::save()
     KConfigGroup kwinConfig(KSharedConfig::openConfig(QStringLiteral("kwinrc")), "Compositing");
     kwinConfig.writeEntry("AnimationSpeed", animationSpeed());
     kwinConfig.writeEntry("HiddenPreviews", windowThumbnail() + 4);
+    kwinConfig.writeEntry("HiddenPreviewsBudget", windowThumbnailBudget());
     kwinConfig.writeEntry("GLTextureFilter", glScaleFilter());
     kwinConfig.writeEntry("XRenderSmoothScale", xrScaleFilter());
     kwinConfig.writeEntry("UnredirectFullscreen", unredirectFullscreen());
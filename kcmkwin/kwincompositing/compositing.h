@@ -36,6 +36,7 @@ class Compositing : public QObject
     Q_OBJECT
     Q_PROPERTY(int animationSpeed READ animationSpeed WRITE setAnimationSpeed NOTIFY animationSpeedChanged)
     Q_PROPERTY(int windowThumbnail READ windowThumbnail WRITE setWindowThumbnail NOTIFY windowThumbnailChanged)
+    Q_PROPERTY(int windowThumbnailBudget READ windowThumbnailBudget WRITE setWindowThumbnailBudget NOTIFY windowThumbnailBudgetChanged)
     Q_PROPERTY(int glScaleFilter READ glScaleFilter WRITE setGlScaleFilter NOTIFY glScaleFilterChanged)
     Q_PROPERTY(bool xrScaleFilter READ xrScaleFilter WRITE setXrScaleFilter NOTIFY xrScaleFilterChanged)
     Q_PROPERTY(bool unredirectFullscreen READ unredirectFullscreen WRITE setUnredirectFullscreen NOTIFY unredirectFullscreenChanged)
@@ -53,6 +54,7 @@ public:
     Q_INVOKABLE void reenableOpenGLDetection();
     int animationSpeed() const;
     int windowThumbnail() const;
+    int windowThumbnailBudget() const;
     int glScaleFilter() const;
     bool xrScaleFilter() const;
     bool unredirectFullscreen() const;
@@ -66,6 +68,7 @@ public:
 
     void setAnimationSpeed(int speed);
     void setWindowThumbnail(int index);
+    void setWindowThumbnailBudget(int budget);
     void setGlScaleFilter(int index);
     void setXrScaleFilter(bool filter);
     void setUnredirectFullscreen(bool unredirect);
@@ -85,6 +88,7 @@ Q_SIGNALS:
     void changed();
     void animationSpeedChanged(int);
     void windowThumbnailChanged(int);
+    void windowThumbnailBudgetChanged(int);
     void glScaleFilterChanged(int);
     void xrScaleFilterChanged(int);
     void unredirectFullscreenChanged(bool);
@@ -97,6 +101,7 @@ Q_SIGNALS:
 private:
     int m_animationSpeed;
     int m_windowThumbnail;
+    int m_windowThumbnailBudget;
     int m_glScaleFilter;
     bool m_xrScaleFilter;
     bool m_unredirectFullscreen;
@@ -163,9 +163,17 @@ void KWinCompositingSettings::init()
             } else {
                 m_form.windowThumbnailWarning->animatedHide();
             }
+            // the budget only applies to the recently used desktops
+            m_form.windowThumbnailBudget->setEnabled(index == 3);
         }
     );
 
+    // windowThumbnailBudget
+    m_form.windowThumbnailBudget->setValue(m_compositing->windowThumbnailBudget());
+    m_form.windowThumbnailBudget->setEnabled(m_compositing->windowThumbnail() == 3);
+    connect(m_compositing, &Compositing::windowThumbnailBudgetChanged, m_form.windowThumbnailBudget, &QSpinBox::setValue);
+    connect(m_form.windowThumbnailBudget, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), m_compositing, &Compositing::setWindowThumbnailBudget);
+
     // openglPlatformInterface
     m_form.openGLPlatformInterface->setModel(m_compositing->openGLPlatformInterfaceModel());
     m_form.openGLPlatformInterface->setCurrentIndex(m_compositing->openGLPlatformInterface());
@@ -37,6 +37,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <qmath.h>
 #include <cmath>
+#include <algorithm>
 
 namespace KWin
 {
@@ -200,179 +201,20 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
             const QRect textureRect(tx, ty, tw, th);
             const bool hardwareClipping = !(QRegion(textureRect)-region).isEmpty();
 
-            int sw = width;
-            int sh = height;
-
-            GLTexture *cachedTexture = static_cast< GLTexture*>(w->data(LanczosCacheRole).value<void*>());
-            if (cachedTexture) {
-                if (cachedTexture->width() == tw && cachedTexture->height() == th) {
-                    cachedTexture->bind();
-                    if (hardwareClipping) {
-                        glEnable(GL_SCISSOR_TEST);
-                    }
-
-                    glEnable(GL_BLEND);
-                    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-
-                    const qreal rgb = data.brightness() * data.opacity();
-                    const qreal a = data.opacity();
-
-                    ShaderBinder binder(ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation);
-                    GLShader *shader = binder.shader();
-                    QMatrix4x4 mvp = data.screenProjectionMatrix();
-                    mvp.translate(textureRect.x(), textureRect.y());
-                    shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
-                    shader->setUniform(GLShader::ModulationConstant, QVector4D(rgb, rgb, rgb, a));
-                    shader->setUniform(GLShader::Saturation, data.saturation());
-
-                    cachedTexture->render(region, textureRect, hardwareClipping);
-
-                    glDisable(GL_BLEND);
-                    if (hardwareClipping) {
-                        glDisable(GL_SCISSOR_TEST);
-                    }
-                    cachedTexture->unbind();
-                    m_timer.start(5000, this);
-                    return;
-                } else {
-                    // offscreen texture not matching - delete
-                    delete cachedTexture;
-                    cachedTexture = 0;
-                    w->setData(LanczosCacheRole, QVariant());
-                }
-            }
+            const QPoint sourceOffset(-left, -top);
+            const QSize sourceSize(width, height);
 
-            WindowPaintData thumbData = data;
-            thumbData.setXScale(1.0);
-            thumbData.setYScale(1.0);
-            thumbData.setXTranslation(-w->x() - left);
-            thumbData.setYTranslation(-w->y() - top);
-            thumbData.setBrightness(1.0);
-            thumbData.setOpacity(1.0);
-            thumbData.setSaturation(1.0);
-
-            // Bind the offscreen FBO and draw the window on it unscaled
-            updateOffscreenSurfaces();
-            GLRenderTarget::pushRenderTarget(m_offscreenTarget);
-
-            QMatrix4x4 modelViewProjectionMatrix;
-            modelViewProjectionMatrix.ortho(0, m_offscreenTex->width(), m_offscreenTex->height(), 0 , 0, 65535);
-            thumbData.setProjectionMatrix(modelViewProjectionMatrix);
-
-            glClearColor(0.0, 0.0, 0.0, 0.0);
-            glClear(GL_COLOR_BUFFER_BIT);
-            w->sceneWindow()->performPaint(mask, infiniteRegion(), thumbData);
-
-            // Create a scratch texture and copy the rendered window into it
-            GLTexture tex(GL_RGBA8, sw, sh);
-            tex.setFilter(GL_LINEAR);
-            tex.setWrapMode(GL_CLAMP_TO_EDGE);
-            tex.bind();
-
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - sh, sw, sh);
-
-            // Set up the shader for horizontal scaling
-            float dx = sw / float(tw);
-            int kernelSize;
-            createKernel(dx, &kernelSize);
-            createOffsets(kernelSize, sw, Qt::Horizontal);
-
-            ShaderManager::instance()->pushShader(m_shader.data());
-            m_shader->setUniform(GLShader::ModelViewProjectionMatrix, modelViewProjectionMatrix);
-            setUniforms();
-
-            // Draw the window back into the FBO, this time scaled horizontally
-            glClear(GL_COLOR_BUFFER_BIT);
-            QVector<float> verts;
-            QVector<float> texCoords;
-            verts.reserve(12);
-            texCoords.reserve(12);
-
-            texCoords << 1.0 << 0.0; verts << tw  << 0.0; // Top right
-            texCoords << 0.0 << 0.0; verts << 0.0 << 0.0; // Top left
-            texCoords << 0.0 << 1.0; verts << 0.0 << sh;  // Bottom left
-            texCoords << 0.0 << 1.0; verts << 0.0 << sh;  // Bottom left
-            texCoords << 1.0 << 1.0; verts << tw  << sh;  // Bottom right
-            texCoords << 1.0 << 0.0; verts << tw  << 0.0; // Top right
-            GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
-            vbo->reset();
-            vbo->setData(6, 2, verts.constData(), texCoords.constData());
-            vbo->render(GL_TRIANGLES);
-
-            // At this point we don't need the scratch texture anymore
-            tex.unbind();
-            tex.discard();
-
-            // create scratch texture for second rendering pass
-            GLTexture tex2(GL_RGBA8, tw, sh);
-            tex2.setFilter(GL_LINEAR);
-            tex2.setWrapMode(GL_CLAMP_TO_EDGE);
-            tex2.bind();
-
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - sh, tw, sh);
-
-            // Set up the shader for vertical scaling
-            float dy = sh / float(th);
-            createKernel(dy, &kernelSize);
-            createOffsets(kernelSize, m_offscreenTex->height(), Qt::Vertical);
-            setUniforms();
-
-            // Now draw the horizontally scaled window in the FBO at the right
-            // coordinates on the screen, while scaling it vertically and blending it.
-            glClear(GL_COLOR_BUFFER_BIT);
-
-            verts.clear();
-
-            verts << tw  << 0.0; // Top right
-            verts << 0.0 << 0.0; // Top left
-            verts << 0.0 << th;  // Bottom left
-            verts << 0.0 << th;  // Bottom left
-            verts << tw  << th;  // Bottom right
-            verts << tw  << 0.0; // Top right
-            vbo->setData(6, 2, verts.constData(), texCoords.constData());
-            vbo->render(GL_TRIANGLES);
-
-            tex2.unbind();
-            tex2.discard();
-            ShaderManager::instance()->popShader();
-
-            // create cache texture
-            GLTexture *cache = new GLTexture(GL_RGBA8, tw, th);
-
-            cache->setFilter(GL_LINEAR);
-            cache->setWrapMode(GL_CLAMP_TO_EDGE);
-            cache->bind();
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - th, tw, th);
-            GLRenderTarget::popRenderTarget();
-
-            if (hardwareClipping) {
-                glEnable(GL_SCISSOR_TEST);
+            LanczosCache *cache = LanczosCache::fromWindow(w);
+            if (!cache) {
+                cache = new LanczosCache;
+                w->setData(LanczosCacheRole, QVariant::fromValue(static_cast<void*>(cache)));
             }
-
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-
-            const qreal rgb = data.brightness() * data.opacity();
-            const qreal a = data.opacity();
-
-            ShaderBinder binder(ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation);
-            GLShader *shader = binder.shader();
-            QMatrix4x4 mvp = data.screenProjectionMatrix();
-            mvp.translate(textureRect.x(), textureRect.y());
-            shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
-            shader->setUniform(GLShader::ModulationConstant, QVector4D(rgb, rgb, rgb, a));
-            shader->setUniform(GLShader::Saturation, data.saturation());
-
-            cache->render(region, textureRect, hardwareClipping);
-
-            glDisable(GL_BLEND);
-
-            if (hardwareClipping) {
-                glDisable(GL_SCISSOR_TEST);
+            cache->setSourceGeometry(sourceOffset, sourceSize);
+            LanczosCache::Level *level = cache->level(textureRect.size());
+            if (!level->damage.isEmpty()) {
+                updateLevel(w, mask, data, level, sourceOffset, sourceSize);
             }
-
-            cache->unbind();
-            w->setData(LanczosCacheRole, QVariant::fromValue(static_cast<void*>(cache)));
+            renderLevel(level, region, textureRect, hardwareClipping, data);
 
             // Delete the offscreen surface after 5 seconds
             m_timer.start(5000, this);
@@ -382,6 +224,180 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
     w->sceneWindow()->performPaint(mask, region, data);
 } // End of function
 
+static void setScissor(const QRect &rect, int targetHeight)
+{
+    glScissor(rect.x(), targetHeight - rect.y() - rect.height(), rect.width(), rect.height());
+}
+
+void LanczosFilter::updateLevel(EffectWindowImpl *w, int mask, const WindowPaintData &data, LanczosCache::Level *level,
+                                const QPoint &sourceOffset, const QSize &sourceSize)
+{
+    const int sw = sourceSize.width();
+    const int sh = sourceSize.height();
+    const int tw = level->texture->width();
+    const int th = level->texture->height();
+
+    // The kernel reaches at most 15 source pixels to each side, so a damaged source pixel
+    // only influences the target pixels within that distance. Only those get filtered again.
+    const int border = 16;
+    const float dx = sw / float(tw);
+    const float dy = sh / float(th);
+    const QRect damage = level->damage.boundingRect() & QRect(0, 0, sw, sh);
+    const QRect targetRect = QRect(QPoint(qFloor((damage.x() - border) / dx), qFloor((damage.y() - border) / dy)),
+                                   QPoint(qCeil((damage.x() + damage.width() + border) / dx),
+                                          qCeil((damage.y() + damage.height() + border) / dy)) - QPoint(1, 1))
+                             & QRect(0, 0, tw, th);
+    // the rows of the horizontally scaled window needed by the vertical pass
+    const QRect horizontalRect = QRect(QPoint(targetRect.x(), qFloor(targetRect.y() * dy) - border),
+                                       QPoint(targetRect.x() + targetRect.width(),
+                                              qCeil((targetRect.y() + targetRect.height()) * dy) + border) - QPoint(1, 1))
+                                 & QRect(0, 0, tw, sh);
+    level->damage = QRegion();
+    if (targetRect.isEmpty() || horizontalRect.isEmpty()) {
+        return;
+    }
+
+    WindowPaintData thumbData = data;
+    thumbData.setXScale(1.0);
+    thumbData.setYScale(1.0);
+    thumbData.setXTranslation(-w->x() + sourceOffset.x());
+    thumbData.setYTranslation(-w->y() + sourceOffset.y());
+    thumbData.setBrightness(1.0);
+    thumbData.setOpacity(1.0);
+    thumbData.setSaturation(1.0);
+
+    // Bind the offscreen FBO and draw the window on it unscaled
+    updateOffscreenSurfaces();
+    GLRenderTarget::pushRenderTarget(m_offscreenTarget);
+    const int offscreenHeight = m_offscreenTex->height();
+
+    QMatrix4x4 modelViewProjectionMatrix;
+    modelViewProjectionMatrix.ortho(0, m_offscreenTex->width(), offscreenHeight, 0 , 0, 65535);
+    thumbData.setProjectionMatrix(modelViewProjectionMatrix);
+
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    w->sceneWindow()->performPaint(mask, infiniteRegion(), thumbData);
+
+    // Create a scratch texture and copy the rendered window into it
+    GLTexture tex(GL_RGBA8, sw, sh);
+    tex.setFilter(GL_LINEAR);
+    tex.setWrapMode(GL_CLAMP_TO_EDGE);
+    tex.bind();
+
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, offscreenHeight - sh, sw, sh);
+
+    // Set up the shader for horizontal scaling
+    int kernelSize;
+    createKernel(dx, &kernelSize);
+    createOffsets(kernelSize, sw, Qt::Horizontal);
+
+    ShaderManager::instance()->pushShader(m_shader.data());
+    m_shader->setUniform(GLShader::ModelViewProjectionMatrix, modelViewProjectionMatrix);
+    setUniforms();
+
+    // Draw the window back into the FBO, this time scaled horizontally
+    glEnable(GL_SCISSOR_TEST);
+    setScissor(horizontalRect, offscreenHeight);
+    glClear(GL_COLOR_BUFFER_BIT);
+    QVector<float> verts;
+    QVector<float> texCoords;
+    verts.reserve(12);
+    texCoords.reserve(12);
+
+    texCoords << 1.0 << 0.0; verts << tw  << 0.0; // Top right
+    texCoords << 0.0 << 0.0; verts << 0.0 << 0.0; // Top left
+    texCoords << 0.0 << 1.0; verts << 0.0 << sh;  // Bottom left
+    texCoords << 0.0 << 1.0; verts << 0.0 << sh;  // Bottom left
+    texCoords << 1.0 << 1.0; verts << tw  << sh;  // Bottom right
+    texCoords << 1.0 << 0.0; verts << tw  << 0.0; // Top right
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    vbo->reset();
+    vbo->setData(6, 2, verts.constData(), texCoords.constData());
+    vbo->render(GL_TRIANGLES);
+
+    // At this point we don't need the scratch texture anymore
+    tex.unbind();
+    tex.discard();
+
+    // create scratch texture for second rendering pass
+    GLTexture tex2(GL_RGBA8, tw, sh);
+    tex2.setFilter(GL_LINEAR);
+    tex2.setWrapMode(GL_CLAMP_TO_EDGE);
+    tex2.bind();
+
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, horizontalRect.x(), sh - horizontalRect.y() - horizontalRect.height(),
+                        horizontalRect.x(), offscreenHeight - horizontalRect.y() - horizontalRect.height(),
+                        horizontalRect.width(), horizontalRect.height());
+
+    // Set up the shader for vertical scaling
+    createKernel(dy, &kernelSize);
+    createOffsets(kernelSize, offscreenHeight, Qt::Vertical);
+    setUniforms();
+
+    // Now draw the horizontally scaled window in the FBO at the right
+    // coordinates on the screen, while scaling it vertically and blending it.
+    setScissor(targetRect, offscreenHeight);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    verts.clear();
+
+    verts << tw  << 0.0; // Top right
+    verts << 0.0 << 0.0; // Top left
+    verts << 0.0 << th;  // Bottom left
+    verts << 0.0 << th;  // Bottom left
+    verts << tw  << th;  // Bottom right
+    verts << tw  << 0.0; // Top right
+    vbo->setData(6, 2, verts.constData(), texCoords.constData());
+    vbo->render(GL_TRIANGLES);
+    glDisable(GL_SCISSOR_TEST);
+
+    tex2.unbind();
+    tex2.discard();
+    ShaderManager::instance()->popShader();
+
+    // update the damaged part of the level
+    level->texture->bind();
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, targetRect.x(), th - targetRect.y() - targetRect.height(),
+                        targetRect.x(), offscreenHeight - targetRect.y() - targetRect.height(),
+                        targetRect.width(), targetRect.height());
+    level->texture->unbind();
+    GLRenderTarget::popRenderTarget();
+}
+
+void LanczosFilter::renderLevel(LanczosCache::Level *level, const QRegion &region, const QRect &textureRect,
+                                bool hardwareClipping, const WindowPaintData &data)
+{
+    GLTexture *texture = level->texture;
+    texture->bind();
+    if (hardwareClipping) {
+        glEnable(GL_SCISSOR_TEST);
+    }
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    const qreal rgb = data.brightness() * data.opacity();
+    const qreal a = data.opacity();
+
+    ShaderBinder binder(ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation);
+    GLShader *shader = binder.shader();
+    QMatrix4x4 mvp = data.screenProjectionMatrix();
+    mvp.translate(textureRect.x(), textureRect.y());
+    shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
+    shader->setUniform(GLShader::ModulationConstant, QVector4D(rgb, rgb, rgb, a));
+    shader->setUniform(GLShader::Saturation, data.saturation());
+
+    // a shared level may be slightly larger than the thumbnail, it gets scaled down linearly
+    texture->render(region, textureRect, hardwareClipping);
+
+    glDisable(GL_BLEND);
+    if (hardwareClipping) {
+        glDisable(GL_SCISSOR_TEST);
+    }
+    texture->unbind();
+}
+
 void LanczosFilter::timerEvent(QTimerEvent *event)
 {
     if (event->timerId() == m_timer.timerId()) {
@@ -408,11 +424,7 @@ void LanczosFilter::timerEvent(QTimerEvent *event)
 
 void LanczosFilter::discardCacheTexture(EffectWindow *w)
 {
-    QVariant cachedTextureVariant = w->data(LanczosCacheRole);
-    if (cachedTextureVariant.isValid()) {
-        delete static_cast< GLTexture*>(cachedTextureVariant.value<void*>());
-        w->setData(LanczosCacheRole, QVariant());
-    }
+    LanczosCache::discard(w);
 }
 
 void LanczosFilter::setUniforms()
@@ -421,5 +433,113 @@ void LanczosFilter::setUniforms()
     glUniform4fv(m_uKernel, 16, (const GLfloat*)m_kernel);
 }
 
+//****************************************
+// LanczosCache
+//****************************************
+
+// at most that many differently sized thumbnails of a window are cached
+static const int s_maxCacheLevels = 4;
+
+LanczosCache::~LanczosCache()
+{
+    for (const Level &level : m_levels) {
+        delete level.texture;
+    }
+}
+
+void LanczosCache::setSourceGeometry(const QPoint &offset, const QSize &size)
+{
+    m_offset = offset;
+    if (m_sourceSize == size) {
+        return;
+    }
+    m_sourceSize = size;
+    for (const Level &level : m_levels) {
+        delete level.texture;
+    }
+    m_levels.clear();
+}
+
+void LanczosCache::addDamage(const QRegion &damage)
+{
+    const QRegion sourceDamage = damage.translated(m_offset);
+    for (Level &level : m_levels) {
+        level.damage += sourceDamage;
+    }
+}
+
+void LanczosCache::invalidate()
+{
+    const QRegion sourceRegion(QRect(QPoint(0, 0), m_sourceSize));
+    for (Level &level : m_levels) {
+        level.damage = sourceRegion;
+    }
+}
+
+LanczosCache::Level *LanczosCache::level(const QSize &size)
+{
+    ++m_useCounter;
+    // thumbnails up to 10 % smaller than a level share it
+    const QSize maximumSize = size + size / 10;
+    Level *best = nullptr;
+    for (Level &level : m_levels) {
+        const QSize levelSize = level.texture->size();
+        if (levelSize.width() < size.width() || levelSize.height() < size.height() ||
+                levelSize.width() > maximumSize.width() || levelSize.height() > maximumSize.height()) {
+            continue;
+        }
+        if (!best || levelSize.width() < best->texture->width()) {
+            best = &level;
+        }
+    }
+    if (best) {
+        best->lastUsed = m_useCounter;
+        return best;
+    }
+
+    if (m_levels.count() >= s_maxCacheLevels) {
+        auto leastRecentlyUsed = std::min_element(m_levels.begin(), m_levels.end(),
+            [](const Level &a, const Level &b) {
+                return a.lastUsed < b.lastUsed;
+            }
+        );
+        delete leastRecentlyUsed->texture;
+        m_levels.erase(leastRecentlyUsed);
+    }
+
+    GLTexture *texture = new GLTexture(GL_RGBA8, size.width(), size.height());
+    texture->setFilter(GL_LINEAR);
+    texture->setWrapMode(GL_CLAMP_TO_EDGE);
+    m_levels.append(Level{texture, QRegion(QRect(QPoint(0, 0), m_sourceSize)), m_useCounter});
+    return &m_levels.last();
+}
+
+LanczosCache *LanczosCache::fromWindow(EffectWindow *w)
+{
+    return static_cast<LanczosCache*>(w->data(LanczosCacheRole).value<void*>());
+}
+
+void LanczosCache::addDamage(EffectWindow *w, const QRegion &damage)
+{
+    if (LanczosCache *cache = fromWindow(w)) {
+        cache->addDamage(damage);
+    }
+}
+
+void LanczosCache::invalidate(EffectWindow *w)
+{
+    if (LanczosCache *cache = fromWindow(w)) {
+        cache->invalidate();
+    }
+}
+
+void LanczosCache::discard(EffectWindow *w)
+{
+    if (LanczosCache *cache = fromWindow(w)) {
+        delete cache;
+        w->setData(LanczosCacheRole, QVariant());
+    }
+}
+
 } // namespace
 
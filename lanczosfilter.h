@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QObject>
 #include <QBasicTimer>
+#include <QRegion>
 #include <QVector>
 #include <QVector2D>
 #include <QVector4D>
@@ -40,6 +41,55 @@ class GLTexture;
 class GLRenderTarget;
 class GLShader;
 
+/**
+ * Lanczos downscaled textures of a window, stored in the LanczosCacheRole of the EffectWindow.
+ *
+ * Each level holds the window scaled to one size. A level is shared by all thumbnails of the
+ * window with a similar size and only the damaged parts of a level get filtered again.
+ **/
+class LanczosCache
+{
+public:
+    struct Level {
+        GLTexture *texture;
+        // area in source coordinates which needs to be filtered again
+        QRegion damage;
+        quint64 lastUsed;
+    };
+    ~LanczosCache();
+
+    /**
+     * Sets the offset of the window geometry inside the expanded geometry and the size of
+     * the expanded geometry. All levels are dropped if the size changed.
+     **/
+    void setSourceGeometry(const QPoint &offset, const QSize &size);
+    /**
+     * Marks @p damage in window coordinates as needing to be filtered again.
+     **/
+    void addDamage(const QRegion &damage);
+    /**
+     * Marks all levels as needing to be filtered again. Used for changes which do not
+     * damage the window content, like the decoration, the shadow or the shape.
+     **/
+    void invalidate();
+    /**
+     * @returns a level which can be used for a thumbnail of @p size, creating it if needed.
+     * The returned level may be slightly larger than @p size.
+     **/
+    Level *level(const QSize &size);
+
+    static LanczosCache *fromWindow(EffectWindow *w);
+    static void addDamage(EffectWindow *w, const QRegion &damage);
+    static void invalidate(EffectWindow *w);
+    static void discard(EffectWindow *w);
+
+private:
+    QPoint m_offset;
+    QSize m_sourceSize;
+    QVector<Level> m_levels;
+    quint64 m_useCounter = 0;
+};
+
 class LanczosFilter
     : public QObject
 {
@@ -57,6 +107,10 @@ private:
     void updateOffscreenSurfaces();
     void setUniforms();
     void discardCacheTexture(EffectWindow *w);
+    void updateLevel(EffectWindowImpl *w, int mask, const WindowPaintData &data, LanczosCache::Level *level,
+                     const QPoint &sourceOffset, const QSize &sourceSize);
+    void renderLevel(LanczosCache::Level *level, const QRegion &region, const QRect &textureRect,
+                     bool hardwareClipping, const WindowPaintData &data);
 
     void createKernel(float delta, int *kernelSize);
     void createOffsets(int count, float width, Qt::Orientation direction);
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "connection.h"
 #include "context.h"
 #include "events.h"
+#include "../input_latency.h"
 #include "../logind.h"
 #include "../udev.h"
 #include "libinput_logging.h"
@@ -146,6 +147,9 @@ void Connection::handleEvent()
         if (!event) {
             break;
         }
+        if (InputLatencyTracer::self()->isEnabled()) {
+            event->setReadTime(InputLatencyTracer::now());
+        }
         m_eventQueue << event;
     } while (true);
     if (wasEmpty && !m_eventQueue.isEmpty()) {
@@ -153,11 +157,39 @@ void Connection::handleEvent()
     }
 }
 
+static void beginTrace(Event *event)
+{
+    auto tracer = InputLatencyTracer::self();
+    if (!tracer->isEnabled()) {
+        return;
+    }
+    switch (event->type()) {
+    case LIBINPUT_EVENT_KEYBOARD_KEY:
+        tracer->beginEvent(InputLatencyTracer::KeyEvent, static_cast<KeyEvent*>(event)->timeMicroseconds(), event->readTime());
+        break;
+    case LIBINPUT_EVENT_POINTER_MOTION:
+    case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+    case LIBINPUT_EVENT_POINTER_BUTTON:
+    case LIBINPUT_EVENT_POINTER_AXIS:
+        tracer->beginEvent(InputLatencyTracer::PointerEvent, static_cast<PointerEvent*>(event)->timeMicroseconds(), event->readTime());
+        break;
+    case LIBINPUT_EVENT_TOUCH_DOWN:
+    case LIBINPUT_EVENT_TOUCH_UP:
+    case LIBINPUT_EVENT_TOUCH_MOTION:
+        tracer->beginEvent(InputLatencyTracer::TouchEvent, static_cast<TouchEvent*>(event)->timeMicroseconds(), event->readTime());
+        break;
+    default:
+        break;
+    }
+}
+
 void Connection::processEvents()
 {
     QMutexLocker locker(&m_mutex);
     while (!m_eventQueue.isEmpty()) {
         QScopedPointer<Event> event(m_eventQueue.takeFirst());
+        // merged motion and axis events are traced with the timestamps of the oldest event
+        beginTrace(event.data());
         switch (event->type()) {
             case LIBINPUT_EVENT_DEVICE_ADDED:
                 if (libinput_device_has_capability(event->device(), LIBINPUT_DEVICE_CAP_KEYBOARD)) {
@@ -289,6 +321,7 @@ void Connection::processEvents()
                 // nothing
                 break;
         }
+        InputLatencyTracer::self()->endEvent();
     }
     if (wasSuspended) {
         if (m_keyboardBeforeSuspend && !m_keyboard) {
@@ -98,6 +98,11 @@ uint32_t KeyEvent::time() const
     return libinput_event_keyboard_get_time(m_keyboardEvent);
 }
 
+quint64 KeyEvent::timeMicroseconds() const
+{
+    return libinput_event_keyboard_get_time_usec(m_keyboardEvent);
+}
+
 PointerEvent::PointerEvent(libinput_event *event, libinput_event_type type)
     : Event(event, type)
     , m_pointerEvent(libinput_event_get_pointer_event(event))
@@ -131,6 +136,11 @@ uint32_t PointerEvent::time() const
     return libinput_event_pointer_get_time(m_pointerEvent);
 }
 
+quint64 PointerEvent::timeMicroseconds() const
+{
+    return libinput_event_pointer_get_time_usec(m_pointerEvent);
+}
+
 uint32_t PointerEvent::button() const
 {
     Q_ASSERT(type() == LIBINPUT_EVENT_POINTER_BUTTON);
@@ -184,6 +194,11 @@ quint32 TouchEvent::time() const
     return libinput_event_touch_get_time(m_touchEvent);
 }
 
+quint64 TouchEvent::timeMicroseconds() const
+{
+    return libinput_event_touch_get_time_usec(m_touchEvent);
+}
+
 QPointF TouchEvent::absolutePos() const
 {
     Q_ASSERT(type() == LIBINPUT_EVENT_TOUCH_DOWN || type() == LIBINPUT_EVENT_TOUCH_MOTION);
@@ -46,12 +46,24 @@ public:
 
     static Event *create(libinput_event *event);
 
+    /**
+     * The CLOCK_MONOTONIC time in nanoseconds the event got read from libinput,
+     * only set if input latency tracing is enabled.
+     **/
+    qint64 readTime() const {
+        return m_readTime;
+    }
+    void setReadTime(qint64 time) {
+        m_readTime = time;
+    }
+
 protected:
     Event(libinput_event *event, libinput_event_type type);
 
 private:
     libinput_event *m_event;
     libinput_event_type m_type;
+    qint64 m_readTime = 0;
 };
 
 class KeyEvent : public Event
@@ -63,6 +75,7 @@ public:
     uint32_t key() const;
     InputRedirection::KeyboardKeyState state() const;
     uint32_t time() const;
+    quint64 timeMicroseconds() const;
 
     operator libinput_event_keyboard*() {
         return m_keyboardEvent;
@@ -87,6 +100,7 @@ public:
     uint32_t button() const;
     InputRedirection::PointerButtonState buttonState() const;
     uint32_t time() const;
+    quint64 timeMicroseconds() const;
     QVector<InputRedirection::PointerAxis> axis() const;
     qreal axisValue(InputRedirection::PointerAxis a) const;
 
@@ -108,6 +122,7 @@ public:
     virtual ~TouchEvent();
 
     quint32 time() const;
+    quint64 timeMicroseconds() const;
     QPointF absolutePos() const;
     QPointF absolutePos(const QSize &size) const;
     qint32 id() const;
@@ -662,6 +662,11 @@ int Effect::requestedEffectChainPosition() const
     return 0;
 }
 
+bool Effect::isPrePaintWindowThreadSafe() const
+{
+    return false;
+}
+
 xcb_connection_t *Effect::xcbConnection() const
 {
     return effects->xcbConnection();
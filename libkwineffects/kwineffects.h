@@ -182,7 +182,7 @@ X-KDE-Library=kwin4_effect_cooleffect
 
 #define KWIN_EFFECT_API_MAKE_VERSION( major, minor ) (( major ) << 8 | ( minor ))
 #define KWIN_EFFECT_API_VERSION_MAJOR 0
-#define KWIN_EFFECT_API_VERSION_MINOR 224
+#define KWIN_EFFECT_API_VERSION_MINOR 225
 #define KWIN_EFFECT_API_VERSION KWIN_EFFECT_API_MAKE_VERSION( \
         KWIN_EFFECT_API_VERSION_MAJOR, KWIN_EFFECT_API_VERSION_MINOR )
 
@@ -545,6 +545,23 @@ public:
      **/
     virtual int requestedEffectChainPosition() const;
 
+    /**
+     * Reimplement this method to indicate that prePaintWindow() may be invoked concurrently
+     * for different windows from worker threads.
+     *
+     * Such an implementation may only modify the passed in WindowPrePaintData and the painting
+     * state of the passed in EffectWindow (e.g. enablePainting()). State shared between windows
+     * may only be read. In particular it must not add repaints, emit signals or modify members
+     * of the Effect. The implementation must not rely on the windows being processed in
+     * stacking order.
+     *
+     * The prePaintWindow() pass is only performed concurrently if at least one Effect is active
+     * and all active Effects return @c true. The default implementation returns @c false.
+     *
+     * @since 5.6
+     **/
+    virtual bool isPrePaintWindowThreadSafe() const;
+
     static QPoint cursorPos();
 
     /**
@@ -1794,6 +1794,7 @@ public:
     void reallocateBuffer(size_t size);
     GLvoid *mapNextFreeRange(size_t size);
     void reallocatePersistentBuffer(size_t size);
+    bool isFenceSignaled(intptr_t end) const;
     bool awaitFence(intptr_t offset);
     GLvoid *getIdleRange(size_t size);
 
@@ -1821,9 +1822,13 @@ public:
     FrameSizesArray<4> frameSizes;
     VertexAttrib attrib[VertexAttributeCount];
     Bitfield enabledArrays;
+    GLVertexBuffer::Statistics statistics;
     static IndexBuffer *s_indexBuffer;
 };
 
+// the persistent buffer grows instead of waiting for the GPU until it reaches this size
+static const size_t s_maxPersistentBufferSize = 32 * 1024 * 1024;
+
 bool GLVertexBufferPrivate::hasMapBufferRange = false;
 bool GLVertexBufferPrivate::supportsIndexedQuads = false;
 GLVertexBuffer *GLVertexBufferPrivate::streamingBuffer = nullptr;
@@ -1924,6 +1929,20 @@ void GLVertexBufferPrivate::reallocatePersistentBuffer(size_t size)
 
     nextOffset = 0;
     bufferEnd = bufferSize;
+
+    statistics.reallocations++;
+    statistics.bufferSize = bufferSize;
+}
+
+bool GLVertexBufferPrivate::isFenceSignaled(intptr_t end) const
+{
+    // the fence awaitFence() would wait on
+    for (const BufferFence &fence : fences) {
+        if (fence.nextEnd >= end) {
+            return fence.signaled();
+        }
+    }
+    return true;
 }
 
 bool GLVertexBufferPrivate::awaitFence(intptr_t end)
@@ -1941,6 +1960,7 @@ bool GLVertexBufferPrivate::awaitFence(intptr_t end)
 
     if (!fence.signaled()) {
         qCDebug(LIBKWINGLUTILS) << "Stalling on VBO fence";
+        statistics.fenceWaits++;
         const GLenum ret = glClientWaitSync(fence.sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
 
         if (ret == GL_TIMEOUT_EXPIRED || ret == GL_WAIT_FAILED) {
@@ -1965,6 +1985,7 @@ GLvoid *GLVertexBufferPrivate::getIdleRange(size_t size)
 
     // Handle wrap-around
     if (unlikely(nextOffset + size > bufferSize)) {
+        statistics.wrapArounds++;
         nextOffset = 0;
         bufferEnd -= bufferSize;
 
@@ -1979,8 +2000,13 @@ GLvoid *GLVertexBufferPrivate::getIdleRange(size_t size)
     }
 
     if (unlikely(nextOffset + intptr_t(size) > bufferEnd)) {
-        if (!awaitFence(nextOffset + size))
+        if (bufferSize < s_maxPersistentBufferSize && !isFenceSignaled(nextOffset + size)) {
+            // The GPU still uses the range, rather grow the buffer than stall.
+            // Draws already issued keep the old storage alive.
+            reallocatePersistentBuffer(bufferSize * 2);
+        } else if (!awaitFence(nextOffset + size)) {
             return nullptr;
+        }
     }
 
     return map + nextOffset;
@@ -1995,6 +2021,8 @@ void GLVertexBufferPrivate::reallocateBuffer(size_t size)
     glBufferData(GL_ARRAY_BUFFER, alloc, 0, usage);
 
     bufferSize = alloc;
+    statistics.reallocations++;
+    statistics.bufferSize = alloc;
 }
 
 GLvoid *GLVertexBufferPrivate::mapNextFreeRange(size_t size)
@@ -2006,8 +2034,10 @@ GLvoid *GLVertexBufferPrivate::mapNextFreeRange(size_t size)
         if (size > bufferSize) {
             reallocateBuffer(size);
         } else {
+            // orphan the data store
             access |= GL_MAP_INVALIDATE_BUFFER_BIT;
             access ^= GL_MAP_UNSYNCHRONIZED_BIT;
+            statistics.wrapArounds++;
         }
 
         nextOffset = 0;
@@ -2061,6 +2091,7 @@ GLvoid *GLVertexBuffer::map(size_t size)
 {
     d->mappedSize = size;
     d->frameSize += size;
+    d->statistics.uploadedBytes += size;
 
     if (d->persistent)
         return d->getIdleRange(size);
@@ -2270,6 +2301,16 @@ void GLVertexBuffer::endOfFrame()
     }
 }
 
+GLVertexBuffer::Statistics GLVertexBuffer::statistics() const
+{
+    return d->statistics;
+}
+
+bool GLVertexBuffer::isPersistent() const
+{
+    return d->persistent;
+}
+
 void GLVertexBuffer::framePosted()
 {
     if (!d->persistent)
@@ -728,6 +728,32 @@ public:
      */
     void framePosted();
 
+    /**
+     * Counters about the data streamed through the buffer since it got created.
+     * @since 5.6
+     **/
+    struct Statistics {
+        quint64 uploadedBytes = 0;
+        /**
+         * How often the CPU had to wait for the GPU to release a part of the buffer.
+         **/
+        quint64 fenceWaits = 0;
+        quint64 wrapArounds = 0;
+        quint64 reallocations = 0;
+        quint64 bufferSize = 0;
+    };
+    /**
+     * @returns the upload statistics of this buffer
+     * @since 5.6
+     **/
+    Statistics statistics() const;
+
+    /**
+     * @returns whether the buffer is a persistently mapped ring buffer
+     * @since 5.6
+     **/
+    bool isPersistent() const;
+
     /**
      * @internal
      */
@@ -114,7 +114,10 @@ Options::Options(QObject *parent)
     , m_useCompositing(Options::defaultUseCompositing())
     , m_compositingInitialized(Options::defaultCompositingInitialized())
     , m_hiddenPreviews(Options::defaultHiddenPreviews())
+    , m_hiddenPreviewsBudget(Options::defaultHiddenPreviewsBudget())
     , m_unredirectFullscreen(Options::defaultUnredirectFullscreen())
+    , m_hiddenFrameCallbackInterval(Options::defaultHiddenFrameCallbackInterval())
+    , m_coalescePointerMotion(Options::defaultCoalescePointerMotion())
     , m_glSmoothScale(Options::defaultGlSmoothScale())
     , m_colorCorrected(Options::defaultColorCorrected())
     , m_xrenderSmoothScale(Options::defaultXrenderSmoothScale())
@@ -634,6 +637,15 @@ void Options::setHiddenPreviews(int hiddenPreviews)
     emit hiddenPreviewsChanged();
 }
 
+void Options::setHiddenPreviewsBudget(int budget)
+{
+    if (m_hiddenPreviewsBudget == budget) {
+        return;
+    }
+    m_hiddenPreviewsBudget = budget;
+    emit hiddenPreviewsBudgetChanged();
+}
+
 void Options::setUnredirectFullscreen(bool unredirectFullscreen)
 {
     if (GLPlatform::instance()->driver() == Driver_Intel)
@@ -648,6 +660,24 @@ void Options::setUnredirectFullscreen(bool unredirectFullscreen)
     emit unredirectFullscreenChanged();
 }
 
+void Options::setHiddenFrameCallbackInterval(int interval)
+{
+    if (m_hiddenFrameCallbackInterval == interval) {
+        return;
+    }
+    m_hiddenFrameCallbackInterval = interval;
+    emit hiddenFrameCallbackIntervalChanged();
+}
+
+void Options::setCoalescePointerMotion(bool coalesce)
+{
+    if (m_coalescePointerMotion == coalesce) {
+        return;
+    }
+    m_coalescePointerMotion = coalesce;
+    emit coalescePointerMotionChanged();
+}
+
 void Options::setGlSmoothScale(int glSmoothScale)
 {
     if (m_glSmoothScale == glSmoothScale) {
@@ -997,7 +1027,7 @@ void Options::reloadCompositingSettings(bool force)
     m_xrenderSmoothScale = config.readEntry("XRenderSmoothScale", false);
 
     HiddenPreviews previews = Options::defaultHiddenPreviews();
-    // 4 - off, 5 - shown, 6 - always, other are old values
+    // 4 - off, 5 - shown, 6 - always, 7 - recent desktops, other are old values
     int hps = config.readEntry("HiddenPreviews", 5);
     if (hps == 4)
         previews = HiddenPreviewsNever;
@@ -1005,9 +1035,14 @@ void Options::reloadCompositingSettings(bool force)
         previews = HiddenPreviewsShown;
     else if (hps == 6)
         previews = HiddenPreviewsAlways;
+    else if (hps == 7)
+        previews = HiddenPreviewsRecentDesktops;
     setHiddenPreviews(previews);
+    setHiddenPreviewsBudget(qMax(0, config.readEntry("HiddenPreviewsBudget", Options::defaultHiddenPreviewsBudget())));
 
     setUnredirectFullscreen(config.readEntry("UnredirectFullscreen", Options::defaultUnredirectFullscreen()));
+    setHiddenFrameCallbackInterval(qMax(0, config.readEntry("HiddenFrameCallbackInterval", Options::defaultHiddenFrameCallbackInterval())));
+    setCoalescePointerMotion(config.readEntry("CoalescePointerMotion", Options::defaultCoalescePointerMotion()));
     // TOOD: add setter
     animationSpeed = qBound(0, config.readEntry("AnimationSpeed", Options::defaultAnimationSpeed()), 6);
 
@@ -40,7 +40,10 @@ enum HiddenPreviews {
     // are kept mapped, only hidden windows are unmapped.
     HiddenPreviewsShown,
     // All windows are kept mapped regardless of their state.
-    HiddenPreviewsAlways
+    HiddenPreviewsAlways,
+    // Like HiddenPreviewsShown, but only the windows of the most recently used virtual
+    // desktops which fit into the hidden previews budget are kept mapped.
+    HiddenPreviewsRecentDesktops
 };
 
 class Settings;
@@ -170,6 +173,21 @@ class KWIN_EXPORT Options : public QObject
     Q_PROPERTY(bool compositingInitialized READ isCompositingInitialized WRITE setCompositingInitialized NOTIFY compositingInitializedChanged)
     Q_PROPERTY(int hiddenPreviews READ hiddenPreviews WRITE setHiddenPreviews NOTIFY hiddenPreviewsChanged)
     Q_PROPERTY(bool unredirectFullscreen READ isUnredirectFullscreen WRITE setUnredirectFullscreen NOTIFY unredirectFullscreenChanged)
+    /**
+     * Memory in MiB the window pixmaps of inactive virtual desktops may use with
+     * HiddenPreviewsRecentDesktops.
+     **/
+    Q_PROPERTY(int hiddenPreviewsBudget READ hiddenPreviewsBudget WRITE setHiddenPreviewsBudget NOTIFY hiddenPreviewsBudgetChanged)
+    /**
+     * Minimum interval in milliseconds between frame callbacks sent to Wayland surfaces which
+     * were not visible in the painted frame. 0 sends the frame callbacks with every frame.
+     **/
+    Q_PROPERTY(int hiddenFrameCallbackInterval READ hiddenFrameCallbackInterval WRITE setHiddenFrameCallbackInterval NOTIFY hiddenFrameCallbackIntervalChanged)
+    /**
+     * Whether pointer motion is accumulated and delivered once per frame instead of for each
+     * event of the input device.
+     **/
+    Q_PROPERTY(bool coalescePointerMotion READ isCoalescePointerMotion WRITE setCoalescePointerMotion NOTIFY coalescePointerMotionChanged)
     /**
      * 0 = no, 1 = yes when transformed,
      * 2 = try trilinear when transformed; else 1,
@@ -543,9 +561,18 @@ public:
     HiddenPreviews hiddenPreviews() const {
         return m_hiddenPreviews;
     }
+    int hiddenPreviewsBudget() const {
+        return m_hiddenPreviewsBudget;
+    }
     bool isUnredirectFullscreen() const {
         return m_unredirectFullscreen && !kwinApp()->requiresCompositing();
     }
+    int hiddenFrameCallbackInterval() const {
+        return m_hiddenFrameCallbackInterval;
+    }
+    bool isCoalescePointerMotion() const {
+        return m_coalescePointerMotion;
+    }
     // OpenGL
     // 0 = no, 1 = yes when transformed,
     // 2 = try trilinear when transformed; else 1,
@@ -642,7 +669,10 @@ public:
     void setUseCompositing(bool useCompositing);
     void setCompositingInitialized(bool compositingInitialized);
     void setHiddenPreviews(int hiddenPreviews);
+    void setHiddenPreviewsBudget(int budget);
     void setUnredirectFullscreen(bool unredirectFullscreen);
+    void setHiddenFrameCallbackInterval(int interval);
+    void setCoalescePointerMotion(bool coalesce);
     void setGlSmoothScale(int glSmoothScale);
     void setXrenderSmoothScale(bool xrenderSmoothScale);
     void setMaxFpsInterval(qint64 maxFpsInterval);
@@ -730,9 +760,18 @@ public:
     static HiddenPreviews defaultHiddenPreviews() {
         return HiddenPreviewsShown;
     }
+    static int defaultHiddenPreviewsBudget() {
+        return 256;
+    }
     static bool defaultUnredirectFullscreen() {
         return false;
     }
+    static int defaultHiddenFrameCallbackInterval() {
+        return 1000;
+    }
+    static bool defaultCoalescePointerMotion() {
+        return false;
+    }
     static int defaultGlSmoothScale() {
         return 2;
     }
@@ -837,7 +876,10 @@ Q_SIGNALS:
     void useCompositingChanged();
     void compositingInitializedChanged();
     void hiddenPreviewsChanged();
+    void hiddenPreviewsBudgetChanged();
     void unredirectFullscreenChanged();
+    void hiddenFrameCallbackIntervalChanged();
+    void coalescePointerMotionChanged();
     void glSmoothScaleChanged();
     void colorCorrectedChanged();
     void xrenderSmoothScaleChanged();
@@ -886,7 +928,10 @@ private:
     bool m_useCompositing;
     bool m_compositingInitialized;
     HiddenPreviews m_hiddenPreviews;
+    int m_hiddenPreviewsBudget;
     bool m_unredirectFullscreen;
+    int m_hiddenFrameCallbackInterval;
+    bool m_coalescePointerMotion;
     int m_glSmoothScale;
     bool m_colorCorrected;
     bool m_xrenderSmoothScale;
@@ -31,8 +31,15 @@ KGlobalAccelImpl::~KGlobalAccelImpl() = default;
 
 bool KGlobalAccelImpl::grabKey(int key, bool grab)
 {
-    Q_UNUSED(key)
-    Q_UNUSED(grab)
+    // KWin only forwards key presses which match a grabbed key
+    if (grab) {
+        m_grabbedKeys.insert(key);
+    } else {
+        m_grabbedKeys.remove(key);
+    }
+    if (m_enabled && !m_shuttingDown) {
+        KWin::InputRedirection::self()->setGlobalAccelKeyGrabbed(key, grab);
+    }
     return true;
 }
 
@@ -49,7 +56,13 @@ void KGlobalAccelImpl::setEnabled(bool enabled)
             m_inputDestroyedConnection = connect(s_input, &QObject::destroyed, this, [this] { m_shuttingDown = true; });
         }
     }
+    m_enabled = enabled;
     s_input->registerGlobalAccel(enabled ? this : nullptr);
+    if (enabled) {
+        for (int key : m_grabbedKeys) {
+            s_input->setGlobalAccelKeyGrabbed(key, true);
+        }
+    }
 }
 
 bool KGlobalAccelImpl::checkKeyPressed(int keyQt)
@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <KGlobalAccel/private/kglobalaccel_interface.h>
 
 #include <QObject>
+#include <QSet>
 
 class KGlobalAccelImpl : public KGlobalAccelInterface
 {
@@ -42,6 +43,8 @@ public Q_SLOTS:
 
 private:
     bool m_shuttingDown = false;
+    bool m_enabled = false;
+    QSet<int> m_grabbedKeys;
     QMetaObject::Connection m_inputDestroyedConnection;
 };
 
@@ -26,6 +26,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <KWayland/Client/shm_pool.h>
 #include <KWayland/Client/surface.h>
 
+#include <QPainter>
+
 namespace KWin
 {
 namespace QPA
@@ -58,58 +60,105 @@ QPaintDevice *BackingStore::paintDevice()
     return &m_backBuffer;
 }
 
+// the number of buffers which are kept for painting while the compositor still holds others
+static const int s_maxBuffers = 3;
+
 void BackingStore::resize(const QSize &size, const QRegion &staticContents)
 {
     Q_UNUSED(staticContents)
     m_size = size;
-    if (!m_buffer) {
-        return;
+    releaseBuffers();
+}
+
+void BackingStore::releaseBuffers()
+{
+    for (const PooledBuffer &pooled : m_buffers) {
+        if (auto b = pooled.buffer.toStrongRef()) {
+            b->setUsed(false);
+        }
     }
-    m_buffer.toStrongRef()->setUsed(false);
+    m_buffers.clear();
     m_buffer.clear();
 }
 
 void BackingStore::flush(QWindow *window, const QRegion &region, const QPoint &offset)
 {
-    Q_UNUSED(region)
     Q_UNUSED(offset)
     auto s = static_cast<Window *>(window->handle())->surface();
     s->attachBuffer(m_buffer);
-    // TODO: proper damage region
-    s->damage(QRect(QPoint(0, 0), m_backBuffer.size()));
+    s->damage(region);
     s->commit(KWayland::Client::Surface::CommitFlag::None);
+    // the compositor picks up the commit when it dispatches the internal connection
     waylandServer()->internalClientConection()->flush();
-    waylandServer()->dispatch();
+
+    const auto current = m_buffer.toStrongRef();
+    for (PooledBuffer &pooled : m_buffers) {
+        if (pooled.buffer.toStrongRef() != current) {
+            pooled.missingDamage |= region;
+        }
+    }
 }
 
 void BackingStore::beginPaint(const QRegion&)
 {
-    if (m_buffer) {
-        auto b = m_buffer.toStrongRef();
-        if (b->isReleased()) {
-            // we can re-use this buffer
-            b->setReleased(false);
-            return;
-        } else {
-            // buffer is still in use, get a new one
-            b->setUsed(false);
+    const auto current = m_buffer.toStrongRef();
+    if (current && current->isReleased()) {
+        // we can re-use this buffer, it has the latest content
+        current->setReleased(false);
+        return;
+    }
+    // find a buffer the compositor is done with, it only misses the regions flushed since
+    PooledBuffer *next = nullptr;
+    for (auto it = m_buffers.begin(); it != m_buffers.end();) {
+        const auto b = (*it).buffer.toStrongRef();
+        if (!b) {
+            it = m_buffers.erase(it);
+            continue;
         }
+        if (!next && b != current && b->isReleased()) {
+            next = &(*it);
+        }
+        ++it;
     }
-    auto oldBuffer = m_buffer.toStrongRef();
-    m_buffer.clear();
-    m_buffer = m_shm->getBuffer(m_size, m_size.width() * 4);
-    if (!m_buffer) {
-        m_backBuffer = QImage();
-        return;
+    if (!next) {
+        if (m_buffers.count() >= s_maxBuffers) {
+            // all buffers are still in use by the compositor, give up the oldest one
+            for (auto it = m_buffers.begin(); it != m_buffers.end(); ++it) {
+                const auto b = (*it).buffer.toStrongRef();
+                if (b != current) {
+                    b->setUsed(false);
+                    m_buffers.erase(it);
+                    break;
+                }
+            }
+        }
+        PooledBuffer pooled;
+        pooled.buffer = m_shm->getBuffer(m_size, m_size.width() * 4);
+        if (!pooled.buffer) {
+            m_buffer.clear();
+            m_backBuffer = QImage();
+            return;
+        }
+        pooled.buffer.toStrongRef()->setUsed(true);
+        pooled.missingDamage = QRect(QPoint(0, 0), m_size);
+        m_buffers << pooled;
+        next = &m_buffers.last();
     }
-    auto b = m_buffer.toStrongRef();
-    b->setUsed(true);
+    auto b = next->buffer.toStrongRef();
+    b->setReleased(false);
+    m_buffer = next->buffer;
     m_backBuffer = QImage(b->address(), m_size.width(), m_size.height(), QImage::Format_ARGB32_Premultiplied);
-    if (oldBuffer) {
-        b->copy(oldBuffer->address());
+    if (current) {
+        const QImage front(current->address(), m_size.width(), m_size.height(), QImage::Format_ARGB32_Premultiplied);
+        QPainter p(&m_backBuffer);
+        p.setCompositionMode(QPainter::CompositionMode_Source);
+        for (const QRect &rect : next->missingDamage.rects()) {
+            p.drawImage(rect, front, rect);
+        }
     } else {
         m_backBuffer.fill(Qt::transparent);
     }
+    next->missingDamage = QRegion();
 }
 
 }
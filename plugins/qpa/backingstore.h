@@ -22,6 +22,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <qpa/qplatformbackingstore.h>
 
+#include <QVector>
+
 namespace KWayland
 {
 namespace Client
@@ -48,8 +50,18 @@ public:
     void beginPaint(const QRegion &) override;
 
 private:
+    void releaseBuffers();
+    /**
+     * A buffer of the current size together with the region flushed from other
+     * buffers since it got painted the last time.
+     **/
+    struct PooledBuffer {
+        QWeakPointer<KWayland::Client::Buffer> buffer;
+        QRegion missingDamage;
+    };
     KWayland::Client::ShmPool *m_shm;
     QWeakPointer<KWayland::Client::Buffer> m_buffer;
+    QVector<PooledBuffer> m_buffers;
     QImage m_backBuffer;
     QSize m_size;
 };
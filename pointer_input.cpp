@@ -19,6 +19,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "pointer_input.h"
 #include "abstract_backend.h"
+#include "composite.h"
+#include "options.h"
+#include "input_latency.h"
 #include "screens.h"
 #include "shell_client.h"
 #include "wayland_server.h"
@@ -32,6 +35,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <KScreenLocker/KsldApp>
 
 #include <QHoverEvent>
+#include <QTimer>
 #include <QWindow>
 
 #include <linux/input.h>
@@ -66,6 +70,28 @@ static bool screenContainsPos(const QPointF &pos)
     return false;
 }
 
+/**
+ * Confines @p pos moving from @p current to the screens.
+ * @returns @c false if the position cannot be reached at all
+ **/
+static bool confineToScreens(QPointF &pos, const QPointF &current)
+{
+    // verify that at least one screen contains the pointer position
+    if (screenContainsPos(pos)) {
+        return true;
+    }
+    // allow either x or y to pass
+    QPointF p = QPointF(current.x(), pos.y());
+    if (!screenContainsPos(p)) {
+        p = QPointF(pos.x(), current.y());
+        if (!screenContainsPos(p)) {
+            return false;
+        }
+    }
+    pos = p;
+    return true;
+}
+
 PointerInputRedirection::PointerInputRedirection(InputRedirection* parent)
     : QObject(parent)
     , m_input(parent)
@@ -85,6 +111,13 @@ void PointerInputRedirection::init()
     connect(workspace(), &QObject::destroyed, this, [this] { m_inited = false; });
     connect(waylandServer(), &QObject::destroyed, this, [this] { m_inited = false; });
 
+    m_motionTimer = new QTimer(this);
+    m_motionTimer->setSingleShot(true);
+    connect(m_motionTimer, &QTimer::timeout, this, &PointerInputRedirection::flushPendingMotion);
+    if (Compositor::self()) {
+        connect(Compositor::self(), &Compositor::aboutToComposite, this, &PointerInputRedirection::flushPendingMotion);
+    }
+
     // warp the cursor to center of screen
     warp(screens()->geometry().center());
     updateAfterScreenChange();
@@ -95,12 +128,53 @@ void PointerInputRedirection::processMotion(const QPointF &pos, uint32_t time)
     if (!m_inited) {
         return;
     }
+    if (!options->isCoalescePointerMotion()) {
+        flushPendingMotion();
+        deliverMotion(pos, time);
+        return;
+    }
+    // only keep the latest position, it gets delivered with the next frame
+    QPointF p = pos;
+    if (!confineToScreens(p, m_pendingMotion.valid ? m_pendingMotion.pos : m_pos)) {
+        return;
+    }
+    m_pendingMotion.pos = p;
+    m_pendingMotion.time = time;
+    m_pendingMotion.valid = true;
+    if (!m_motionTimer->isActive()) {
+        // fallback if no frame gets composited, e.g. with a hardware cursor over a static scene
+        const float refreshRate = screens()->refreshRate(screens()->number(m_pos.toPoint()));
+        m_motionTimer->start(refreshRate > 0 ? qMax(1, qRound(1000.0f / refreshRate)) : 16);
+    }
+}
+
+void PointerInputRedirection::processRelativeMotion(const QPointF &delta, uint32_t time)
+{
+    processMotion((m_pendingMotion.valid ? m_pendingMotion.pos : m_pos) + delta, time);
+}
+
+void PointerInputRedirection::flushPendingMotion()
+{
+    if (!m_pendingMotion.valid) {
+        return;
+    }
+    m_pendingMotion.valid = false;
+    m_motionTimer->stop();
+    if (!m_inited) {
+        return;
+    }
+    deliverMotion(m_pendingMotion.pos, m_pendingMotion.time);
+}
+
+void PointerInputRedirection::deliverMotion(const QPointF &pos, uint32_t time)
+{
     updatePosition(pos);
     QMouseEvent event(QEvent::MouseMove, m_pos.toPoint(), m_pos.toPoint(),
                       Qt::NoButton, m_qtButtons, m_input->keyboardModifiers());
     event.setTimestamp(time);
 
-    const auto &filters = m_input->filters();
+    InputLatencyTracer::self()->mark(InputLatencyTracer::Filter);
+    const auto filters = m_input->activeFilters(InputEventFilter::PointerEvents);
     for (auto it = filters.begin(), end = filters.end(); it != end; it++) {
         if ((*it)->pointerEvent(&event, 0)) {
             return;
@@ -113,6 +187,8 @@ void PointerInputRedirection::processButton(uint32_t button, InputRedirection::P
     if (!m_inited) {
         return;
     }
+    // the button has to happen at the position of the preceding motion
+    flushPendingMotion();
     updateButton(button, state);
 
     QEvent::Type type;
@@ -132,7 +208,8 @@ void PointerInputRedirection::processButton(uint32_t button, InputRedirection::P
                       buttonToQtMouseButton(button), m_qtButtons, m_input->keyboardModifiers());
     event.setTimestamp(time);
 
-    const auto &filters = m_input->filters();
+    InputLatencyTracer::self()->mark(InputLatencyTracer::Filter);
+    const auto filters = m_input->activeFilters(InputEventFilter::PointerEvents);
     for (auto it = filters.begin(), end = filters.end(); it != end; it++) {
         if ((*it)->pointerEvent(&event, button)) {
             return;
@@ -148,6 +225,7 @@ void PointerInputRedirection::processAxis(InputRedirection::PointerAxis axis, qr
     if (delta == 0) {
         return;
     }
+    flushPendingMotion();
 
     emit m_input->pointerAxisChanged(axis, delta);
 
@@ -159,7 +237,8 @@ void PointerInputRedirection::processAxis(InputRedirection::PointerAxis axis, qr
                            m_input->keyboardModifiers());
     wheelEvent.setTimestamp(time);
 
-    const auto &filters = m_input->filters();
+    InputLatencyTracer::self()->mark(InputLatencyTracer::Filter);
+    const auto filters = m_input->activeFilters(InputEventFilter::WheelEvents);
     for (auto it = filters.begin(), end = filters.end(); it != end; it++) {
         if ((*it)->wheelEvent(&wheelEvent)) {
             return;
@@ -331,17 +410,9 @@ void PointerInputRedirection::updateDecoration(Toplevel *t)
 
 void PointerInputRedirection::updatePosition(const QPointF &pos)
 {
-    // verify that at least one screen contains the pointer position
     QPointF p = pos;
-    if (!screenContainsPos(p)) {
-        // allow either x or y to pass
-        p = QPointF(m_pos.x(), pos.y());
-        if (!screenContainsPos(p)) {
-            p = QPointF(pos.x(), m_pos.y());
-            if (!screenContainsPos(p)) {
-                return;
-            }
-        }
+    if (!confineToScreens(p, m_pos)) {
+        return;
     }
     m_pos = p;
     emit m_input->globalPointerChanged(m_pos);
@@ -371,7 +442,10 @@ void PointerInputRedirection::warp(const QPointF &pos)
 {
     if (supportsWarping()) {
         waylandServer()->backend()->warpPointer(pos);
-        processMotion(pos, waylandServer()->seat()->timestamp());
+        // a warp overrides any motion which has not been delivered yet
+        m_pendingMotion.valid = false;
+        m_motionTimer->stop();
+        deliverMotion(pos, waylandServer()->seat()->timestamp());
     }
 }
 
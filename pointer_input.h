@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QPointer>
 #include <QPointF>
 
+class QTimer;
 class QWindow;
 
 namespace KWin
@@ -75,6 +76,17 @@ public:
      * @internal
      */
     void processMotion(const QPointF &pos, uint32_t time);
+    /**
+     * Like processMotion, but relative to the latest position including pending coalesced motion.
+     * @internal
+     */
+    void processRelativeMotion(const QPointF &delta, uint32_t time);
+    /**
+     * Delivers motion which got coalesced since the last frame. Called before events which
+     * depend on the pointer position to preserve the event order.
+     * @internal
+     */
+    void flushPendingMotion();
     /**
      * @internal
      */
@@ -85,6 +97,7 @@ public:
     void processAxis(InputRedirection::PointerAxis axis, qreal delta, uint32_t time);
 
 private:
+    void deliverMotion(const QPointF &pos, uint32_t time);
     void updatePosition(const QPointF &pos);
     void updateButton(uint32_t button, InputRedirection::PointerButtonState state);
     void updateInternalWindow();
@@ -107,6 +120,15 @@ private:
     QPointer<QWindow> m_internalWindow;
     QMetaObject::Connection m_windowGeometryConnection;
     QMetaObject::Connection m_internalWindowConnection;
+    /**
+     * Motion accumulated while coalescing, delivered once per frame.
+     **/
+    struct {
+        QPointF pos;
+        uint32_t time = 0;
+        bool valid = false;
+    } m_pendingMotion;
+    QTimer *m_motionTimer = nullptr;
 };
 
 }
@@ -70,10 +70,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QQuickWindow>
 #include <QVector2D>
+#include <QtConcurrentMap>
 
 #include "client.h"
 #include "deleted.h"
 #include "effects.h"
+#include "lanczosfilter.h"
 #include "overlaywindow.h"
 #include "screens.h"
 #include "shadow.h"
@@ -87,6 +89,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace KWin
 {
 
+// below this number of windows handing the effect chain to the thread pool costs more than it saves
+static const int s_concurrentPrePaintThreshold = 4;
+
 //****************************************
 // Scene
 //****************************************
@@ -142,6 +147,19 @@ void Scene::paintScreen(int* mask, const QRegion &damage, const QRegion &repaint
     painted_region = region;
     repaint_region = repaint;
 
+    if (m_paintedScreen >= 0 && m_paintedScreen < m_screenStackingOrders.count()
+            && !(*mask & (PAINT_SCREEN_TRANSFORMED | PAINT_SCREEN_WITH_TRANSFORMED_WINDOWS))) {
+        // without transformations windows are painted at their geometry,
+        // so windows not touching this screen don't need to be processed
+        m_paintedStackingOrder = m_screenStackingOrders.at(m_paintedScreen);
+    } else {
+        m_paintedStackingOrder = stacking_order;
+    }
+    if (m_paintedScreen >= 0 && m_paintedScreen < m_overlayWindows.count()) {
+        // shown on an overlay plane, compositing it as well would paint it twice
+        m_paintedStackingOrder.removeOne(m_overlayWindows.at(m_paintedScreen));
+    }
+
     if (*mask & PAINT_SCREEN_BACKGROUND_FIRST) {
         paintBackground(region);
     }
@@ -149,9 +167,11 @@ void Scene::paintScreen(int* mask, const QRegion &damage, const QRegion &repaint
     ScreenPaintData data(projection);
     effects->paintScreen(*mask, region, data);
 
-    foreach (Window *w, stacking_order) {
+    foreach (Window *w, m_paintedStackingOrder) {
         effects->postPaintWindow(effectWindow(w));
     }
+    m_cullingStatistics.culled += stacking_order.count() - m_paintedStackingOrder.count();
+    m_paintedStackingOrder.clear();
 
     effects->postPaintScreen();
 
@@ -194,9 +214,11 @@ void Scene::idle()
 // the function that'll be eventually called by paintScreen() above
 void Scene::finalPaintScreen(int mask, QRegion region, ScreenPaintData& data)
 {
-    if (mask & (PAINT_SCREEN_TRANSFORMED | PAINT_SCREEN_WITH_TRANSFORMED_WINDOWS))
+    if (mask & (PAINT_SCREEN_TRANSFORMED | PAINT_SCREEN_WITH_TRANSFORMED_WINDOWS)) {
+        // an effect added transformations in paintScreen(), all windows need to be processed
+        m_paintedStackingOrder = stacking_order;
         paintGenericScreen(mask, data);
-    else
+    } else
         paintSimpleScreen(mask, region);
 }
 
@@ -214,6 +236,9 @@ void Scene::paintGenericScreen(int orig_mask, ScreenPaintData)
         // Reset the repaint_region.
         // This has to be done here because many effects schedule a repaint for
         // the next frame within Effects::prePaintWindow.
+        if (!topw->repaints().isEmpty()) {
+            windowRepainted(topw);
+        }
         topw->resetRepaints();
 
         WindowPrePaintData data;
@@ -233,6 +258,7 @@ void Scene::paintGenericScreen(int orig_mask, ScreenPaintData)
             continue;
         }
         phase2.append(Phase2Data(w, infiniteRegion(), data.clip, data.mask, data.quads));
+        w->setVisibleInFrame(true);
         // transformations require window pixmap
         w->suspendUnredirect(data.mask
                              & (PAINT_WINDOW_TRANSLUCENT | PAINT_SCREEN_TRANSFORMED | PAINT_WINDOW_TRANSFORMED));
@@ -257,12 +283,8 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
 
     QRegion dirtyArea = region;
     bool opaqueFullscreen(false);
-    for (int i = 0;  // do prePaintWindow bottom to top
-            i < stacking_order.count();
-            ++i) {
-        Window* w = stacking_order[ i ];
+    auto prepareWindow = [&](Window *w, WindowPrePaintData &data) {
         Toplevel* topw = w->window();
-        WindowPrePaintData data;
         data.mask = orig_mask | (w->isOpaque() ? PAINT_WINDOW_OPAQUE : PAINT_WINDOW_TRANSLUCENT);
         w->resetPaintingEnabled();
         data.paint = region;
@@ -271,6 +293,9 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
         // Reset the repaint_region.
         // This has to be done here because many effects schedule a repaint for
         // the next frame within Effects::prePaintWindow.
+        if (!topw->repaints().isEmpty()) {
+            windowRepainted(topw);
+        }
         topw->resetRepaints();
 
         // Clip out the decoration for opaque windows; the decoration is drawn in the second pass
@@ -300,8 +325,8 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
             data.clip = QRegion();
         }
         data.quads = w->buildQuads();
-        // preparation step
-        effects->prePaintWindow(effectWindow(w), data, time_diff);
+    };
+    auto scheduleWindow = [&](Window *w, const WindowPrePaintData &data) {
 #ifndef NDEBUG
         if (data.quads.isTransformed()) {
             qFatal("Pre-paint calls are not allowed to transform quads!");
@@ -309,7 +334,7 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
 #endif
         if (!w->isPaintingEnabled()) {
             w->suspendUnredirect(true);
-            continue;
+            return;
         }
         dirtyArea |= data.paint;
         // Schedule the window for painting
@@ -317,6 +342,42 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
                                                                     data.mask, data.quads)));
         // no transformations, but translucency requires window pixmap
         w->suspendUnredirect(data.mask & PAINT_WINDOW_TRANSLUCENT);
+    };
+
+    EffectsHandlerImpl *effectsImpl = static_cast<EffectsHandlerImpl*>(effects);
+    if (effectsImpl->isPrePaintWindowThreadSafe() && m_paintedStackingOrder.count() >= s_concurrentPrePaintThreshold) {
+        // all active effects only touch the passed in window, so the effect chain
+        // can run for all windows in parallel once the paint data is set up
+        struct PendingWindow {
+            Window *window;
+            EffectWindow *effect;
+            WindowPrePaintData data;
+        };
+        QVector<PendingWindow> pending;
+        pending.reserve(m_paintedStackingOrder.count());
+        for (Window *w : m_paintedStackingOrder) {
+            pending.append(PendingWindow{w, effectWindow(w), WindowPrePaintData()});
+            prepareWindow(w, pending.last().data);
+        }
+        const int time = time_diff;
+        QtConcurrent::blockingMap(pending, [effectsImpl, time](PendingWindow &p) {
+            effectsImpl->prePaintWindowConcurrent(p.effect, p.data, time);
+        });
+        m_concurrentPrePaintPasses++;
+        for (const PendingWindow &p : pending) {
+            scheduleWindow(p.window, p.data);
+        }
+    } else {
+        for (int i = 0;  // do prePaintWindow bottom to top
+                i < m_paintedStackingOrder.count();
+                ++i) {
+            Window* w = m_paintedStackingOrder[ i ];
+            WindowPrePaintData data;
+            prepareWindow(w, data);
+            // preparation step
+            effects->prePaintWindow(effectWindow(w), data, time_diff);
+            scheduleWindow(w, data);
+        }
     }
 
     // Save the part of the repaint region that's exclusively rendered to
@@ -349,6 +410,9 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
         // subtract the parts which will possibly been drawn as part of
         // a higher opaque window
         data->region -= allclips;
+        if (data->region.intersects(entry->first->window()->visibleRect())) {
+            entry->first->setVisibleInFrame(true);
+        }
 
         // Here we rely on WindowPrePaintData::setTranslucent() to remove
         // the clip if needed.
@@ -439,10 +503,14 @@ void Scene::windowGeometryShapeChanged(Toplevel *c)
         return;
     Window *w = m_windows[ c ];
     w->discardShape();
+    LanczosCache::invalidate(c->effectWindow());
 }
 
 void Scene::createStackingOrder(ToplevelList toplevels)
 {
+    for (Window *w : m_windows) {
+        w->setVisibleInFrame(false);
+    }
     // TODO: cache the stacking_order in case it has not changed
     foreach (Toplevel *c, toplevels) {
         assert(m_windows.contains(c));
@@ -453,6 +521,46 @@ void Scene::createStackingOrder(ToplevelList toplevels)
 void Scene::clearStackingOrder()
 {
     stacking_order.clear();
+    if (!m_screenStackingOrders.isEmpty()) {
+        m_lastCullingStatistics = m_cullingStatistics;
+        m_cullingStatistics = CullingStatistics();
+        m_screenStackingOrders.clear();
+    }
+    m_overlayWindows.clear();
+    m_paintedScreen = -1;
+}
+
+void Scene::createScreenStackingOrders()
+{
+    const int count = screens()->count();
+    m_screenStackingOrders.resize(count);
+    m_overlayWindows.fill(nullptr, count);
+    for (QVector< Window* > &order : m_screenStackingOrders) {
+        order.clear();
+        order.reserve(stacking_order.count());
+    }
+    for (Window *w : stacking_order) {
+        // the visible rect includes the shadow, i.e. everything an effect may paint without transformations
+        const QRect visibleRect = w->window()->visibleRect();
+        bool visible = false;
+        for (int i = 0; i < count; ++i) {
+            if (visibleRect.intersects(screens()->geometry(i))) {
+                m_screenStackingOrders[i].append(w);
+                visible = true;
+            }
+        }
+        if (!visible && count > 0) {
+            // process windows outside of all screens once per frame, so that their repaints get reset
+            m_screenStackingOrders[0].append(w);
+        }
+    }
+    m_cullingStatistics.screens = count;
+    m_cullingStatistics.windows = stacking_order.count();
+}
+
+void Scene::setPaintedScreen(int screen)
+{
+    m_paintedScreen = screen;
 }
 
 static Scene::Window *s_recursionCheck = NULL;
@@ -518,6 +626,9 @@ void Scene::paintWindowThumbnails(Scene::Window *w, QRegion region, qreal opacit
             continue;
         }
         EffectWindowImpl *thumb = it.value().data();
+        if (thumb->sceneWindow()) {
+            thumb->sceneWindow()->setVisibleInFrame(true);
+        }
         WindowPaintData thumbData(thumb, screenProjectionMatrix());
         thumbData.setOpacity(opacity);
         thumbData.setBrightness(brightness * item->brightness());
@@ -590,7 +701,7 @@ void Scene::paintDesktopThumbnails(Scene::Window *w)
         adjustClipRegion(item, clippingRegion);
         data += QPointF(x, y);
         const int desktopMask = PAINT_SCREEN_TRANSFORMED | PAINT_WINDOW_TRANSFORMED | PAINT_SCREEN_BACKGROUND_FIRST;
-        paintDesktop(item->desktop(), desktopMask, clippingRegion, data);
+        paintDesktopThumbnail(item->desktop(), desktopMask, clippingRegion, data, QRect(x, y, size.width(), size.height()));
         s_recursionCheck = NULL;
     }
 }
@@ -600,6 +711,17 @@ void Scene::paintDesktop(int desktop, int mask, const QRegion &region, ScreenPai
     static_cast<EffectsHandlerImpl*>(effects)->paintDesktop(desktop, mask, region, data);
 }
 
+void Scene::paintDesktopThumbnail(int desktop, int mask, const QRegion &region, ScreenPaintData &data, const QRect &rect)
+{
+    Q_UNUSED(rect)
+    paintDesktop(desktop, mask, region, data);
+}
+
+void Scene::windowRepainted(Toplevel *toplevel)
+{
+    Q_UNUSED(toplevel)
+}
+
 // the function that'll be eventually called by paintWindow() above
 void Scene::finalPaintWindow(EffectWindowImpl* w, int mask, QRegion region, WindowPaintData& data)
 {
@@ -652,6 +774,141 @@ void Scene::triggerFence()
 {
 }
 
+Toplevel *Scene::topmostClientBufferWindow() const
+{
+    // called before the screen gets painted, so the screen's stacking order has to be used
+    if (!waylandServer() || m_paintedScreen < 0 || m_paintedScreen >= m_screenStackingOrders.count()
+            || m_screenStackingOrders.at(m_paintedScreen).isEmpty()) {
+        return nullptr;
+    }
+    // any effect might transform or paint above the window
+    if (static_cast<EffectsHandlerImpl*>(effects)->hasActiveEffects()) {
+        return nullptr;
+    }
+    // windows which only partially overlap the screen are part of its stacking order as well,
+    // so nothing else can be painted above the topmost one
+    Toplevel *toplevel = m_screenStackingOrders.at(m_paintedScreen).last()->window();
+    if (toplevel->isDeleted() || toplevel->hasAlpha() || toplevel->opacity() != 1.0) {
+        return nullptr;
+    }
+    // no decoration or shadow and the client buffer is shown unscaled
+    if (toplevel->visibleRect() != toplevel->geometry()) {
+        return nullptr;
+    }
+    const auto surface = toplevel->surface();
+    if (!surface || !surface->childSubSurfaces().isEmpty()) {
+        return nullptr;
+    }
+    const auto buffer = surface->buffer();
+    if (!buffer || buffer->shmBuffer() || buffer->size() != toplevel->geometry().size()) {
+        return nullptr;
+    }
+    return toplevel;
+}
+
+Toplevel *Scene::directScanoutCandidate() const
+{
+    Toplevel *toplevel = topmostClientBufferWindow();
+    if (!toplevel || toplevel->geometry() != screens()->geometry(m_paintedScreen)) {
+        return nullptr;
+    }
+    return toplevel;
+}
+
+Toplevel *Scene::overlayCandidate() const
+{
+    Toplevel *toplevel = topmostClientBufferWindow();
+    if (!toplevel || !screens()->geometry(m_paintedScreen).contains(toplevel->geometry())) {
+        return nullptr;
+    }
+    return toplevel;
+}
+
+void Scene::overlayAssigned(Toplevel *toplevel)
+{
+    const QVector< Window* > &order = m_screenStackingOrders.at(m_paintedScreen);
+    auto it = std::find_if(order.constBegin(), order.constEnd(),
+        [toplevel] (Window *w) {
+            return w->window() == toplevel;
+        }
+    );
+    if (it == order.constEnd()) {
+        return;
+    }
+    if (!toplevel->repaints().isEmpty()) {
+        windowRepainted(toplevel);
+    }
+    toplevel->resetRepaints();
+    (*it)->setVisibleInFrame(true);
+    m_overlayWindows[m_paintedScreen] = *it;
+}
+
+void Scene::directScanoutPresented(Toplevel *toplevel)
+{
+    // the screen is not painted, but the windows on it must not keep their repaints
+    for (Window *w : m_screenStackingOrders.at(m_paintedScreen)) {
+        Toplevel *topw = w->window();
+        if (!topw->repaints().isEmpty()) {
+            windowRepainted(topw);
+        }
+        topw->resetRepaints();
+    }
+    if (Window *w = m_windows.value(toplevel)) {
+        w->setVisibleInFrame(true);
+    }
+}
+
+bool Scene::isWindowVisibleInLastFrame(Toplevel *toplevel) const
+{
+    const Window *w = m_windows.value(toplevel);
+    return w && w->isVisibleInFrame();
+}
+
+void Scene::prefetchWindows(const ToplevelList &toplevels)
+{
+    const bool contextCurrent = makeOpenGLContextCurrent();
+    int hits = 0;
+    int misses = 0;
+    for (Toplevel *toplevel : toplevels) {
+        Window *w = m_windows.value(toplevel);
+        if (!w) {
+            continue;
+        }
+        if (w->prefetch()) {
+            ++hits;
+        } else {
+            ++misses;
+        }
+    }
+    if (contextCurrent) {
+        doneOpenGLContextCurrent();
+    }
+    m_prefetchStatistics.hits += hits;
+    m_prefetchStatistics.misses += misses;
+    qCDebug(KWIN_CORE) << "Prefetched windows:" << hits << "with content," << misses << "without";
+}
+
+QString Scene::supportInformation() const
+{
+    QString support;
+    const PrefetchStatistics &prefetch = m_prefetchStatistics;
+    if (prefetch.hits + prefetch.misses > 0) {
+        support.append(QStringLiteral("Windows with content on desktop switches: %1 hits, %2 misses (%3%)\n")
+            .arg(prefetch.hits).arg(prefetch.misses)
+            .arg(100 * prefetch.hits / (prefetch.hits + prefetch.misses)));
+    }
+    if (m_concurrentPrePaintPasses > 0) {
+        support.append(QStringLiteral("Concurrent effect pre-paint passes: %1\n").arg(m_concurrentPrePaintPasses));
+    }
+    const CullingStatistics &stats = m_lastCullingStatistics;
+    if (stats.screens == 0) {
+        return support;
+    }
+    support.append(QStringLiteral("Per screen rendering in last frame: %1 screens, %2 windows, %3 window passes skipped\n")
+        .arg(stats.screens).arg(stats.windows).arg(stats.culled));
+    return support;
+}
+
 QMatrix4x4 Scene::screenProjectionMatrix() const
 {
     return QMatrix4x4();
@@ -669,6 +926,7 @@ Scene::Window::Window(Toplevel * c)
     , m_previousPixmap()
     , m_referencePixmapCounter(0)
     , disable_painting(0)
+    , m_visibleInFrame(false)
     , shape_valid(false)
     , cached_quad_list(NULL)
 {
@@ -698,6 +956,19 @@ void Scene::Window::unreferencePreviousPixmap()
     }
 }
 
+bool Scene::Window::prefetch()
+{
+    // a pixmap created now would not have any content yet, so none gets created
+    return !m_currentPixmap.isNull() && m_currentPixmap->isValid();
+}
+
+void Scene::Window::releasePixmaps()
+{
+    m_currentPixmap.reset();
+    m_previousPixmap.reset();
+    m_referencePixmapCounter = 0;
+}
+
 void Scene::Window::pixmapDiscarded()
 {
     if (!m_currentPixmap.isNull()) {
@@ -148,6 +148,29 @@ public:
 
     virtual Decoration::Renderer *createDecorationRenderer(Decoration::DecoratedClientImpl *) = 0;
 
+    /**
+     * @brief Scene specific information to be included in the support information.
+     *
+     * Used to report statistics about the rendering. The default implementation
+     * reports the windows skipped by per screen rendering.
+     **/
+    virtual QString supportInformation() const;
+
+    /**
+     * @returns whether any part of @p toplevel was visible in the last painted frame,
+     * i.e. not occluded by opaque windows, or got painted transformed or as thumbnail.
+     **/
+    bool isWindowVisibleInLastFrame(Toplevel *toplevel) const;
+
+    /**
+     * @brief Updates the window pixmaps and textures of @p toplevels ahead of painting them.
+     *
+     * Used when switching virtual desktops, so that the first frames of the switch do not have to
+     * update the content of all the windows which become visible. Windows which were not kept
+     * mapped have no current content and are reported as misses in the support information.
+     **/
+    void prefetchWindows(const ToplevelList &toplevels);
+
 public Q_SLOTS:
     // a window has been destroyed
     void windowDeleted(KWin::Deleted*);
@@ -159,6 +182,12 @@ protected:
     virtual Window *createWindow(Toplevel *toplevel) = 0;
     void createStackingOrder(ToplevelList toplevels);
     void clearStackingOrder();
+    // splits the stacking order into the windows which can be visible on each screen,
+    // used to skip windows of other screens in per screen rendering
+    void createScreenStackingOrders();
+    // restricts the following paintScreen() calls to the windows visible on the given screen,
+    // -1 processes all windows again
+    void setPaintedScreen(int screen);
     // shared implementation, starts painting the screen
     void paintScreen(int *mask, const QRegion &damage, const QRegion &repaint,
                      QRegion *updateRegion, QRegion *validRegion, const QMatrix4x4 &projection = QMatrix4x4());
@@ -182,6 +211,20 @@ protected:
     // the default is NOOP
     virtual void extendPaintRegion(QRegion &region, bool opaqueFullscreen);
     virtual void paintDesktop(int desktop, int mask, const QRegion &region, ScreenPaintData &data);
+    // paints a desktop thumbnail covering rect, the default implementation renders the desktop through paintDesktop()
+    virtual void paintDesktopThumbnail(int desktop, int mask, const QRegion &region, ScreenPaintData &data, const QRect &rect);
+    // called for each window which has repaints in the current frame, before they get reset
+    virtual void windowRepainted(Toplevel *toplevel);
+    // returns the window of the painted screen whose client buffer covers the complete screen
+    // and can be presented without compositing, @c null if the screen needs to be composited
+    Toplevel *directScanoutCandidate() const;
+    // to be called instead of paintScreen() after the client buffer of @p toplevel got presented directly
+    void directScanoutPresented(Toplevel *toplevel);
+    // returns the window of the painted screen whose client buffer can be shown on an overlay plane
+    Toplevel *overlayCandidate() const;
+    // excludes @p toplevel from the painted screen's following paintScreen() calls of this frame
+    // as its buffer is shown on an overlay plane
+    void overlayAssigned(Toplevel *toplevel);
     // compute time since the last repaint
     void updateTimeDiff();
     // saved data for 2nd pass of optimized screen painting
@@ -212,11 +255,36 @@ protected:
     int time_diff;
     QElapsedTimer last_time;
 private:
+    // the topmost window of the painted screen if it can be shown without compositing
+    Toplevel *topmostClientBufferWindow() const;
     void paintWindowThumbnails(Scene::Window *w, QRegion region, qreal opacity, qreal brightness, qreal saturation);
     void paintDesktopThumbnails(Scene::Window *w);
     QHash< Toplevel*, Window* > m_windows;
     // windows in their stacking order
     QVector< Window* > stacking_order;
+    // windows of stacking_order which can be visible on the respective screen
+    QVector< QVector< Window* > > m_screenStackingOrders;
+    // per screen the window shown on an overlay plane, left out of the screen's paintScreen()
+    QVector< Window* > m_overlayWindows;
+    // windows processed by the current paintScreen() call
+    QVector< Window* > m_paintedStackingOrder;
+    int m_paintedScreen = -1;
+    struct CullingStatistics {
+        int screens = 0;
+        int windows = 0;
+        // windows for which the effect chain and quad building got skipped
+        int culled = 0;
+    };
+    CullingStatistics m_cullingStatistics;
+    CullingStatistics m_lastCullingStatistics;
+    struct PrefetchStatistics {
+        // windows with current content when switching desktops
+        int hits = 0;
+        int misses = 0;
+    };
+    PrefetchStatistics m_prefetchStatistics;
+    // paintSimpleScreen() calls which ran the effects' prePaintWindow() concurrently
+    quint64 m_concurrentPrePaintPasses = 0;
 };
 
 // The base class for windows representations in composite backends
@@ -277,6 +345,23 @@ public:
     Shadow* shadow();
     void referencePreviousPixmap();
     void unreferencePreviousPixmap();
+    /**
+     * Releases the current and previous WindowPixmap. Used for Deleted windows
+     * which are no longer referenced by any effect and thus won't be painted again.
+     **/
+    void releasePixmaps();
+    // whether the window was visible in the frame painted last, see Scene::isWindowVisibleInLastFrame
+    bool isVisibleInFrame() const {
+        return m_visibleInFrame;
+    }
+    void setVisibleInFrame(bool visible) {
+        m_visibleInFrame = visible;
+    }
+    /**
+     * Creates the resources to paint the current content of the window, see Scene::prefetchWindows.
+     * @returns @c false if there was no current content, e.g. because the window had been unmapped
+     **/
+    virtual bool prefetch();
 protected:
     WindowQuadList makeQuads(WindowQuadType type, const QRegion& reg, const QPoint &textureOffset = QPoint(0, 0)) const;
     WindowQuadList makeDecorationQuads(const QRect *rects, const QRegion &region) const;
@@ -312,6 +397,7 @@ private:
     QScopedPointer<WindowPixmap> m_previousPixmap;
     int m_referencePixmapCounter;
     int disable_painting;
+    bool m_visibleInFrame;
     mutable QRegion shape_region;
     mutable bool shape_valid;
     mutable WindowQuadList* cached_quad_list;
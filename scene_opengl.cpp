@@ -47,6 +47,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "main.h"
 #include "overlaywindow.h"
 #include "screens.h"
+#include "virtualdesktops.h"
+#include "workspace.h"
 #include "decorations/decoratedclient.h"
 
 #include <array>
@@ -382,6 +384,25 @@ bool OpenGLBackend::perScreenRendering() const
     return false;
 }
 
+bool OpenGLBackend::directScanout(int screenId, Toplevel *toplevel)
+{
+    Q_UNUSED(screenId)
+    Q_UNUSED(toplevel)
+    return false;
+}
+
+bool OpenGLBackend::assignOverlay(int screenId, Toplevel *toplevel)
+{
+    Q_UNUSED(screenId)
+    Q_UNUSED(toplevel)
+    return false;
+}
+
+QString OpenGLBackend::supportInformation() const
+{
+    return QString();
+}
+
 /************************************************
  * SceneOpenGL
  ***********************************************/
@@ -448,6 +469,8 @@ SceneOpenGL::~SceneOpenGL()
     gs_debuggedScene = nullptr;
     SceneOpenGL::EffectFrame::cleanup();
     if (init_ok) {
+        makeOpenGLContextCurrent();
+        discardDesktopThumbnails();
         delete m_syncManager;
 
         // backend might be still needed for a different scene
@@ -713,8 +736,28 @@ qint64 SceneOpenGL::paint(QRegion damage, ToplevelList toplevels)
     if (m_backend->perScreenRendering()) {
         // trigger start render timer
         m_backend->prepareRenderingFrame();
+        createScreenStackingOrders();
         for (int i = 0; i < screens()->count(); ++i) {
             const QRect &geo = screens()->geometry(i);
+            setPaintedScreen(i);
+            if (Toplevel *candidate = directScanoutCandidate()) {
+                if (m_backend->directScanout(i, candidate)) {
+                    directScanoutPresented(candidate);
+                    m_overlayGeometries[i] = QRect();
+                    continue;
+                }
+            }
+            QRegion screenDamage = damage.intersected(geo);
+            Toplevel *overlay = overlayCandidate();
+            if (overlay && m_backend->assignOverlay(i, overlay)) {
+                overlayAssigned(overlay);
+                m_overlayGeometries[i] = overlay->geometry();
+            } else {
+                m_backend->assignOverlay(i, nullptr);
+                // the window shown on the overlay plane so far is missing in the scene's rendering
+                screenDamage |= m_overlayGeometries.value(i);
+                m_overlayGeometries[i] = QRect();
+            }
             QRegion update;
             QRegion valid;
             // prepare rendering makes context current on the output
@@ -728,7 +771,7 @@ qint64 SceneOpenGL::paint(QRegion damage, ToplevelList toplevels)
 
             int mask = 0;
             updateProjectionMatrix();
-            paintScreen(&mask, damage.intersected(geo), repaint, &update, &valid, projectionMatrix());   // call generic implementation
+            paintScreen(&mask, screenDamage, repaint, &update, &valid, projectionMatrix());   // call generic implementation
 
             GLVertexBuffer::streamingBuffer()->endOfFrame();
 
@@ -784,6 +827,7 @@ qint64 SceneOpenGL::paint(QRegion damage, ToplevelList toplevels)
 
     // do cleanup
     clearStackingOrder();
+    discardDesktopThumbnails(true);
     return m_backend->renderTime();
 }
 
@@ -936,6 +980,7 @@ void SceneOpenGL::screenGeometryChanged(const QSize &size)
     if (!viewportLimitsMatched(size))
         return;
     Scene::screenGeometryChanged(size);
+    discardDesktopThumbnails();
     glViewport(0,0, size.width(), size.height());
     m_backend->screenGeometryChanged(size);
     GLRenderTarget::setVirtualScreenSize(size);
@@ -951,6 +996,180 @@ void SceneOpenGL::paintDesktop(int desktop, int mask, const QRegion &region, Scr
     glDisable(GL_SCISSOR_TEST);
 }
 
+struct SceneOpenGL::DesktopThumbnail
+{
+    // the state of a window the thumbnail got rendered with
+    struct WindowState {
+        Toplevel *window;
+        QRect geometry;
+        qreal opacity;
+        bool operator==(const WindowState &other) const {
+            return window == other.window && geometry == other.geometry && opacity == other.opacity;
+        }
+    };
+    ~DesktopThumbnail() {
+        delete renderTarget;
+        delete texture;
+    }
+    GLTexture *texture = nullptr;
+    GLRenderTarget *renderTarget = nullptr;
+    QVector<WindowState> windows;
+    // whether a window on the desktop got repainted since the thumbnail got rendered
+    bool dirty = true;
+    QElapsedTimer lastUsed;
+};
+
+void SceneOpenGL::paintDesktopThumbnail(int desktop, int mask, const QRegion &region, ScreenPaintData &data, const QRect &rect)
+{
+    if (m_renderingDesktopThumbnail || !GLRenderTarget::supported() || rect.isEmpty() ||
+            desktop < 1 || desktop > int(VirtualDesktopManager::self()->count())) {
+        Scene::paintDesktopThumbnail(desktop, mask, region, data, rect);
+        return;
+    }
+    DesktopThumbnail *&thumbnail = m_desktopThumbnails[desktop];
+    if (!thumbnail) {
+        thumbnail = new DesktopThumbnail;
+    }
+    thumbnail->lastUsed.start();
+    if (!updateDesktopThumbnail(thumbnail, desktop, rect.size())) {
+        Scene::paintDesktopThumbnail(desktop, mask, region, data, rect);
+        return;
+    }
+
+    GLTexture *texture = thumbnail->texture;
+    texture->bind();
+    glEnable(GL_SCISSOR_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    ShaderBinder binder(ShaderTrait::MapTexture);
+    QMatrix4x4 mvp = projectionMatrix();
+    mvp.translate(rect.x(), rect.y());
+    binder.shader()->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
+    texture->render(region, rect, true);
+
+    glDisable(GL_BLEND);
+    glDisable(GL_SCISSOR_TEST);
+    texture->unbind();
+}
+
+bool SceneOpenGL::updateDesktopThumbnail(DesktopThumbnail *thumbnail, int desktop, const QSize &size)
+{
+    // the thumbnail is rendered at the size it gets painted at, thumbnails up to
+    // a quarter smaller share it
+    const QSize textureSize = size.boundedTo(screens()->size());
+    if (thumbnail->texture) {
+        const QSize currentSize = thumbnail->texture->size();
+        if (currentSize.width() < textureSize.width() || currentSize.height() < textureSize.height() ||
+                currentSize.width() > textureSize.width() * 5 / 4 || currentSize.height() > textureSize.height() * 5 / 4) {
+            delete thumbnail->renderTarget;
+            delete thumbnail->texture;
+            thumbnail->renderTarget = nullptr;
+            thumbnail->texture = nullptr;
+        }
+    }
+    if (!thumbnail->texture) {
+        thumbnail->texture = new GLTexture(GL_RGBA8, textureSize.width(), textureSize.height());
+        thumbnail->texture->setFilter(GL_LINEAR);
+        thumbnail->texture->setWrapMode(GL_CLAMP_TO_EDGE);
+        thumbnail->texture->setYInverted(false);
+        thumbnail->renderTarget = new GLRenderTarget(*thumbnail->texture);
+        thumbnail->dirty = true;
+    }
+    if (!thumbnail->renderTarget->valid()) {
+        return false;
+    }
+
+    // windows getting added, removed, moved or restacked don't necessarily repaint themselves
+    QVector<DesktopThumbnail::WindowState> windows;
+    windows.reserve(thumbnail->windows.count());
+    for (Toplevel *toplevel : Workspace::self()->xStackingOrder()) {
+        if (!toplevel->isOnDesktop(desktop)) {
+            continue;
+        }
+        if (AbstractClient *c = qobject_cast<AbstractClient*>(toplevel)) {
+            if (c->isMinimized()) {
+                continue;
+            }
+        }
+        windows.append(DesktopThumbnail::WindowState{toplevel, toplevel->visibleRect(), toplevel->opacity()});
+    }
+    if (windows != thumbnail->windows) {
+        thumbnail->windows = windows;
+        thumbnail->dirty = true;
+    }
+    if (!thumbnail->dirty) {
+        return true;
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    const bool scissor = glIsEnabled(GL_SCISSOR_TEST);
+    glDisable(GL_SCISSOR_TEST);
+    GLRenderTarget::pushRenderTarget(thumbnail->renderTarget);
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // the viewport of the render target scales the whole screen down to the texture
+    m_renderingDesktopThumbnail = true;
+    ScreenPaintData data;
+    const int mask = PAINT_SCREEN_TRANSFORMED | PAINT_WINDOW_TRANSFORMED | PAINT_SCREEN_BACKGROUND_FIRST;
+    KWin::Scene::paintDesktop(desktop, mask, infiniteRegion(), data);
+    m_renderingDesktopThumbnail = false;
+
+    GLRenderTarget::popRenderTarget();
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    if (scissor) {
+        glEnable(GL_SCISSOR_TEST);
+    }
+    thumbnail->dirty = false;
+    return true;
+}
+
+void SceneOpenGL::windowRepainted(Toplevel *toplevel)
+{
+    // content changes of panels are not worth rendering all desktops again, this also
+    // prevents the pager showing the thumbnails from invalidating them continuously
+    if (m_renderingDesktopThumbnail || toplevel->isDock()) {
+        return;
+    }
+    for (auto it = m_desktopThumbnails.constBegin(); it != m_desktopThumbnails.constEnd(); ++it) {
+        if (toplevel->isOnDesktop(it.key())) {
+            it.value()->dirty = true;
+        }
+    }
+}
+
+void SceneOpenGL::discardDesktopThumbnails(bool unusedOnly)
+{
+    for (auto it = m_desktopThumbnails.begin(); it != m_desktopThumbnails.end();) {
+        // thumbnails which have not been painted for 5 seconds are dropped
+        if (!unusedOnly || it.value()->lastUsed.hasExpired(5000)) {
+            delete it.value();
+            it = m_desktopThumbnails.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+QString SceneOpenGL::supportInformation() const
+{
+    QString support = Scene::supportInformation();
+    support.append(m_backend->supportInformation());
+    const GLVertexBuffer *streamingBuffer = GLVertexBuffer::streamingBuffer();
+    if (!streamingBuffer) {
+        return support;
+    }
+    const GLVertexBuffer::Statistics stats = streamingBuffer->statistics();
+    support.append(QStringLiteral("Streaming vertex buffer: %1, %2 bytes\n")
+        .arg(streamingBuffer->isPersistent() ? QStringLiteral("persistently mapped") : QStringLiteral("mapped per upload"))
+        .arg(stats.bufferSize));
+    support.append(QStringLiteral("Streaming vertex buffer uploads: %1 bytes, %2 fence waits, %3 wrap-arounds, %4 reallocations\n")
+        .arg(stats.uploadedBytes).arg(stats.fenceWaits).arg(stats.wrapArounds).arg(stats.reallocations));
+    return support;
+}
+
 bool SceneOpenGL::makeOpenGLContextCurrent()
 {
     return m_backend->makeCurrent();
@@ -1288,6 +1507,16 @@ bool SceneOpenGL::Window::bindTexture()
     return pixmap->bind();
 }
 
+bool SceneOpenGL::Window::prefetch()
+{
+    if (!Scene::Window::prefetch()) {
+        return false;
+    }
+    // uploads the damage accumulated while the window was on another desktop
+    bindTexture();
+    return true;
+}
+
 QMatrix4x4 SceneOpenGL::Window::transformation(int mask, const WindowPaintData &data) const
 {
     QMatrix4x4 matrix;
@@ -2412,6 +2641,14 @@ SceneOpenGLDecorationRenderer::SceneOpenGLDecorationRenderer(Decoration::Decorat
     , m_texture()
 {
     connect(this, &Renderer::renderScheduled, client->client(), static_cast<void (AbstractClient::*)(const QRect&)>(&AbstractClient::addRepaint));
+    // decoration repaints don't damage the window, the cached thumbnails need to be filtered again
+    connect(this, &Renderer::renderScheduled, client->client(),
+        [client] {
+            if (EffectWindowImpl *w = client->client()->effectWindow()) {
+                LanczosCache::invalidate(w);
+            }
+        }
+    );
 }
 
 SceneOpenGLDecorationRenderer::~SceneOpenGLDecorationRenderer() = default;
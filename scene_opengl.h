@@ -63,6 +63,7 @@ public:
     Decoration::Renderer *createDecorationRenderer(Decoration::DecoratedClientImpl *impl) override;
     virtual void triggerFence() override;
     virtual QMatrix4x4 projectionMatrix() const = 0;
+    QString supportInformation() const override;
 
     void insertWait();
 
@@ -95,6 +96,8 @@ protected:
     virtual void extendPaintRegion(QRegion &region, bool opaqueFullscreen);
     QMatrix4x4 transformation(int mask, const ScreenPaintData &data) const;
     virtual void paintDesktop(int desktop, int mask, const QRegion &region, ScreenPaintData &data);
+    void paintDesktopThumbnail(int desktop, int mask, const QRegion &region, ScreenPaintData &data, const QRect &rect) override;
+    void windowRepainted(Toplevel *toplevel) override;
 
     void handleGraphicsReset(GLenum status);
 
@@ -108,11 +111,19 @@ protected:
     bool init_ok;
 private:
     bool viewportLimitsMatched(const QSize &size) const;
+    struct DesktopThumbnail;
+    bool updateDesktopThumbnail(DesktopThumbnail *thumbnail, int desktop, const QSize &size);
+    void discardDesktopThumbnails(bool unusedOnly = false);
 private:
     bool m_debug;
     OpenGLBackend *m_backend;
     SyncManager *m_syncManager;
     SyncObject *m_currentFence;
+    // reduced resolution renderings of the virtual desktops used by desktop thumbnails
+    QHash<int, DesktopThumbnail*> m_desktopThumbnails;
+    bool m_renderingDesktopThumbnail = false;
+    // per screen geometry of the window shown on an overlay plane instead of being painted
+    QHash<int, QRect> m_overlayGeometries;
 };
 
 class SceneOpenGL2 : public SceneOpenGL
@@ -204,6 +215,7 @@ public:
     virtual void performPaint(int mask, QRegion region, WindowPaintData data) = 0;
     void endRenderWindow();
     bool bindTexture();
+    bool prefetch() override;
     void setScene(SceneOpenGL *scene) {
         m_scene = scene;
     }
@@ -416,6 +428,27 @@ public:
      **/
     virtual bool perScreenRendering() const;
     virtual QRegion prepareRenderingForScreen(int screenId);
+    /**
+     * @brief Tries to present the client buffer of @p toplevel on the screen @p screenId
+     * without compositing.
+     *
+     * Only used with per screen rendering. If the method returns @c true the rendering
+     * of the screen is skipped for the current frame. Default implementation returns @c false.
+     **/
+    virtual bool directScanout(int screenId, Toplevel *toplevel);
+    /**
+     * @brief Tries to show the client buffer of @p toplevel on an overlay plane of the screen
+     * @p screenId with the next presented frame, @c null removes the current assignment.
+     *
+     * If the method returns @c true the window is not painted by the scene.
+     * Default implementation returns @c false.
+     **/
+    virtual bool assignOverlay(int screenId, Toplevel *toplevel);
+    /**
+     * @brief Backend specific statistics to be included in the support information.
+     * Default implementation returns an empty string.
+     **/
+    virtual QString supportInformation() const;
     /**
      * @brief Compositor is going into idle mode, flushes any pending paints.
      **/
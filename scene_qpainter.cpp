@@ -154,6 +154,7 @@ qint64 SceneQPainter::paint(QRegion damage, ToplevelList toplevels)
             damage = screens()->geometry();
         }
         QRegion overallUpdate;
+        createScreenStackingOrders();
         for (int i = 0; i < screens()->count(); ++i) {
             const QRect geometry = screens()->geometry(i);
             QImage *buffer = m_backend->bufferForScreen(i);
@@ -165,6 +166,7 @@ qint64 SceneQPainter::paint(QRegion damage, ToplevelList toplevels)
             m_painter->setWindow(geometry);
 
             QRegion updateRegion, validRegion;
+            setPaintedScreen(i);
             paintScreen(&mask, damage.intersected(geometry), QRegion(), &updateRegion, &validRegion);
             overallUpdate = overallUpdate.united(updateRegion);
 
@@ -50,6 +50,68 @@ ScreenPaintData SceneXrender::screen_paint;
 #define DOUBLE_TO_FIXED(d) ((xcb_render_fixed_t) ((d) * 65536))
 #define FIXED_TO_DOUBLE(f) ((double) ((f) / 65536.0))
 
+static const xcb_render_transform_t s_identityTransform = {
+    DOUBLE_TO_FIXED(1), DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(0),
+    DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(1), DOUBLE_TO_FIXED(0),
+    DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(1)
+};
+
+//****************************************
+// XRenderPictureState
+//****************************************
+XRenderPictureState::XRenderPictureState()
+{
+    reset();
+}
+
+void XRenderPictureState::reset()
+{
+    // the defaults of a newly created picture
+    m_transform = s_identityTransform;
+    m_filter = Scene::ImageFilterFast;
+    m_repeat = XCB_RENDER_REPEAT_NONE;
+}
+
+bool XRenderPictureState::setTransform(xcb_render_picture_t picture, const xcb_render_transform_t &transform)
+{
+    if (memcmp(&m_transform, &transform, sizeof(xcb_render_transform_t)) == 0) {
+        return false;
+    }
+    m_transform = transform;
+    xcb_render_set_picture_transform(connection(), picture, transform);
+    return true;
+}
+
+bool XRenderPictureState::setFilter(xcb_render_picture_t picture, Scene::ImageFilterType filter)
+{
+    if (m_filter == filter) {
+        return false;
+    }
+    m_filter = filter;
+    QByteArray filterName;
+    switch (filter) {
+    case KWin::Scene::ImageFilterFast:
+        filterName = QByteArray("fast");
+        break;
+    case KWin::Scene::ImageFilterGood:
+        filterName = QByteArray("good");
+        break;
+    }
+    xcb_render_set_picture_filter(connection(), picture, filterName.length(), filterName.constData(), 0, NULL);
+    return true;
+}
+
+bool XRenderPictureState::setRepeat(xcb_render_picture_t picture, uint32_t repeat)
+{
+    if (m_repeat == repeat) {
+        return false;
+    }
+    m_repeat = repeat;
+    const uint32_t values[] = {repeat};
+    xcb_render_change_picture(connection(), picture, XCB_RENDER_CP_REPEAT, values);
+    return true;
+}
+
 
 //****************************************
 // XRenderBackend
@@ -245,6 +307,7 @@ qint64 SceneXrender::paint(QRegion damage, ToplevelList toplevels)
 {
     QElapsedTimer renderTimer;
     renderTimer.start();
+    m_frameStatistics = FrameStatistics();
 
     createStackingOrder(toplevels);
 
@@ -257,6 +320,7 @@ qint64 SceneXrender::paint(QRegion damage, ToplevelList toplevels)
     m_backend->present(mask, updateRegion);
     // do cleanup
     clearStackingOrder();
+    m_lastFrameStatistics = m_frameStatistics;
 
     return renderTimer.nsecsElapsed();
 }
@@ -302,30 +366,59 @@ Decoration::Renderer *SceneXrender::createDecorationRenderer(Decoration::Decorat
     return new SceneXRenderDecorationRenderer(client);
 }
 
+xcb_render_picture_t SceneXrender::alphaPicture(double opacity)
+{
+    // the blend pictures use an 8 bit alpha channel, so there are at most 256 of them
+    const quint16 alpha = qBound(0, qRound(opacity * 0xff), 0xff);
+    auto it = m_alphaPictures.find(alpha);
+    if (it == m_alphaPictures.end()) {
+        const xcb_render_color_t color = {0, 0, 0, uint16_t(alpha * 0x101)};
+        it = m_alphaPictures.insert(alpha, xRenderFill(color));
+        m_frameStatistics.fills++;
+    }
+    return it.value();
+}
+
+QString SceneXrender::supportInformation() const
+{
+    const FrameStatistics &stats = m_lastFrameStatistics;
+    return QStringLiteral("XRender requests in last frame: %1 composite, %2 fill, %3 picture attribute changes\n"
+                          "XRender window content cache in last frame: %4 hits, %5 misses\n")
+        .arg(stats.composites).arg(stats.fills).arg(stats.pictureChanges)
+        .arg(stats.cacheHits).arg(stats.cacheMisses);
+}
+
 //****************************************
 // SceneXrender::Window
 //****************************************
 
 XRenderPicture *SceneXrender::Window::s_tempPicture = 0;
 QRect SceneXrender::Window::temp_visibleRect;
+XRenderPictureState SceneXrender::Window::s_tempPictureState;
 
 SceneXrender::Window::Window(Toplevel* c, SceneXrender *scene)
     : Scene::Window(c)
     , m_scene(scene)
     , format(XRenderUtils::findPictFormat(c->visual()))
     , alpha_cached_opacity(0.0)
+    , m_contentSerial(0)
+    , m_lastPixmap(XCB_PIXMAP_NONE)
+    , m_cachedPicture(nullptr)
+    , m_cachedContentValid(false)
 {
 }
 
 SceneXrender::Window::~Window()
 {
     discardShape();
+    discardCachedPicture();
 }
 
 void SceneXrender::Window::cleanup()
 {
     delete s_tempPicture;
     s_tempPicture = NULL;
+    s_tempPictureState.reset();
 }
 
 // Maps window coordinates to screen coordinates
@@ -391,11 +484,35 @@ void SceneXrender::Window::prepareTempPixmap()
         xcb_pixmap_t pix = xcb_generate_id(connection());
         xcb_create_pixmap(connection(), 32, pix, rootWindow(), temp_visibleRect.width(), temp_visibleRect.height());
         s_tempPicture = new XRenderPicture(pix, 32);
+        s_tempPictureState.reset();
         xcb_free_pixmap(connection(), pix);
     }
     const xcb_render_color_t transparent = {0, 0, 0, 0};
     const xcb_rectangle_t rect = {0, 0, uint16_t(temp_visibleRect.width()), uint16_t(temp_visibleRect.height())};
     xcb_render_fill_rectangles(connection(), XCB_RENDER_PICT_OP_SRC, *s_tempPicture, transparent, 1, &rect);
+    m_scene->m_frameStatistics.fills++;
+}
+
+void SceneXrender::Window::prepareCachedPicture(const QSize &size)
+{
+    if (m_cachedPicture && m_cachedPictureSize == size) {
+        return;
+    }
+    discardCachedPicture();
+    xcb_pixmap_t pix = xcb_generate_id(connection());
+    xcb_create_pixmap(connection(), 32, pix, rootWindow(), size.width(), size.height());
+    m_cachedPicture = new XRenderPicture(pix, 32);
+    xcb_free_pixmap(connection(), pix);
+    m_cachedPictureSize = size;
+}
+
+void SceneXrender::Window::discardCachedPicture()
+{
+    delete m_cachedPicture;
+    m_cachedPicture = nullptr;
+    m_cachedPictureSize = QSize();
+    m_cachedPictureState.reset();
+    m_cachedContentValid = false;
 }
 
 // paint the window
@@ -425,7 +542,13 @@ void SceneXrender::Window::performPaint(int mask, QRegion region, WindowPaintDat
     xcb_render_picture_t pic = pixmap->picture();
     if (pic == XCB_RENDER_PICTURE_NONE)   // The render format can be null for GL and/or Xv visuals
         return;
+    if (!toplevel->damage().isEmpty() || pixmap->pixmap() != m_lastPixmap) {
+        // content changed since the last paint
+        m_contentSerial++;
+        m_lastPixmap = pixmap->pixmap();
+    }
     toplevel->resetDamage();
+    SceneXrender::FrameStatistics &stats = m_scene->m_frameStatistics;
     // set picture filter
     if (options->isXrenderSmoothScale()) { // only when forced, it's slow
         if (mask & PAINT_WINDOW_TRANSFORMED)
@@ -466,11 +589,6 @@ void SceneXrender::Window::performPaint(int mask, QRegion region, WindowPaintDat
         DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(1), DOUBLE_TO_FIXED(0),
         DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(1)
     };
-    static const xcb_render_transform_t identity = {
-        DOUBLE_TO_FIXED(1), DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(0),
-        DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(1), DOUBLE_TO_FIXED(0),
-        DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(1)
-    };
 
     if (mask & PAINT_WINDOW_TRANSFORMED) {
         xscale = data.xScale();
@@ -511,21 +629,43 @@ void SceneXrender::Window::performPaint(int mask, QRegion region, WindowPaintDat
     // it optimizes painting quite a bit
     const bool blitInTempPixmap = xRenderOffscreen() || (data.crossFadeProgress() < 1.0 && !opaque) ||
                                  (scaled && (wantShadow || (client && !client->noBorder()) || (deleted && !deleted->noBorder())));
+    // The unscaled content rendered into the temporary pixmap only changes with the window
+    // content, so while a window is scaled (e.g. Present Windows) it is kept in a per window
+    // picture and only the final scaled composite is performed each frame.
+    const bool useContentCache = blitInTempPixmap && !xRenderOffscreen() && !scene_xRenderOffscreenTarget() &&
+                                 data.crossFadeProgress() >= 1.0;
+    if (!useContentCache && m_cachedPicture) {
+        discardCachedPicture();
+    }
 
     xcb_render_picture_t renderTarget = m_scene->bufferPicture();
+    QRect blitRect;
+    XRenderPicture *blitPicture = s_tempPicture;
+    XRenderPictureState *blitPictureState = &s_tempPictureState;
+    XRenderPictureState &pictureState = pixmap->pictureState();
     if (blitInTempPixmap) {
         if (scene_xRenderOffscreenTarget()) {
-            temp_visibleRect = toplevel->visibleRect().translated(-toplevel->pos());
+            blitRect = toplevel->visibleRect().translated(-toplevel->pos());
             renderTarget = *scene_xRenderOffscreenTarget();
+        } else if (useContentCache) {
+            blitRect = toplevel->visibleRect().translated(-toplevel->pos());
+            prepareCachedPicture(blitRect.size());
+            blitPicture = m_cachedPicture;
+            blitPictureState = &m_cachedPictureState;
+            renderTarget = *m_cachedPicture;
         } else {
             prepareTempPixmap();
+            blitRect = temp_visibleRect;
+            blitPicture = s_tempPicture;
             renderTarget = *s_tempPicture;
         }
+        // the window picture is used unscaled
+        stats.pictureChanges += pictureState.setTransform(pic, s_identityTransform);
+        stats.pictureChanges += pictureState.setFilter(pic, ImageFilterFast);
+        stats.pictureChanges += pictureState.setRepeat(pic, XCB_RENDER_REPEAT_NONE);
     } else {
-        xcb_render_set_picture_transform(connection(), pic, xform);
-        if (filter == ImageFilterGood) {
-            setPictureFilter(pic, KWin::Scene::ImageFilterGood);
-        }
+        stats.pictureChanges += pictureState.setTransform(pic, xform);
+        stats.pictureChanges += pictureState.setFilter(pic, scaled ? filter : ImageFilterFast);
 
         //BEGIN OF STUPID RADEON HACK
         // This is needed to avoid hitting a fallback in the radeon driver.
@@ -538,14 +678,12 @@ void SceneXrender::Window::performPaint(int mask, QRegion region, WindowPaintDat
         // transformation matrix, and doesn't have an alpha channel.
         // Since we only scale the picture, we can work around this by setting
         // the repeat mode to RepeatPad.
-        if (!window()->hasAlpha()) {
-            const uint32_t values[] = {XCB_RENDER_REPEAT_PAD};
-            xcb_render_change_picture(connection(), pic, XCB_RENDER_CP_REPEAT, values);
-        }
+        const bool pad = scaled && !window()->hasAlpha();
+        stats.pictureChanges += pictureState.setRepeat(pic, pad ? XCB_RENDER_REPEAT_PAD : XCB_RENDER_REPEAT_NONE);
         //END OF STUPID RADEON HACK
     }
 #define MAP_RECT_TO_TARGET(_RECT_) \
-        if (blitInTempPixmap) _RECT_.translate(-temp_visibleRect.topLeft()); else _RECT_ = mapToScreen(mask, data, _RECT_)
+        if (blitInTempPixmap) _RECT_.translate(-blitRect.topLeft()); else _RECT_ = mapToScreen(mask, data, _RECT_)
 
     //BEGIN deco preparations
     bool noBorder = true;
@@ -607,7 +745,7 @@ void SceneXrender::Window::performPaint(int mask, QRegion region, WindowPaintDat
     //BEGIN client preparations
     QRect dr = cr;
     if (blitInTempPixmap) {
-        dr.translate(-temp_visibleRect.topLeft());
+        dr.translate(-blitRect.topLeft());
     } else {
         dr = mapToScreen(mask, data, dr); // Destination rect
         if (scaled) {
@@ -621,17 +759,41 @@ void SceneXrender::Window::performPaint(int mask, QRegion region, WindowPaintDat
 
 #undef MAP_RECT_TO_TARGET
 
+    bool contentCached = false;
+    if (useContentCache) {
+        ContentCacheKey key;
+        key.contentSerial = m_contentSerial;
+        key.decorationSerial = renderer ? renderer->serial() : 0;
+        key.shadow = wantShadow ? m_shadow : nullptr;
+        key.shadowRect = wantShadow ? m_shadow->shadowRegion().boundingRect() : QRect();
+        key.opacity = data.opacity();
+        key.brightness = data.brightness();
+        contentCached = m_cachedContentValid && m_cachedKey == key;
+        if (contentCached) {
+            stats.cacheHits++;
+        } else {
+            stats.cacheMisses++;
+            m_cachedKey = key;
+            m_cachedContentValid = true;
+            const xcb_render_color_t transparent = {0, 0, 0, 0};
+            const xcb_rectangle_t rect = {0, 0, uint16_t(blitRect.width()), uint16_t(blitRect.height())};
+            xcb_render_fill_rectangles(connection(), XCB_RENDER_PICT_OP_SRC, renderTarget, transparent, 1, &rect);
+            stats.fills++;
+        }
+    }
+
     for (PaintClipper::Iterator iterator; !iterator.isDone(); iterator.next()) {
 
 #define RENDER_SHADOW_TILE(_TILE_, _RECT_) \
 xcb_render_composite(connection(), XCB_RENDER_PICT_OP_OVER, m_xrenderShadow->picture(SceneXRenderShadow::ShadowElement##_TILE_), \
-                 shadowAlpha, renderTarget, 0, 0, 0, 0, _RECT_.x(), _RECT_.y(), _RECT_.width(), _RECT_.height())
+                 shadowAlpha, renderTarget, 0, 0, 0, 0, _RECT_.x(), _RECT_.y(), _RECT_.width(), _RECT_.height()); \
+stats.composites++
 
         //shadow
-        if (wantShadow) {
+        if (wantShadow && !contentCached) {
             xcb_render_picture_t shadowAlpha = XCB_RENDER_PICTURE_NONE;
             if (!opaque) {
-                shadowAlpha = xRenderBlendPicture(data.opacity());
+                shadowAlpha = m_scene->alphaPicture(data.opacity());
             }
             RENDER_SHADOW_TILE(TopLeft, stlr);
             RENDER_SHADOW_TILE(Top, str);
@@ -645,56 +807,53 @@ xcb_render_composite(connection(), XCB_RENDER_PICT_OP_OVER, m_xrenderShadow->pic
 #undef RENDER_SHADOW_TILE
 
         // Paint the window contents
-        if (!(client && client->isShade())) {
+        if (!(client && client->isShade()) && !contentCached) {
             xcb_render_picture_t clientAlpha = XCB_RENDER_PICTURE_NONE;
             if (!opaque) {
-                clientAlpha = xRenderBlendPicture(data.opacity());
+                clientAlpha = m_scene->alphaPicture(data.opacity());
             }
             xcb_render_composite(connection(), clientRenderOp, pic, clientAlpha, renderTarget,
                                  cr.x(), cr.y(), 0, 0, dr.x(), dr.y(), dr.width(), dr.height());
+            stats.composites++;
             if (data.crossFadeProgress() < 1.0 && data.crossFadeProgress() > 0.0) {
                 XRenderWindowPixmap *previous = previousWindowPixmap<XRenderWindowPixmap>();
                 if (previous && previous != pixmap) {
-                    static XRenderPicture cFadeAlpha(XCB_RENDER_PICTURE_NONE);
-                    static xcb_render_color_t cFadeColor = {0, 0, 0, 0};
-                    cFadeColor.alpha = uint16_t((1.0 - data.crossFadeProgress()) * 0xffff);
-                    if (cFadeAlpha == XCB_RENDER_PICTURE_NONE) {
-                        cFadeAlpha = xRenderFill(cFadeColor);
-                    } else {
-                        xcb_rectangle_t rect = {0, 0, 1, 1};
-                        xcb_render_fill_rectangles(connection(), XCB_RENDER_PICT_OP_SRC, cFadeAlpha, cFadeColor , 1, &rect);
-                    }
+                    const xcb_render_picture_t cFadeAlpha = m_scene->alphaPicture(1.0 - data.crossFadeProgress());
+                    XRenderPictureState &previousState = previous->pictureState();
                     if (previous->size() != pixmap->size()) {
                         xcb_render_transform_t xform2 = {
                             DOUBLE_TO_FIXED(FIXED_TO_DOUBLE(xform.matrix11) * previous->size().width() / pixmap->size().width()), DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(0),
                             DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(FIXED_TO_DOUBLE(xform.matrix22) * previous->size().height() / pixmap->size().height()), DOUBLE_TO_FIXED(0),
                             DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(0), DOUBLE_TO_FIXED(1)
                             };
-                        xcb_render_set_picture_transform(connection(), previous->picture(), xform2);
+                        stats.pictureChanges += previousState.setTransform(previous->picture(), xform2);
+                    } else {
+                        stats.pictureChanges += previousState.setTransform(previous->picture(), s_identityTransform);
                     }
+                    stats.pictureChanges += previousState.setFilter(previous->picture(), ImageFilterFast);
+                    stats.pictureChanges += previousState.setRepeat(previous->picture(), XCB_RENDER_REPEAT_NONE);
 
                     xcb_render_composite(connection(), opaque ? XCB_RENDER_PICT_OP_OVER : XCB_RENDER_PICT_OP_ATOP,
                                          previous->picture(), cFadeAlpha, renderTarget,
                                          cr.x(), cr.y(), 0, 0, dr.x(), dr.y(), dr.width(), dr.height());
-
-                    if (previous->size() != pixmap->size()) {
-                        xcb_render_set_picture_transform(connection(), previous->picture(), identity);
-                    }
+                    stats.composites++;
                 }
             }
-            if (!opaque)
-                transformed_shape = QRegion();
+        }
+        if (!(client && client->isShade()) && !opaque) {
+            transformed_shape = QRegion();
         }
 
-        if (client || deleted) {
+        if ((client || deleted) && !contentCached) {
             if (!noBorder) {
-                xcb_render_picture_t decorationAlpha = xRenderBlendPicture(data.opacity());
-                auto renderDeco = [decorationAlpha, renderTarget](xcb_render_picture_t deco, const QRect &rect) {
+                xcb_render_picture_t decorationAlpha = m_scene->alphaPicture(data.opacity());
+                auto renderDeco = [decorationAlpha, renderTarget, &stats](xcb_render_picture_t deco, const QRect &rect) {
                     if (deco == XCB_RENDER_PICTURE_NONE) {
                         return;
                     }
                     xcb_render_composite(connection(), XCB_RENDER_PICT_OP_OVER, deco, decorationAlpha, renderTarget,
                                          0, 0, 0, 0, rect.x(), rect.y(), rect.width(), rect.height());
+                    stats.composites++;
                 };
                 renderDeco(top, dtr);
                 renderDeco(left, dlr);
@@ -703,13 +862,13 @@ xcb_render_composite(connection(), XCB_RENDER_PICT_OP_OVER, m_xrenderShadow->pic
             }
         }
 
-        if (data.brightness() != 1.0) {
+        if (data.brightness() != 1.0 && !contentCached) {
             // fake brightness change by overlaying black
             const float alpha = (1 - data.brightness()) * data.opacity();
             xcb_rectangle_t rect;
             if (blitInTempPixmap) {
-                rect.x = -temp_visibleRect.left();
-                rect.y = -temp_visibleRect.top();
+                rect.x = -blitRect.left();
+                rect.y = -blitRect.top();
                 rect.width = width();
                 rect.height = height();
             } else {
@@ -721,44 +880,22 @@ xcb_render_composite(connection(), XCB_RENDER_PICT_OP_OVER, m_xrenderShadow->pic
             xcb_render_fill_rectangles(connection(), XCB_RENDER_PICT_OP_OVER, renderTarget,
                                        preMultiply(data.brightness() < 1.0 ? QColor(0,0,0,255*alpha) : QColor(255,255,255,-alpha*255)),
                                        1, &rect);
+            stats.fills++;
         }
         if (blitInTempPixmap) {
-            const QRect r = mapToScreen(mask, data, temp_visibleRect);
-            xcb_render_set_picture_transform(connection(), *s_tempPicture, xform);
-            setPictureFilter(*s_tempPicture, filter);
-            xcb_render_composite(connection(), XCB_RENDER_PICT_OP_OVER, *s_tempPicture,
+            const QRect r = mapToScreen(mask, data, blitRect);
+            stats.pictureChanges += blitPictureState->setTransform(*blitPicture, xform);
+            stats.pictureChanges += blitPictureState->setFilter(*blitPicture, filter);
+            xcb_render_composite(connection(), XCB_RENDER_PICT_OP_OVER, *blitPicture,
                                  XCB_RENDER_PICTURE_NONE, m_scene->bufferPicture(),
                                  0, 0, 0, 0, r.x(), r.y(), r.width(), r.height());
-            xcb_render_set_picture_transform(connection(), *s_tempPicture, identity);
-        }
-    }
-    if (scaled && !blitInTempPixmap) {
-        xcb_render_set_picture_transform(connection(), pic, identity);
-        if (filter == ImageFilterGood)
-            setPictureFilter(pic, KWin::Scene::ImageFilterFast);
-        if (!window()->hasAlpha()) {
-            const uint32_t values[] = {XCB_RENDER_REPEAT_NONE};
-            xcb_render_change_picture(connection(), pic, XCB_RENDER_CP_REPEAT, values);
+            stats.composites++;
         }
     }
     if (xRenderOffscreen())
         scene_setXRenderOffscreenTarget(*s_tempPicture);
 }
 
-void SceneXrender::Window::setPictureFilter(xcb_render_picture_t pic, Scene::ImageFilterType filter)
-{
-    QByteArray filterName;
-    switch (filter) {
-    case KWin::Scene::ImageFilterFast:
-        filterName = QByteArray("fast");
-        break;
-    case KWin::Scene::ImageFilterGood:
-        filterName = QByteArray("good");
-        break;
-    }
-    xcb_render_set_picture_filter(connection(), pic, filterName.length(), filterName.constData(), 0, NULL);
-}
-
 WindowPixmap* SceneXrender::Window::createWindowPixmap()
 {
     return new XRenderWindowPixmap(this, format);
@@ -1229,7 +1366,8 @@ void SceneXRenderDecorationRenderer::render()
     renderPart(top.intersected(geometry),    top.topLeft(),    int(DecorationPart::Top));
     renderPart(right.intersected(geometry),  right.topLeft(),  int(DecorationPart::Right));
     renderPart(bottom.intersected(geometry), bottom.topLeft(), int(DecorationPart::Bottom));
-    xcb_flush(c);
+    // no flush, the images get sent together with the rest of the frame's requests when it is presented
+    m_serial++;
 }
 
 void SceneXRenderDecorationRenderer::resizePixmaps()
@@ -27,6 +27,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #ifdef KWIN_HAVE_XRENDER_COMPOSITING
 
+#include <kwinxrenderutils.h>
+
 namespace KWin
 {
 
@@ -145,12 +147,49 @@ private:
     xcb_render_pictformat_t m_format;
 };
 
+/**
+ * @brief Remembers the transform, filter and repeat mode last set on an XRender picture.
+ *
+ * The attributes are only sent to the X server if the requested state differs from the
+ * current one. This removes the need to reset a picture after each composite operation.
+ **/
+class XRenderPictureState
+{
+public:
+    XRenderPictureState();
+    /**
+     * @returns @c true if a request had to be issued
+     **/
+    bool setTransform(xcb_render_picture_t picture, const xcb_render_transform_t &transform);
+    bool setFilter(xcb_render_picture_t picture, Scene::ImageFilterType filter);
+    bool setRepeat(xcb_render_picture_t picture, uint32_t repeat);
+    /**
+     * Forgets the tracked state, to be called when the picture gets recreated.
+     **/
+    void reset();
+
+private:
+    xcb_render_transform_t m_transform;
+    Scene::ImageFilterType m_filter;
+    uint32_t m_repeat;
+};
+
 class SceneXrender
     : public Scene
 {
     Q_OBJECT
 public:
     class EffectFrame;
+    /**
+     * @brief Counters for the XRender requests issued by the Scene while painting a frame.
+     **/
+    struct FrameStatistics {
+        int composites = 0;
+        int fills = 0;
+        int pictureChanges = 0;
+        int cacheHits = 0;
+        int cacheMisses = 0;
+    };
     virtual ~SceneXrender();
     virtual bool initFailed() const;
     virtual CompositingType compositingType() const {
@@ -168,6 +207,14 @@ public:
         return m_backend->usesOverlayWindow();
     }
     Decoration::Renderer *createDecorationRenderer(Decoration::DecoratedClientImpl *client);
+    QString supportInformation() const override;
+
+    /**
+     * @returns the request counters of the last painted frame
+     **/
+    const FrameStatistics &lastFrameStatistics() const {
+        return m_lastFrameStatistics;
+    }
 
     static SceneXrender *createScene(QObject *parent);
 protected:
@@ -177,9 +224,18 @@ protected:
     virtual void paintDesktop(int desktop, int mask, const QRegion &region, ScreenPaintData &data);
 private:
     explicit SceneXrender(XRenderBackend *backend, QObject *parent = nullptr);
+    /**
+     * Returns a 1x1 repeating picture with the given @p opacity. In contrast to
+     * xRenderBlendPicture the pictures are cached per alpha value, so no fill
+     * request is needed each time a window is painted translucent.
+     **/
+    xcb_render_picture_t alphaPicture(double opacity);
     static ScreenPaintData screen_paint;
     class Window;
     QScopedPointer<XRenderBackend> m_backend;
+    QHash<quint16, XRenderPicture> m_alphaPictures;
+    FrameStatistics m_frameStatistics;
+    FrameStatistics m_lastFrameStatistics;
 };
 
 class SceneXrender::Window
@@ -198,13 +254,40 @@ private:
     QRect mapToScreen(int mask, const WindowPaintData &data, const QRect &rect) const;
     QPoint mapToScreen(int mask, const WindowPaintData &data, const QPoint &point) const;
     void prepareTempPixmap();
-    void setPictureFilter(xcb_render_picture_t pic, ImageFilterType filter);
+    /**
+     * Ensures the per window content cache picture has the given @p size.
+     * Recreating the picture invalidates the cached content.
+     **/
+    void prepareCachedPicture(const QSize &size);
+    void discardCachedPicture();
+    /**
+     * Describes the content rendered into the cached picture: as long as the key
+     * does not change the unscaled window including decoration and shadow does not
+     * need to be rendered again and only the final scaled composite is required.
+     **/
+    struct ContentCacheKey {
+        quint64 contentSerial = 0;
+        quint64 decorationSerial = 0;
+        const Shadow *shadow = nullptr;
+        QRect shadowRect;
+        qreal opacity = 0.0;
+        qreal brightness = 0.0;
+        bool operator==(const ContentCacheKey &other) const;
+    };
     SceneXrender *m_scene;
     xcb_render_pictformat_t format;
     double alpha_cached_opacity;
     QRegion transformed_shape;
+    quint64 m_contentSerial;
+    xcb_pixmap_t m_lastPixmap;
+    XRenderPicture *m_cachedPicture;
+    QSize m_cachedPictureSize;
+    XRenderPictureState m_cachedPictureState;
+    ContentCacheKey m_cachedKey;
+    bool m_cachedContentValid;
     static QRect temp_visibleRect;
     static XRenderPicture *s_tempPicture;
+    static XRenderPictureState s_tempPictureState;
 };
 
 class XRenderWindowPixmap : public WindowPixmap
@@ -214,9 +297,11 @@ public:
     virtual ~XRenderWindowPixmap();
     xcb_render_picture_t picture() const;
     virtual void create();
+    XRenderPictureState &pictureState();
 private:
     xcb_render_picture_t m_picture;
     xcb_render_pictformat_t m_format;
+    XRenderPictureState m_pictureState;
 };
 
 class SceneXrender::EffectFrame
@@ -271,6 +356,23 @@ xcb_render_picture_t XRenderWindowPixmap::picture() const
     return m_picture;
 }
 
+inline
+XRenderPictureState &XRenderWindowPixmap::pictureState()
+{
+    return m_pictureState;
+}
+
+inline
+bool SceneXrender::Window::ContentCacheKey::operator==(const ContentCacheKey &other) const
+{
+    return contentSerial == other.contentSerial &&
+           decorationSerial == other.decorationSerial &&
+           shadow == other.shadow &&
+           shadowRect == other.shadowRect &&
+           opacity == other.opacity &&
+           brightness == other.brightness;
+}
+
 /**
  * @short XRender implementation of Shadow.
  *
@@ -327,9 +429,16 @@ public:
     void reparent(Deleted *deleted) override;
 
     xcb_render_picture_t picture(DecorationPart part) const;
+    /**
+     * Incremented each time the decoration pixmaps change.
+     **/
+    quint64 serial() const {
+        return m_serial;
+    }
 
 private:
     void resizePixmaps();
+    quint64 m_serial = 0;
     QSize m_sizes[int(DecorationPart::Count)];
     xcb_pixmap_t m_pixmaps[int(DecorationPart::Count)];
     xcb_gcontext_t m_gc;
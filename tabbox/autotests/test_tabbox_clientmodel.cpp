@@ -89,4 +89,53 @@ void TestTabBoxClientModel::testCreateClientListActiveClientNotInFocusChain()
     QCOMPARE(clientModel->rowCount(), 1);
 }
 
+void TestTabBoxClientModel::testCreateClientListIncremental()
+{
+    MockTabBoxHandler tabboxhandler;
+    tabboxhandler.setConfig(TabBox::TabBoxConfig());
+    TabBox::ClientModel *clientModel = new TabBox::ClientModel(&tabboxhandler);
+    QWeakPointer<TabBox::TabBoxClient> client1 = tabboxhandler.createMockWindow(QString("test"), 1);
+    QWeakPointer<TabBox::TabBoxClient> client2 = tabboxhandler.createMockWindow(QString("test2"), 2);
+    QWeakPointer<TabBox::TabBoxClient> client3 = tabboxhandler.createMockWindow(QString("test3"), 3);
+    clientModel->createClientList();
+    QCOMPARE(clientModel->clientList(), TabBox::TabBoxClientList() << client3 << client1 << client2);
+
+    QSignalSpy resetSpy(clientModel, SIGNAL(modelReset()));
+    QVERIFY(resetSpy.isValid());
+    QSignalSpy insertedSpy(clientModel, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QVERIFY(insertedSpy.isValid());
+    QSignalSpy movedSpy(clientModel, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)));
+    QVERIFY(movedSpy.isValid());
+    QSignalSpy removedSpy(clientModel, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+    QVERIFY(removedSpy.isValid());
+
+    // activating another window moves it to the top
+    tabboxhandler.setActiveClient(client2);
+    clientModel->createClientList();
+    QCOMPARE(clientModel->clientList(), TabBox::TabBoxClientList() << client2 << client3 << client1);
+    QCOMPARE(movedSpy.count(), 1);
+    QCOMPARE(movedSpy.first().at(1).toInt(), 2);
+    QCOMPARE(movedSpy.first().at(4).toInt(), 0);
+    QCOMPARE(insertedSpy.count(), 0);
+    QCOMPARE(removedSpy.count(), 0);
+
+    // closing a window removes its row
+    QSharedPointer<TabBox::TabBoxClient> clientOwner = client3.toStrongRef();
+    tabboxhandler.closeWindow(client3.data());
+    clientModel->createClientList();
+    QCOMPARE(clientModel->clientList(), TabBox::TabBoxClientList() << client2 << client1);
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(removedSpy.first().at(1).toInt(), 1);
+    QCOMPARE(removedSpy.first().at(2).toInt(), 1);
+
+    // a new window gets a row inserted
+    QWeakPointer<TabBox::TabBoxClient> client4 = tabboxhandler.createMockWindow(QString("test4"), 4);
+    clientModel->createClientList();
+    QCOMPARE(clientModel->clientList(), TabBox::TabBoxClientList() << client4 << client1 << client2);
+    QCOMPARE(insertedSpy.count(), 1);
+    QCOMPARE(insertedSpy.first().at(1).toInt(), 0);
+    QCOMPARE(clientModel->rowCount(), 3);
+    QCOMPARE(resetSpy.count(), 0);
+}
+
 QTEST_MAIN(TestTabBoxClientModel)
@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "tabboxhandler.h"
 // Qt
 #include <QIcon>
+#include <QSet>
 // TODO: remove with Qt 5, only for HTML escaping the caption
 #include <QTextDocument>
 #include <QTextStream>
@@ -169,7 +170,7 @@ void ClientModel::createClientList(int desktop, bool partialReset)
         }
     }
 
-    m_clientList.clear();
+    TabBoxClientList clientList;
     QList< QWeakPointer< TabBoxClient > > stickyClients;
 
     switch(tabBox->config().clientSwitchingMode()) {
@@ -185,7 +186,7 @@ void ClientModel::createClientList(int desktop, bool partialReset)
         do {
             QWeakPointer<TabBoxClient> add = tabBox->clientToAddToList(c, desktop);
             if (!add.isNull()) {
-                m_clientList += add;
+                clientList += add;
                 if (add.data()->isFirstInTabBox()) {
                     stickyClients << add;
                 }
@@ -204,10 +205,10 @@ void ClientModel::createClientList(int desktop, bool partialReset)
             QWeakPointer<TabBoxClient> add = tabBox->clientToAddToList(c, desktop);
             if (!add.isNull()) {
                 if (start == add.data()) {
-                    m_clientList.removeAll(add);
-                    m_clientList.prepend(add);
+                    clientList.removeAll(add);
+                    clientList.prepend(add);
                 } else
-                    m_clientList += add;
+                    clientList += add;
                 if (add.data()->isFirstInTabBox()) {
                     stickyClients << add;
                 }
@@ -225,15 +226,64 @@ void ClientModel::createClientList(int desktop, bool partialReset)
     }
     }
     foreach (const QWeakPointer< TabBoxClient > &c, stickyClients) {
-        m_clientList.removeAll(c);
-        m_clientList.prepend(c);
+        clientList.removeAll(c);
+        clientList.prepend(c);
     }
-    if (tabBox->config().showDesktopMode() == TabBoxConfig::ShowDesktopClient || m_clientList.isEmpty()) {
+    if (tabBox->config().showDesktopMode() == TabBoxConfig::ShowDesktopClient || clientList.isEmpty()) {
         QWeakPointer<TabBoxClient> desktopClient = tabBox->desktopClient();
         if (!desktopClient.isNull())
-            m_clientList.append(desktopClient);
+            clientList.append(desktopClient);
+    }
+    updateClientList(clientList);
+}
+
+void ClientModel::updateClientList(const TabBoxClientList &clientList)
+{
+    // Turn the current list into the new one with row level changes instead of a reset,
+    // so that views keep the delegates and thumbnails of the Clients which stay in the list.
+    QSet<TabBoxClient*> remaining;
+    remaining.reserve(clientList.size());
+    foreach (const QWeakPointer<TabBoxClient> &client, clientList) {
+        remaining.insert(client.data());
+    }
+    auto isRemaining = [this, &remaining](int row) {
+        TabBoxClient *client = m_clientList.at(row).data();
+        return client && remaining.contains(client);
+    };
+    for (int last = m_clientList.size() - 1; last >= 0; --last) {
+        if (isRemaining(last)) {
+            continue;
+        }
+        int first = last;
+        while (first > 0 && !isRemaining(first - 1)) {
+            --first;
+        }
+        beginRemoveRows(QModelIndex(), first, last);
+        m_clientList.erase(m_clientList.begin() + first, m_clientList.begin() + last + 1);
+        endRemoveRows();
+        last = first;
+    }
+
+    for (int row = 0; row < clientList.size(); ++row) {
+        const QWeakPointer<TabBoxClient> &client = clientList.at(row);
+        if (row < m_clientList.size() && m_clientList.at(row) == client) {
+            continue;
+        }
+        const int from = m_clientList.indexOf(client, row + 1);
+        if (from != -1) {
+            beginMoveRows(QModelIndex(), from, from, QModelIndex(), row);
+            m_clientList.move(from, row);
+            endMoveRows();
+        } else {
+            beginInsertRows(QModelIndex(), row, row);
+            m_clientList.insert(row, client);
+            endInsertRows();
+        }
+    }
+    // captions and desktops might have changed while the TabBox was hidden
+    if (!m_clientList.isEmpty()) {
+        emit dataChanged(index(0, 0), index(m_clientList.size() - 1, 0));
     }
-    reset();
 }
 
 void ClientModel::close(int i)
@@ -75,7 +75,8 @@ public:
 
     /**
     * Generates a new list of TabBoxClients based on the current config.
-    * Calling this method will reset the model. If partialReset is true
+    * The model is not reset, instead rows are inserted, moved and removed
+    * to match the new list, so that views can keep their delegates. If partialReset is true
     * the top of the list is kept as a starting point. If not the the
     * current active client is used as the starting point to generate the
     * list.
@@ -104,6 +105,10 @@ public Q_SLOTS:
     void activate(int index);
 
 private:
+    /**
+    * Updates m_clientList to @p clientList emitting the row change signals.
+    **/
+    void updateClientList(const TabBoxClientList &clientList);
     TabBoxClientList m_clientList;
 };
 
@@ -776,6 +776,10 @@ void TabBox::reconfigure()
 
     m_delayShow = config.readEntry<bool>("ShowDelay", true);
     m_delayShowTime = config.readEntry<int>("DelayTime", 90);
+    if (config.readEntry<bool>("PreloadSwitcher", true)) {
+        // compile and instantiate the layout once the event loop is idle instead of on first use
+        QTimer::singleShot(0, m_tabBox, &TabBoxHandler::preloadSwitcher);
+    }
 
     const QString defaultDesktopLayout = QStringLiteral("org.kde.breeze.desktop");
     m_desktopConfig.setLayoutName(config.readEntry("DesktopLayout", defaultDesktopLayout));
@@ -32,6 +32,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "switcheritem.h"
 #include "tabbox_logging.h"
 // Qt
+#include <QElapsedTimer>
 #include <QKeyEvent>
 #include <QModelIndex>
 #include <QStandardPaths>
@@ -93,6 +94,13 @@ public:
     bool isShown;
     TabBoxClient *lastRaisedClient, *lastRaisedClientSucc;
     Xcb::Atom m_highlightWindowsAtom;
+    QMetaObject::Connection m_firstFrameConnection;
+
+    /**
+    * Returns the main item of the layout for the current config,
+    * loading and instantiating it if it does not exist yet.
+    */
+    QObject *findOrCreateMainItem(bool desktopMode);
 
 private:
     QObject *createSwitcherItem(bool desktopMode);
@@ -135,17 +143,22 @@ QQuickWindow *TabBoxHandlerPrivate::window() const
 }
 
 #ifndef KWIN_UNIT_TEST
-SwitcherItem *TabBoxHandlerPrivate::switcherItem() const
+static SwitcherItem *findSwitcherItem(QObject *mainItem)
 {
-    if (!m_mainItem) {
+    if (!mainItem) {
         return nullptr;
     }
-    if (SwitcherItem *i = qobject_cast<SwitcherItem*>(m_mainItem)) {
+    if (SwitcherItem *i = qobject_cast<SwitcherItem*>(mainItem)) {
         return i;
-    } else if (QQuickWindow *w = qobject_cast<QQuickWindow*>(m_mainItem)) {
+    } else if (QQuickWindow *w = qobject_cast<QQuickWindow*>(mainItem)) {
         return w->contentItem()->findChild<SwitcherItem*>();
     }
-    return m_mainItem->findChild<SwitcherItem*>();
+    return mainItem->findChild<SwitcherItem*>();
+}
+
+SwitcherItem *TabBoxHandlerPrivate::switcherItem() const
+{
+    return findSwitcherItem(m_mainItem);
 }
 #endif
 
@@ -305,7 +318,7 @@ QObject *TabBoxHandlerPrivate::createSwitcherItem(bool desktopMode)
 }
 #endif
 
-void TabBoxHandlerPrivate::show()
+QObject *TabBoxHandlerPrivate::findOrCreateMainItem(bool desktopMode)
 {
 #ifndef KWIN_UNIT_TEST
     if (m_qmlContext.isNull()) {
@@ -315,37 +328,54 @@ void TabBoxHandlerPrivate::show()
     if (m_qmlComponent.isNull()) {
         m_qmlComponent.reset(new QQmlComponent(Scripting::self()->qmlEngine()));
     }
-    const bool desktopMode = (config.tabBoxMode() == TabBoxConfig::DesktopTabBox);
-    auto findMainItem = [this](const QMap<QString, QObject *> &tabBoxes) -> QObject* {
-        auto it = tabBoxes.constFind(config.layoutName());
-        if (it != tabBoxes.constEnd()) {
-            return it.value();
+    const QMap<QString, QObject *> &tabBoxes = desktopMode ? m_desktopTabBoxes : m_clientTabBoxes;
+    auto it = tabBoxes.constFind(config.layoutName());
+    if (it != tabBoxes.constEnd()) {
+        return it.value();
+    }
+    QObject *mainItem = createSwitcherItem(desktopMode);
+    if (SwitcherItem *item = findSwitcherItem(mainItem)) {
+        if (desktopMode) {
+            item->setModel(desktopModel());
+        } else {
+            item->setModel(clientModel());
         }
-        return nullptr;
-    };
-    m_mainItem = nullptr;
-    m_mainItem = desktopMode ? findMainItem(m_desktopTabBoxes) : findMainItem(m_clientTabBoxes);
+    }
+    return mainItem;
+#else
+    Q_UNUSED(desktopMode)
+    return nullptr;
+#endif
+}
+
+void TabBoxHandlerPrivate::show()
+{
+#ifndef KWIN_UNIT_TEST
+    QElapsedTimer showTimer;
+    showTimer.start();
+    const bool desktopMode = (config.tabBoxMode() == TabBoxConfig::DesktopTabBox);
+    const bool preloaded = (desktopMode ? m_desktopTabBoxes : m_clientTabBoxes).contains(config.layoutName());
+    m_mainItem = findOrCreateMainItem(desktopMode);
     if (!m_mainItem) {
-        m_mainItem = createSwitcherItem(desktopMode);
-        if (!m_mainItem) {
-            return;
-        }
+        return;
     }
     if (SwitcherItem *item = switcherItem()) {
-        if (!item->model()) {
-            QAbstractItemModel *model = nullptr;
-            if (desktopMode) {
-                model = desktopModel();
-            } else {
-                model = clientModel();
-            }
-            item->setModel(model);
-        }
         item->setAllDesktops(config.clientDesktopMode() == TabBoxConfig::AllDesktopsClients);
         item->setCurrentIndex(index.row());
         // everything is prepared, so let's make the whole thing visible
         item->setVisible(true);
     }
+    if (QQuickWindow *w = window()) {
+        // measure how long it takes till the switcher is on screen
+        QObject::disconnect(m_firstFrameConnection);
+        m_firstFrameConnection = QObject::connect(w, &QQuickWindow::frameSwapped, q,
+            [this, showTimer, preloaded] {
+                QObject::disconnect(m_firstFrameConnection);
+                qCDebug(KWIN_TABBOX) << "First frame of" << config.layoutName() << "after" << showTimer.elapsed()
+                                     << "ms, preloaded:" << preloaded;
+            }
+        );
+    }
 #endif
 }
 
@@ -394,6 +424,21 @@ void TabBoxHandler::show()
     }
 }
 
+void TabBoxHandler::preloadSwitcher()
+{
+#ifndef KWIN_UNIT_TEST
+    if (d->isShown || !d->config.isShowTabBox() || !Scripting::self()) {
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    const bool desktopMode = (d->config.tabBoxMode() == TabBoxConfig::DesktopTabBox);
+    if (d->findOrCreateMainItem(desktopMode)) {
+        qCDebug(KWIN_TABBOX) << "Preloaded" << d->config.layoutName() << "in" << timer.elapsed() << "ms";
+    }
+#endif
+}
+
 void TabBoxHandler::initHighlightWindows()
 {
     if (isKWinCompositing()) {
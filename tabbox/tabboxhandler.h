@@ -244,6 +244,13 @@ public:
     * @see show
     */
     void hide(bool abort = false);
+    /**
+    * Loads and instantiates the layout of the current config without showing it,
+    * so that a later show() does not need to compile the QML first.
+    * Does nothing if the TabBox is shown or the config does not show a TabBox.
+    * @see show
+    */
+    void preloadSwitcher();
 
     /**
     * Sets the current model index in the view and updates
@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "client.h"
 #include "client_machine.h"
 #include "effects.h"
+#include "lanczosfilter.h"
 #include "screens.h"
 #include "shadow.h"
 #include "xcbutils.h"
@@ -53,6 +54,9 @@ Toplevel::Toplevel()
     , unredirect(false)
     , unredirectSuspend(false)
     , m_damageReplyPending(false)
+    , m_damageFromEvents(false)
+    , m_damageEventsOverflow(false)
+    , m_damageEventCount(0)
     , m_screen(0)
     , m_skipCloseAnimation(false)
 {
@@ -321,6 +325,10 @@ void Toplevel::getShadow()
         dirtyRect |= shadow()->shadowRegion().boundingRect();
     if (oldVisibleRect != visibleRect())
         emit paddingChanged(this, oldVisibleRect);
+    if (effectWindow()) {
+        // the shadow is part of the cached thumbnails, but changing it does not damage the window
+        LanczosCache::invalidate(effectWindow());
+    }
     if (dirtyRect.isValid()) {
         dirtyRect.translate(pos());
         addLayerRepaint(dirtyRect);
@@ -365,6 +365,17 @@ public:
      * Call damage() to return the fetched region.
      */
     void getDamageRegionReply();
+    /**
+     * Whether resetAndFetchDamage() issued a region fetch which still needs a reply.
+     **/
+    bool isDamageReplyPending() const {
+        return m_damageReplyPending;
+    }
+    /**
+     * Handles a DamageNotify event for this window. If the damage is tracked from the
+     * event rectangles the area is accumulated before invoking damageNotifyEvent().
+     **/
+    void processDamageNotifyEvent(xcb_damage_notify_event_t *e);
 
     bool skipsCloseAnimation() const;
     void setSkipCloseAnimation(bool set);
@@ -456,6 +467,7 @@ protected Q_SLOTS:
     void setReadyForPainting();
 
 protected:
+    friend class CompositingConnection;
     virtual ~Toplevel();
     void setWindowHandles(xcb_window_t client);
     void detectShape(Window id);
@@ -517,6 +529,11 @@ private:
     bool unredirect;
     bool unredirectSuspend; // when unredirected, but pixmap is needed temporarily
     bool m_damageReplyPending;
+    // damage tracked from the DamageNotify rectangles, see Compositor::usesDamageEvents()
+    bool m_damageFromEvents;
+    bool m_damageEventsOverflow;
+    int m_damageEventCount;
+    QRegion m_damageEventsRegion;
     QRegion opaque_region;
     xcb_xfixes_fetch_region_cookie_t m_regionCookie;
     int m_screen;
@@ -43,6 +43,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "outline.h"
 #include "placement.h"
 #include "rules.h"
+#include "scene.h"
 #include "screenedge.h"
 #include "screens.h"
 #include "scripting/scripting.h"
@@ -877,11 +878,14 @@ void Workspace::slotCurrentDesktopChanged(uint oldDesktop, uint newDesktop)
     --block_focus;
 
     activateClientOnNewDesktop(newDesktop);
+    // before the effects start to animate the switch
+    prefetchDesktopWindows(newDesktop);
     emit currentDesktopChanged(oldDesktop, movingClient);
 }
 
 void Workspace::updateClientVisibilityOnDesktopChange(uint oldDesktop, uint newDesktop)
 {
+    updateResidentDesktops(oldDesktop, newDesktop);
     ObscuringWindows obs_wins;
     for (ToplevelList::ConstIterator it = stacking_order.constBegin();
             it != stacking_order.constEnd();
@@ -915,6 +919,61 @@ void Workspace::updateClientVisibilityOnDesktopChange(uint oldDesktop, uint newD
         setShowingDesktop(false);
 }
 
+bool Workspace::isDesktopResident(int desktop) const
+{
+    return desktop > 0 && m_residentDesktops.contains(uint(desktop));
+}
+
+void Workspace::updateResidentDesktops(uint oldDesktop, uint currentDesktop)
+{
+    // the desktop left has been used before the switch even if it never got switched to,
+    // like the initial desktop, so that switching back to it hits
+    if (oldDesktop != 0) {
+        m_recentDesktops.removeAll(oldDesktop);
+        m_recentDesktops.prepend(oldDesktop);
+    }
+    m_recentDesktops.removeAll(currentDesktop);
+    m_recentDesktops.prepend(currentDesktop);
+    m_residentDesktops.clear();
+    if (options->hiddenPreviews() != HiddenPreviewsRecentDesktops) {
+        return;
+    }
+    // keep the most recently used desktops as long as their window pixmaps fit into the budget
+    const qint64 budget = qint64(options->hiddenPreviewsBudget()) * 1024 * 1024;
+    qint64 used = 0;
+    for (uint desktop : m_recentDesktops) {
+        if (desktop == currentDesktop || desktop > VirtualDesktopManager::self()->count()) {
+            continue;
+        }
+        qint64 size = 0;
+        for (Client *c : clients) {
+            if (c->desktop() == int(desktop) && !c->isMinimized()) {
+                size += qint64(c->width()) * c->height() * 4;
+            }
+        }
+        if (used + size > budget) {
+            break;
+        }
+        used += size;
+        m_residentDesktops << desktop;
+    }
+}
+
+void Workspace::prefetchDesktopWindows(uint desktop)
+{
+    if (!compositing() || !Compositor::self()->scene()) {
+        return;
+    }
+    ToplevelList toplevels;
+    for (Toplevel *t : stacking_order) {
+        AbstractClient *c = qobject_cast<AbstractClient*>(t);
+        if (c && c->isOnDesktop(desktop) && c->isShown(false)) {
+            toplevels << c;
+        }
+    }
+    Compositor::self()->scene()->prefetchWindows(toplevels);
+}
+
 void Workspace::activateClientOnNewDesktop(uint desktop)
 {
     AbstractClient* c = NULL;
@@ -1572,6 +1631,8 @@ QString Workspace::supportInformation() const
         default:
             support.append(QStringLiteral("Something is really broken, neither OpenGL nor XRender is used"));
         }
+        support.append(m_compositor->scene()->supportInformation());
+        support.append(m_compositor->supportInformation());
         support.append(QStringLiteral("\nLoaded Effects:\n"));
         support.append(QStringLiteral(  "---------------\n"));
         foreach (const QString &effect, static_cast<EffectsHandlerImpl*>(effects)->loadedEffects()) {
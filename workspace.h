@@ -291,6 +291,12 @@ public:
     void setShowingDesktop(bool showing);
     bool showingDesktop() const;
 
+    /**
+     * Whether the windows of the inactive virtual @p desktop are kept mapped
+     * with HiddenPreviewsRecentDesktops.
+     **/
+    bool isDesktopResident(int desktop) const;
+
     void sendPingToWindow(xcb_window_t w, xcb_timestamp_t timestamp);   // Called from Client::pingWindow()
 
     void removeClient(Client*);   // Only called from Client::destroyClient() or Client::releaseWindow()
@@ -469,6 +475,11 @@ Q_SIGNALS:
     void configChanged();
     void reinitializeCompositing();
     void showingDesktopChanged(bool showing);
+    /**
+     * Emitted when a window starts or ends to be interactively moved or resized.
+     * @see getMovingClient
+     **/
+    void movingClientChanged();
     /**
      * This signels is emitted when ever the stacking order is change, ie. a window is risen
      * or lowered
@@ -513,6 +524,8 @@ private:
     void updateClientArea(bool force);
     void resetClientAreas(uint desktopCount);
     void updateClientVisibilityOnDesktopChange(uint oldDesktop, uint newDesktop);
+    void updateResidentDesktops(uint oldDesktop, uint currentDesktop);
+    void prefetchDesktopWindows(uint desktop);
     void activateClientOnNewDesktop(uint desktop);
     AbstractClient *findClientToActivateOnDesktop(uint desktop);
 
@@ -553,6 +566,9 @@ private:
     QList<AbstractClient*> attention_chain;
 
     bool showing_desktop;
+    // most recently used virtual desktop first
+    QList<uint> m_recentDesktops;
+    QList<uint> m_residentDesktops;
 
     GroupList groups;
 